@@ -0,0 +1,249 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * Local load generator for the FastCGI server mode, built with
+ * -DWITH_BENCHMARKS=ON as bench_fcgi, it reports the requests per
+ * second of a script served through a unix socket :
+ *
+ *   hybris --fcgi /tmp/hybris.sock [--prefork=N] bench/fcgi.hy &
+ *   bench_fcgi fcgi /tmp/hybris.sock bench/fcgi.hy [requests] [clients]
+ *
+ * and of the same script executed by a new process for each request :
+ *
+ *   bench_fcgi cgi /usr/bin/hybris bench/fcgi.hy [requests] [clients]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+
+using std::string;
+
+#define FCGI_VERSION_1	   1
+#define FCGI_HEADER_LEN	   8
+#define FCGI_BEGIN_REQUEST 1
+#define FCGI_END_REQUEST   3
+#define FCGI_PARAMS		   4
+#define FCGI_STDIN		   5
+#define FCGI_STDOUT		   6
+#define FCGI_RESPONDER	   1
+#define FCGI_KEEP_CONN	   1
+
+static double bench_now(){
+	struct timeval tv;
+
+	gettimeofday( &tv, NULL );
+
+	return tv.tv_sec + tv.tv_usec * 0.000001;
+}
+
+static bool bench_write( int fd, const string& data ){
+	size_t  done = 0;
+	ssize_t n;
+
+	while( done < data.size() ){
+		if( (n = write( fd, data.data() + done, data.size() - done )) <= 0 ){
+			return false;
+		}
+		done += n;
+	}
+	return true;
+}
+
+static bool bench_read( int fd, unsigned char *buffer, size_t size ){
+	size_t  done = 0;
+	ssize_t n;
+
+	while( done < size ){
+		if( (n = read( fd, buffer + done, size - done )) <= 0 ){
+			return false;
+		}
+		done += n;
+	}
+	return true;
+}
+
+static void bench_record( string& out, int type, const string& content ){
+	unsigned char header[FCGI_HEADER_LEN] = { FCGI_VERSION_1, (unsigned char)type, 0, 1,
+											  (unsigned char)(content.size() >> 8), (unsigned char)content.size(), 0, 0 };
+
+	out.append( (char *)header, FCGI_HEADER_LEN );
+	out.append( content );
+}
+
+static void bench_length( string& out, size_t length ){
+	if( length < 128 ){
+		out += (char)length;
+	}
+	else{
+		out += (char)((length >> 24) | 0x80);
+		out += (char)(length >> 16);
+		out += (char)(length >> 8);
+		out += (char)length;
+	}
+}
+
+static void bench_pair( string& out, const string& name, const string& value ){
+	bench_length( out, name.size() );
+	bench_length( out, value.size() );
+	out += name;
+	out += value;
+}
+/*
+ * The records of a GET request keeping the connection open, they're
+ * the same for every request, so they're built once.
+ */
+static string bench_request( const char *script ){
+	string request, params;
+	char   begin[8] = { 0, FCGI_RESPONDER, FCGI_KEEP_CONN, 0, 0, 0, 0, 0 };
+
+	bench_pair( params, "SCRIPT_FILENAME", script );
+	bench_pair( params, "REQUEST_METHOD", "GET" );
+	bench_pair( params, "QUERY_STRING", "name=bench" );
+	bench_pair( params, "SERVER_PROTOCOL", "HTTP/1.1" );
+
+	bench_record( request, FCGI_BEGIN_REQUEST, string( begin, sizeof(begin) ) );
+	bench_record( request, FCGI_PARAMS, params );
+	bench_record( request, FCGI_PARAMS, "" );
+	bench_record( request, FCGI_STDIN, "" );
+
+	return request;
+}
+/*
+ * Send 'requests' requests over a single connection, return how many
+ * of them got some output and were completed.
+ */
+static int bench_fcgi_client( const char *path, const string& request, int requests ){
+	struct sockaddr_un address;
+	unsigned char 	   header[FCGI_HEADER_LEN],
+					   content[0xFFFF + 0xFF];
+	int				   fd, i, type, length, done = 0;
+	bool			   output;
+
+	memset( &address, 0, sizeof(address) );
+	address.sun_family = AF_UNIX;
+	strncpy( address.sun_path, path, sizeof(address.sun_path) - 1 );
+
+	if( (fd = socket( AF_UNIX, SOCK_STREAM, 0 )) < 0 || connect( fd, (struct sockaddr *)&address, sizeof(address) ) != 0 ){
+		perror( path );
+		return 0;
+	}
+
+	for( i = 0; i < requests && bench_write( fd, request ); ++i ){
+		output = false;
+		type   = 0;
+		while( bench_read( fd, header, FCGI_HEADER_LEN ) ){
+			type   = header[1];
+			length = (header[4] << 8) | header[5];
+			if( bench_read( fd, content, length + header[6] ) == false ){
+				break;
+			}
+			output |= (type == FCGI_STDOUT && length > 0);
+			if( type == FCGI_END_REQUEST ){
+				done += output;
+				break;
+			}
+		}
+		if( type != FCGI_END_REQUEST ){
+			break;
+		}
+	}
+
+	close(fd);
+
+	return done;
+}
+/*
+ * Execute 'requests' times the script with the interpreter in CGI mode,
+ * return how many of them exited successfully.
+ */
+static int bench_cgi_client( const char *hybris, const char *script, int requests ){
+	int   i, status, null, done = 0;
+	pid_t pid;
+
+	for( i = 0; i < requests; ++i ){
+		if( (pid = fork()) == 0 ){
+			null = open( "/dev/null", O_WRONLY );
+			dup2( null, STDOUT_FILENO );
+			setenv( "SCRIPT_FILENAME", script, 1 );
+			setenv( "REQUEST_METHOD", "GET", 1 );
+			setenv( "QUERY_STRING", "name=bench", 1 );
+			setenv( "SERVER_PROTOCOL", "HTTP/1.1", 1 );
+			execl( hybris, hybris, "--cgi", script, (char *)NULL );
+			_exit(127);
+		}
+		else if( pid > 0 && waitpid( pid, &status, 0 ) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0 ){
+			++done;
+		}
+	}
+
+	return done;
+}
+
+int main( int argc, char *argv[] ){
+	int    requests, clients, i, status, done = 0, per_client;
+	bool   cgi;
+	double start, elapsed;
+	string request;
+	int    pipes[2];
+
+	if( argc < 4 || (strcmp( argv[1], "fcgi" ) && strcmp( argv[1], "cgi" )) ){
+		fprintf( stderr, "usage : %s fcgi <socket> <script> [requests] [clients]\n"
+						 "        %s cgi <hybris> <script> [requests] [clients]\n", argv[0], argv[0] );
+		return 1;
+	}
+
+	cgi 	   = (strcmp( argv[1], "cgi" ) == 0);
+	requests   = (argc > 4 ? atoi(argv[4]) : 10000);
+	clients    = (argc > 5 ? atoi(argv[5]) : 1);
+	per_client = requests / clients;
+	request    = bench_request( argv[3] );
+	/*
+	 * Each client is a process reporting how many requests succeeded.
+	 */
+	pipe(pipes);
+	start = bench_now();
+	for( i = 0; i < clients; ++i ){
+		if( fork() == 0 ){
+			int ok = (cgi ? bench_cgi_client( argv[2], argv[3], per_client ) : bench_fcgi_client( argv[2], request, per_client ));
+
+			write( pipes[1], &ok, sizeof(ok) );
+			_exit(0);
+		}
+	}
+	for( i = 0; i < clients; ++i ){
+		int ok = 0;
+
+		read( pipes[0], &ok, sizeof(ok) );
+		done += ok;
+	}
+	while( wait(&status) > 0 );
+	elapsed = bench_now() - start;
+
+	printf( "%s : %d/%d requests in %.3fs with %d clients, %.1f requests/s\n",
+			argv[1], done, per_client * clients, elapsed, clients, done / elapsed );
+
+	return (done == per_client * clients ? 0 : 1);
+}
@@ -0,0 +1,251 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * Microbenchmark of the ITree hash index against the ascii tree it
+ * replaced, built with -DWITH_BENCHMARKS=ON as bench_itree.
+ *
+ * usage : bench_itree [rounds]
+ */
+#include "itree.h"
+#include <stdio.h>
+#include <sys/time.h>
+
+/*
+ * The ascii tree and the ITree operations built on it, as they were
+ * before the hash index (only the realloc size of at_append_link is
+ * fixed, it was one pointer short).
+ */
+typedef struct _ascii_tree {
+	char    	  ascii;
+	void*   	  e_marker;
+	char    	  n_links;
+	_ascii_tree **links;
+}
+ascii_tree_t;
+
+static ascii_tree_t *at_find_next_link( ascii_tree_t *at, char ascii ){
+	int i, j, n_links(at->n_links), r_start(n_links - 1);
+
+	for( i = 0, j = r_start; i < n_links; ++i, --j ){
+		if( at->links[i]->ascii == ascii ){
+			return at->links[i];
+		}
+		else if( at->links[j]->ascii == ascii ){
+			return at->links[j];
+		}
+	}
+	return NULL;
+}
+
+static void at_insert( ascii_tree_t *at, char *key, int len, void *value ){
+	ascii_tree_t *link;
+
+	if(!len){
+		at->e_marker = value;
+		return;
+	}
+
+	if( (link = at_find_next_link( at, key[0] )) == NULL ){
+		link 	  = (ascii_tree_t *)calloc( 1, sizeof(ascii_tree_t) );
+		link->ascii = key[0];
+		at->links = (ascii_tree_t **)realloc( at->links, sizeof(ascii_tree_t *) * (at->n_links + 1) );
+		at->links[ at->n_links++ ] = link;
+	}
+
+	at_insert( link, ++key, --len, value );
+}
+
+static ascii_tree_t *at_find_link( ascii_tree_t *at, char *key, int len ){
+	ascii_tree_t *link = at;
+	int i = 0;
+
+	do{
+		link = at_find_next_link( link, key[i++] );
+	}
+	while( --len && link );
+
+	return link;
+}
+
+static void at_free( ascii_tree_t *at ){
+	int i;
+
+	for( i = 0; i < at->n_links; ++i ){
+		at_free( at->links[i] );
+		free( at->links[i] );
+	}
+	free( at->links );
+	at->links   = NULL;
+	at->n_links = 0;
+}
+
+template< typename value_t > class AsciiTree {
+	typedef struct map_pair {
+		string   label;
+		value_t *value;
+
+		map_pair( char *l, value_t *v ) : label(l), value(v) {
+
+		}
+	}
+	pair_t;
+
+	vector<pair_t *> m_map;
+	ascii_tree_t     m_tree;
+
+public :
+
+	AsciiTree(){
+		memset( &m_tree, 0, sizeof(ascii_tree_t) );
+	}
+
+	~AsciiTree(){
+		clear();
+	}
+
+	value_t *insert( char *label, value_t *value ){
+		pair_t *pair = new pair_t( label, value );
+
+		m_map.push_back( pair );
+		at_insert( &m_tree, label, strlen(label), pair );
+
+		return value;
+	}
+
+	value_t *find( char *label ){
+		ascii_tree_t *link = at_find_link( &m_tree, label, strlen(label) );
+		pair_t		 *item = (pair_t *)(link ? link->e_marker : NULL);
+
+		return (item ? item->value : H_UNDEFINED);
+	}
+
+	void remove( char *label ){
+		ascii_tree_t *link = at_find_link( &m_tree, label, strlen(label) );
+		pair_t		 *item = (pair_t *)(link ? link->e_marker : NULL);
+		size_t		  i;
+
+		if( item ){
+			link->e_marker = NULL;
+			for( i = 0; i < m_map.size(); ++i ){
+				if( m_map[i] == item ){
+					delete m_map[i];
+					m_map.erase( m_map.begin() + i );
+					break;
+				}
+			}
+		}
+	}
+
+	void clear(){
+		for( size_t i = 0; i < m_map.size(); ++i ){
+			delete m_map[i];
+		}
+		m_map.clear();
+		at_free( &m_tree );
+	}
+};
+
+static double bench_now(){
+	struct timeval tv;
+
+	gettimeofday( &tv, NULL );
+
+	return tv.tv_sec + tv.tv_usec * 0.000001;
+}
+/*
+ * Labels looking like identifiers of a script.
+ */
+static void bench_labels( vector<string>& labels, size_t n ){
+	static const char *names[] = { "i", "item", "value", "result", "buffer", "counter", "name", "me" };
+	char label[0xFF];
+
+	for( size_t i = 0; i < n; ++i ){
+		snprintf( label, sizeof(label), "%s_%u", names[i % 8], (unsigned int)i );
+		labels.push_back(label);
+	}
+}
+/*
+ * A function frame : a few names inserted, looked up many times and
+ * cleared once the call is done.
+ */
+template< typename tree_t > static double bench_frames( vector<string>& labels, size_t rounds, size_t& found ){
+	double start = bench_now();
+	int	   value = 1;
+
+	for( size_t r = 0; r < rounds; ++r ){
+		tree_t frame;
+
+		for( size_t i = 0; i < labels.size(); ++i ){
+			frame.insert( (char *)labels[i].c_str(), &value );
+		}
+		for( size_t n = 0; n < 50; ++n ){
+			for( size_t i = 0; i < labels.size(); ++i ){
+				found += (frame.find( (char *)labels[i].c_str() ) != H_UNDEFINED);
+			}
+		}
+	}
+
+	return bench_now() - start;
+}
+/*
+ * A large segment (globals, module functions) : every label inserted,
+ * looked up and removed again.
+ */
+template< typename tree_t > static double bench_segment( vector<string>& labels, size_t rounds, size_t& found ){
+	double start = bench_now();
+	int	   value = 1;
+	tree_t segment;
+
+	for( size_t r = 0; r < rounds; ++r ){
+		for( size_t i = 0; i < labels.size(); ++i ){
+			segment.insert( (char *)labels[i].c_str(), &value );
+		}
+		for( size_t n = 0; n < 20; ++n ){
+			for( size_t i = 0; i < labels.size(); ++i ){
+				found += (segment.find( (char *)labels[i].c_str() ) != H_UNDEFINED);
+			}
+		}
+		for( size_t i = 0; i < labels.size(); ++i ){
+			segment.remove( (char *)labels[i].c_str() );
+		}
+	}
+
+	return bench_now() - start;
+}
+
+int main( int argc, char *argv[] ){
+	size_t 		   rounds = (argc > 1 ? atoi(argv[1]) : 200),
+				   found  = 0;
+	vector<string> small, large;
+
+	bench_labels( small, 8 );
+	bench_labels( large, 2000 );
+
+	printf( "frames  (8 labels, 50 finds each, %u rounds) : ascii tree %.3fs, hash index %.3fs\n",
+			(unsigned int)rounds * 1000,
+			bench_frames< AsciiTree<int> >( small, rounds * 1000, found ),
+			bench_frames< ITree<int> >( small, rounds * 1000, found ) );
+
+	printf( "segment (2000 labels, 20 finds each, %u rounds) : ascii tree %.3fs, hash index %.3fs\n",
+			(unsigned int)rounds,
+			bench_segment< AsciiTree<int> >( large, rounds, found ),
+			bench_segment< ITree<int> >( large, rounds, found ) );
+
+	return (found == 0);
+}
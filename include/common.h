@@ -30,11 +30,15 @@
 #include <unistd.h>
 #include <sstream>
 #include <math.h>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
 
 #define MAX_STRING_SIZE 1024
 #define MAX_IDENT_SIZE  100
 
-#define HMAXARGS 200
 /*
  * Macro to easily loop std::* collections.
  * Cache the .end() iterator at the beginning and use preincrement.
@@ -47,23 +51,24 @@
 #endif
 
 /*
- * Function declaration descriptor.
+ * Function declaration descriptor, created by the lexer and
+ * deleted by the parser once the declaration node is built.
  */
 typedef struct {
-    char function[0xFF];
-    int  argc;
-    char argv[HMAXARGS][0xFF];
-    bool vargs;
+    string		   function;
+    int  		   argc;
+    vector<string> argv;
+    bool 		   vargs;
 }
 function_decl_t;
 /*
  * Method declaration descriptor.
  */
 typedef struct {
-    char method[0xFF];
-    int  argc;
-    char argv[HMAXARGS][0xFF];
-    bool vargs;
+    string		   method;
+    int  		   argc;
+    vector<string> argv;
+    bool 		   vargs;
 }
 method_decl_t;
 /*
@@ -79,8 +84,37 @@ typedef struct {
     ulong tm_end;
 
 	bool  cgi_mode;
+	/*
+	 * Unix socket to serve FastCGI requests on (see hyb_fcgi_main).
+	 */
+	char  fcgi_socket[0xFF];
+	/*
+	 * Number of worker processes forked to serve the FastCGI socket
+	 * once the script is parsed, 0 to serve it from this process.
+	 */
+	int   prefork;
 
 	bool  debug;
+	/*
+	 * Module loading options, 'eager_load' ignores namespace manifests
+	 * and opens every module on import, 'rtld_lazy' opens modules with
+	 * RTLD_LAZY instead of RTLD_NOW, 'manifest' is the library path to
+	 * generate manifests for (see vm_write_manifest).
+	 */
+	bool  eager_load;
+	bool  rtld_lazy;
+	char  manifest[0xFF];
+	/*
+	 * Keep the parsed trees of loaded files and evaluated strings
+	 * to execute them again without parsing (see hyb_parse_string).
+	 */
+	bool  ast_cache;
+	/*
+	 * Heap snapshot to write once the main script has been executed
+	 * and to restore before executing it (see vm_snapshot_save).
+	 */
+	char  snapshot_out[0xFF];
+	char  snapshot_in[0xFF];
 
     ulong gc_threshold;
     ulong mm_threshold;
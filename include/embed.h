@@ -0,0 +1,153 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _HEMBED_H_
+#	define _HEMBED_H_
+
+#include <stddef.h>
+
+/*
+ * C interface to host the interpreter inside another program, linking
+ * libhybris.so :
+ *
+ *   hyb_vm_t       *vm = hyb_vm_create( argc, argv, envp );
+ *   hyb_function_t *fn;
+ *   hyb_value_t    *v;
+ *
+ *   hyb_vm_load( vm, "handlers.hy" );
+ *
+ *   fn = hyb_function_get( vm, "handle" );
+ *
+ *   hyb_push_string( fn, "/index" );
+ *   hyb_push_integer( fn, 42 );
+ *
+ *   if( (v = hyb_function_call( fn )) != NULL ){
+ *       printf( "%s\n", hyb_value_string(v) );
+ *   }
+ *   else{
+ *       printf( "%s\n", hyb_vm_error(vm) );
+ *   }
+ *
+ *   hyb_function_free( fn );
+ *   hyb_vm_destroy( vm );
+ *
+ * A function handle looks its function up only once and reuses its
+ * arguments frame, so a call only costs the conversion of its arguments
+ * and the execution itself.
+ * The value returned by a call stays valid until the next call of the same
+ * handle (or until the handle is freed), collections items read with
+ * hyb_value_at included.
+ * Each vm must be used by one thread at a time, different vms can run on
+ * different threads.
+ * Unhandled script exceptions are reported by hyb_vm_error, while fatal
+ * errors (syntax errors, memory exhausted, ...) terminate the process as
+ * they do in the interpreter.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _hyb_vm		 hyb_vm_t;
+typedef struct _hyb_function hyb_function_t;
+typedef struct _Object		 hyb_value_t;
+/*
+ * Type of a value, same codes as H_OBJECT_TYPE.
+ */
+enum hyb_type_t {
+	HYB_VOID = 0,
+	HYB_BOOLEAN,
+	HYB_INTEGER,
+	HYB_FLOAT,
+	HYB_CHAR,
+	HYB_STRING,
+	HYB_BINARY,
+	HYB_VECTOR,
+	HYB_MAP,
+	HYB_ALIAS,
+	HYB_EXTERN,
+	HYB_HANDLE,
+	HYB_STRUCTURE,
+	HYB_CLASS,
+	HYB_REFERENCE,
+	HYB_INTARRAY,
+	HYB_FLOATARRAY
+};
+/*
+ * Create and initialize a vm, 'argv' items starting from index 1 are
+ * the script arguments, 'envp' can be NULL.
+ */
+hyb_vm_t 	   *hyb_vm_create( int argc, char *argv[], char *envp[] );
+/*
+ * Release a vm, its function handles must be freed before.
+ */
+void			hyb_vm_destroy( hyb_vm_t *vm );
+/*
+ * Parse and execute a script file or a string, defining its functions,
+ * types and global variables.
+ * Return 0 on success, -1 if the file does not exist or an exception
+ * was not handled by the script.
+ */
+int				hyb_vm_load( hyb_vm_t *vm, const char *filename );
+int				hyb_vm_eval( hyb_vm_t *vm, const char *source );
+/*
+ * Message of the exception that made the last load, eval or call
+ * fail, NULL if it succeeded.
+ */
+const char	   *hyb_vm_error( hyb_vm_t *vm );
+/*
+ * Return a handle to the user defined or module function 'name', or
+ * NULL if it's not defined.
+ */
+hyb_function_t *hyb_function_get( hyb_vm_t *vm, const char *name );
+void			hyb_function_free( hyb_function_t *fn );
+/*
+ * Push the next argument of a call.
+ */
+void			hyb_push_boolean( hyb_function_t *fn, int value );
+void			hyb_push_integer( hyb_function_t *fn, long value );
+void			hyb_push_float( hyb_function_t *fn, double value );
+void			hyb_push_char( hyb_function_t *fn, char value );
+void			hyb_push_string( hyb_function_t *fn, const char *value );
+void			hyb_push_value( hyb_function_t *fn, hyb_value_t *value );
+/*
+ * Call the function with the pushed arguments, which are then removed.
+ * Return the function result, or NULL if it raised an exception or
+ * the number of arguments of a user defined function is wrong (module
+ * functions check their arguments themselves).
+ */
+hyb_value_t    *hyb_function_call( hyb_function_t *fn );
+/*
+ * Read a value, numeric and boolean values are converted to the
+ * requested type, hyb_value_string returns NULL for non string values.
+ */
+int				hyb_value_type( hyb_value_t *value );
+int				hyb_value_boolean( hyb_value_t *value );
+long			hyb_value_integer( hyb_value_t *value );
+double			hyb_value_float( hyb_value_t *value );
+const char	   *hyb_value_string( hyb_value_t *value );
+/*
+ * Number of items of a collection and item at 'index'.
+ */
+size_t			hyb_value_size( hyb_value_t *value );
+hyb_value_t    *hyb_value_at( hyb_value_t *value, size_t index );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -54,7 +54,7 @@ typedef unsigned long ulong;
 #define GC_DEFAULT_MEMORY_THRESHOLD 2048000
 /*
  * Maximum allowed memory size usage, if this threshold is reached
- * by __gc.usage counter, a fatal error will be triggered.
+ * by the gc usage counter, a fatal error will be triggered.
  *
  * Default value: 128M
  */
@@ -71,9 +71,10 @@ typedef struct _vm_t   vm_t;
 /*
  * Determine if an object has to be moved to the lag space.
  */
-#define GC_IS_LAGGING(v)     		  v / (double)__gc.collections >= GC_LAGGING_THRESHOLD
+#define GC_IS_LAGGING(gc,v)   		  v / (double)(gc)->collections >= GC_LAGGING_THRESHOLD
 /*
- * Main gc structure, kind of the "head" of the pool.
+ * Main gc structure, kind of the "head" of the pool, each vm has
+ * its own (see vm_current).
  *
  * constants    : Constant objects list (will be freed at the end).
  * lag			: When an object remains alive in the heap for a given
@@ -110,6 +111,10 @@ typedef struct _gc {
 }
 gc_t;
 
+/*
+ * The functions below, but gc_collect and gc_release, work on the
+ * heap of the vm running on the calling thread.
+ */
 /*
  * Set the 'gc_threshold' attribute of the gc structure.
  * Return the old threshold value.
@@ -165,9 +170,9 @@ void 			gc_mark( Object *o, bool mark = true );
 void            gc_collect( vm_t *vm );
 /*
  * Release all the pool and its contents, should be
- * used when the program is exiting, not before.
+ * used when the vm is released, not before.
  */
-void            gc_release();
+void            gc_release( vm_t *vm );
 
 /*
  * Object allocation macros.
@@ -185,6 +190,8 @@ void            gc_release();
 #define gc_new_string(v)     (String *)    gc_track( (Object *)( new String( (char *)(v) ) ),           	 sizeof(String) )
 #define gc_new_binary(d)     (Binary *)    gc_track( (Object *)( new Binary(d) ),                       	 sizeof(Binary) )
 #define gc_new_vector()      (Vector *)    gc_track( (Object *)( new Vector() ),                        	 sizeof(Vector) )
+#define gc_new_intarray()    (IntArray *)  gc_track( (Object *)( new IntArray() ),                      	 sizeof(IntArray) )
+#define gc_new_floatarray()  (FloatArray *)gc_track( (Object *)( new FloatArray() ),                    	 sizeof(FloatArray) )
 #define gc_new_map()         (Map *)       gc_track( (Object *)( new Map() ),                           	 sizeof(Map) )
 #define gc_new_struct()      (Structure *) gc_track( (Object *)( new Structure() ),                     	 sizeof(Structure) )
 #define gc_new_class()       (Class *)     gc_track( (Object *)( new Class() ),                              sizeof(Class) )
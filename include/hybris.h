@@ -38,13 +38,32 @@ extern Integer __default_error_value;
 #define H_DEFAULT_ERROR  (Object *)&__default_error_value
 #define H_VOID_VALUE     H_DEFAULT_RETURN
 /*
- * Parse and execute a file.
+ * Parse and execute the source read from 'fp' until its end.
+ */
+void hyb_parse_stream( vm_t *vm, FILE *fp );
+/*
+ * Parse the next tree from 'fp' into 'ast' without executing it, the
+ * caller owns the tree, ast->arena is NULL if nothing was parsed.
+ */
+void hyb_parse_tree( vm_t *vm, FILE *fp, node_ast_t *ast );
+/*
+ * Parse and execute a file, if the ast cache is enabled the tree is
+ * parsed again only if the file was modified.
  */
 void hyb_parse_file( vm_t *vm, const char *filename );
 /*
- * Parse and execute a string.
+ * Parse and execute a string, if the ast cache is enabled the tree of
+ * a string already parsed is executed again without parsing it.
  */
 void hyb_parse_string( vm_t *vm, const char *str );
+/*
+ * Parse the script once and serve FastCGI requests on the unix socket
+ * 'socket_path', executing it for each request in an empty global frame,
+ * with the request parameters as environment and its body as stdin.
+ * If vm->args.prefork is set, the requests are served by that many
+ * forked workers, restarted when they exit.
+ */
+void hyb_fcgi_main( vm_t *vm, const char *socket_path );
 
 #endif
 
@@ -19,7 +19,8 @@
 #ifndef _ITREE_H_
 #	define _ITREE_H_
 
-#include "asciitree.h"
+#include <stdlib.h>
+#include <string.h>
 
 /* from vmem.h */
 #ifndef H_UNDEFINED
@@ -44,6 +45,17 @@ using std::string;
  * A macro to easily loop itrees.
  */
 #define itree_foreach( INNER_TYPE, ITERATOR, ITREE ) vv_foreach( ITree<INNER_TYPE>, ITERATOR, ITREE )
+/*
+ * Initial number of slots of the hash index (must be a power of 2),
+ * they're allocated with the first insertion, so empty trees (most
+ * of the function frames) do not allocate anything.
+ */
+#define ITREE_INITIAL_SLOTS 8
+/*
+ * Special values of a slot index.
+ */
+#define ITREE_EMPTY_SLOT   -1
+#define ITREE_DELETED_SLOT -2
 /*
  * This class is the base for all the lookup tables inside Hybris.
  * It's used by MemorySegment, CodeSegment, cache tables and so on.
@@ -51,12 +63,15 @@ using std::string;
  * ITree has two main containers.
  *
  * m_map   : A vector to have items fast access by index.
- * m_table : An ascii tree to have fast access by label.
+ * m_slots : An open addressing (linear probing) hash index to have
+ * 			 fast access by label, each slot holds the hash of the label
+ * 			 and the position of its item inside m_map, so probing
+ * 			 does not touch the items until the hashes match.
  *
- * They points to the same objects so, changing the value of an item in
- * the vector will change that value inside the table, and viceversa.
- * With those two references, the class represent an indexed ascii tree,
- * adding by-index access capabilities to the ascii tree data type.
+ * Every item stores the hash of its label, so the table is grown
+ * without hashing the labels again.
+ * Removing an item moves the last one in its position, so items order
+ * is kept only as long as nothing is removed.
  */
 H_TEMPLATE_T class ITree {
 protected :
@@ -66,16 +81,48 @@ protected :
     typedef struct map_pair {
         string        label;
         value_t      *value;
+        unsigned int  hash;
 
-        map_pair( char *l, value_t *v ) : label(l), value(v) {
+        map_pair( char *l, value_t *v, unsigned int h ) : label(l), value(v), hash(h) {
 
         }
     }
     pair_t;
+    /*
+     * Structure rapresentation for a slot of the hash index.
+     */
+    typedef struct map_slot {
+    	unsigned int hash;
+    	int 		 index;
+    }
+    slot_t;
 
     unsigned int     m_elements;
     vector<pair_t *> m_map;
-    ascii_tree_t     m_tree;
+    slot_t          *m_slots;
+    /* Number of slots, always a power of 2. */
+    unsigned int     m_nslots;
+    /* Number of slots either used or deleted. */
+    unsigned int     m_nused;
+
+    /* Find the slot of the item mapped with 'label', or return -1 */
+    INLINE int lookup( char *label, unsigned int hash ){
+    	if( m_slots != NULL ){
+    		unsigned int mask( m_nslots - 1 ),
+    					 i( hash & mask );
+    		int			 index;
+
+    		while( (index = m_slots[i].index) != ITREE_EMPTY_SLOT ){
+    			if( index >= 0 && m_slots[i].hash == hash && strcmp( m_map[index]->label.c_str(), label ) == 0 ){
+    				return i;
+    			}
+    			i = (i + 1) & mask;
+    		}
+    	}
+    	return -1;
+    }
+    /* Allocate 'nslots' slots and move the used slots there */
+    void rehash( unsigned int nslots );
 
 public  :
 
@@ -119,6 +166,17 @@ public  :
     ITree();
     ~ITree();
 
+    /* Compute the hash of a label (FNV-1a). */
+    static INLINE unsigned int hash( const char *label ){
+    	unsigned int h = 2166136261U;
+
+    	while( *label ){
+    		h ^= (unsigned char)*label++;
+    		h *= 16777619U;
+    	}
+
+    	return h;
+    }
     /* Get the number of items mapped here. f*/
     INLINE unsigned int size(){
 		return m_elements;
@@ -136,27 +194,107 @@ public  :
     /* Remove an object from the tree */
     void	 remove( char *label );
     /* Find the item mappeb with 'label', or return NULL if it's not here */
-    value_t *find( char *label );
+    INLINE value_t *find( char *label ){
+    	return find( label, hash(label) );
+    }
+    /* Same as above, with the hash of the label already computed */
+    INLINE value_t *find( char *label, unsigned int hash ){
+    	int slot = lookup( label, hash );
+
+		return (slot == -1 ? H_UNDEFINED : m_map[ m_slots[slot].index ]->value);
+    }
     /* Replace the value if it already exists */
     value_t *replace( char *label, value_t *old_value, value_t *new_value );
     /* Clear the whole table */
     void     clear();
+    /* Make room for 'n' items, so they'll be inserted without growing the table */
+    void	 reserve( unsigned int n );
 };
 
-H_TEMPLATE_T ITree<value_t>::ITree(){
-	at_init_tree(m_tree);
-    m_elements = 0;
+H_TEMPLATE_T ITree<value_t>::ITree() :
+	m_elements(0),
+	m_slots(NULL),
+	m_nslots(0),
+	m_nused(0) {
+
 }
 
 H_TEMPLATE_T ITree<value_t>::~ITree(){
 	clear();
+	if( m_slots != NULL ){
+		free( m_slots );
+	}
+}
+
+H_TEMPLATE_T void ITree<value_t>::rehash( unsigned int nslots ){
+	slot_t      *slots = (slot_t *)malloc( sizeof(slot_t) * nslots );
+	unsigned int i, j, used(0), mask( nslots - 1 );
+
+	for( i = 0; i < nslots; ++i ){
+		slots[i].index = ITREE_EMPTY_SLOT;
+	}
+	/*
+	 * Deleted slots are dropped, used ones are moved.
+	 */
+	for( i = 0; i < m_nslots; ++i ){
+		if( m_slots[i].index >= 0 ){
+			for( j = m_slots[i].hash & mask; slots[j].index != ITREE_EMPTY_SLOT; j = (j + 1) & mask );
+
+			slots[j] = m_slots[i];
+			used++;
+		}
+	}
+
+	if( m_slots != NULL ){
+		free( m_slots );
+	}
+
+	m_slots  = slots;
+	m_nslots = nslots;
+	m_nused  = used;
 }
 
 H_TEMPLATE_T value_t * ITree<value_t>::insert( char *label, value_t *value ){
-	pair_t *pair = new pair_t( label, value );
+	unsigned int h( hash(label) ),
+				 mask,
+				 i;
+	int          slot,
+				 deleted( -1 );
+	pair_t      *pair = new pair_t( label, value, h );
+
 	m_map.push_back( pair );
+	/*
+	 * Keep the load factor (deleted slots included) under 1/2.
+	 */
+	if( (m_nused + 1) * 2 > m_nslots ){
+		rehash( m_nslots ? (m_elements + 1) * 2 > m_nslots ? m_nslots * 2 : m_nslots : ITREE_INITIAL_SLOTS );
+	}
+
+	/*
+	 * If the label is already mapped, the old item is left in m_map
+	 * (still accessible by index) and the label maps the new one.
+	 */
+	if( (slot = lookup( label, h )) != -1 ){
+		m_slots[slot].index = m_elements;
+	}
+	else{
+		mask = m_nslots - 1;
+		for( i = h & mask; m_slots[i].index != ITREE_EMPTY_SLOT; i = (i + 1) & mask ){
+			if( m_slots[i].index == ITREE_DELETED_SLOT && deleted == -1 ){
+				deleted = i;
+			}
+		}
+
+		if( deleted != -1 ){
+			i = deleted;
+		}
+		else{
+			m_nused++;
+		}
 
-	at_insert( &m_tree, label, strlen(label), pair );
+		m_slots[i].hash  = h;
+		m_slots[i].index = m_elements;
+	}
 
     m_elements++;
 
@@ -164,34 +302,48 @@ H_TEMPLATE_T value_t * ITree<value_t>::insert( char *label, value_t *value ){
 }
 
 H_TEMPLATE_T void ITree<value_t>::remove( char *label ){
-	pair_t  *item = (pair_t *)at_remove( &m_tree, label, strlen(label) );
-
-	if( item ){
-		size_t i, size(m_elements);
-		for( i = 0; i < size; ++i ){
-			if( m_map[i] == item ){
-				delete m_map[i];
-				m_map.erase( m_map.begin() + i );
-				m_elements--;
-				break;
+	int          slot,
+				 index;
+	unsigned int last,
+				 mask,
+				 i;
+
+	if( (slot = lookup( label, hash(label) )) != -1 ){
+		index = m_slots[slot].index;
+		last  = m_elements - 1;
+
+		m_slots[slot].index = ITREE_DELETED_SLOT;
+
+		delete m_map[index];
+		/*
+		 * Move the last item in the free position and update its slot,
+		 * unless it's an item whose label was mapped again (so it's
+		 * not referenced by any slot).
+		 */
+		if( (unsigned)index != last ){
+			pair_t *moved = m_map[last];
+
+			m_map[index] = moved;
+
+			mask = m_nslots - 1;
+			for( i = moved->hash & mask; m_slots[i].index != ITREE_EMPTY_SLOT; i = (i + 1) & mask ){
+				if( (unsigned)m_slots[i].index == last ){
+					m_slots[i].index = index;
+					break;
+				}
 			}
 		}
-	}
-}
 
-H_TEMPLATE_T value_t * ITree<value_t>::find( char *label ){
-	pair_t *item = (pair_t *)at_find( &m_tree, label, strlen(label) );
-    if( item ){
-        return item->value;
-    }
-    return H_UNDEFINED;
+		m_map.pop_back();
+		m_elements--;
+	}
 }
 
 H_TEMPLATE_T value_t * ITree<value_t>::replace( char *label, value_t *old_value, value_t *new_value ){
-	pair_t *item;
+	int slot;
 
-	if( (item = (pair_t *)at_find( &m_tree, label, strlen(label) )) != NULL ){
-		item->value = new_value;
+	if( (slot = lookup( label, hash(label) )) != -1 ){
+		m_map[ m_slots[slot].index ]->value = new_value;
 	}
 
 	return old_value;
@@ -204,7 +356,26 @@ H_TEMPLATE_T void ITree<value_t>::clear(){
     }
     m_map.clear();
     m_elements = 0;
-    at_clear( &m_tree );
+    /*
+     * Keep the slots allocated, the tree is likely to be filled again.
+     */
+    for( i = 0; i < m_nslots; ++i ){
+    	m_slots[i].index = ITREE_EMPTY_SLOT;
+    }
+    m_nused = 0;
+}
+
+H_TEMPLATE_T void ITree<value_t>::reserve( unsigned int n ){
+	unsigned int nslots( m_nslots ? m_nslots : ITREE_INITIAL_SLOTS );
+
+	while( n * 2 > nslots ){
+		nslots <<= 1;
+	}
+
+	if( nslots != m_nslots ){
+		rehash( nslots );
+	}
+	m_map.reserve( n );
 }
 
 #endif
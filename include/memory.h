@@ -108,14 +108,70 @@ class MemorySegment : public ITree<Object> {
 		 */
 		vframe_state_t  state;
 		/*
-		 * Mutex for thread shared segments.
+		 * Mutex for thread shared segments, initialized and used
+		 * only once the segment is marked as shared (see ::share),
+		 * function frames are private to their thread.
 		 */
+		bool			shared;
 		pthread_mutex_t mutex;
+		/*
+		 * Anonymous values (builtin functions arguments and user
+		 * functions arguments exceeding the declared ones).
+		 */
+		vector<Object *> args;
+		/*
+		 * Temporary values that must survive garbage collections
+		 * while being evaluated, the gc marks them as alive.
+		 */
+		vector<Object *> roots;
+		/*
+		 * Tail calls (see vm_exec_return), 'tail_calls' is set on user
+		 * function frames a 'return f(...)' statement can reuse, the function
+		 * to run next and its arguments are stored in 'tail_function' and
+		 * 'tail_args', while 'elided' counts the calls that reused this frame.
+		 */
+		bool			 tail_calls;
+		Node			*tail_function;
+		vector<Object *> tail_args;
+		size_t			 elided;
 
 		MemorySegment();
 
+		/*
+		 * Mark this segment as accessed by more threads, so add and
+		 * bind operations will be serialized.
+		 */
+		INLINE void share(){
+			if( shared == false ){
+				pthread_mutex_init( &mutex, NULL );
+				shared = true;
+			}
+		}
+		INLINE void lock(){
+			if( shared ){
+				pthread_mutex_lock( &mutex );
+			}
+		}
+		INLINE void unlock(){
+			if( shared ){
+				pthread_mutex_unlock( &mutex );
+			}
+		}
+
 		INLINE Object *operator [] ( int index ){
-			return m_map[index]->value;
+			return args[index];
+		}
+		/*
+		 * Number of anonymous values pushed on the stack.
+		 */
+		INLINE size_t argc(){
+			return args.size();
+		}
+		/*
+		 * Get the anonymous value at 'index'.
+		 */
+		INLINE Object *argv( size_t index ){
+			return args[index];
 		}
 
 		/*
@@ -125,6 +181,14 @@ class MemorySegment : public ITree<Object> {
         INLINE Object *get( char *identifier ){
         	return find(identifier);
         }
+        /*
+         * Same as above, with the hash of 'identifier' already computed
+         * (see ITree::hash), used when the same identifier has to be
+         * looked up in more segments.
+         */
+        INLINE Object *get( char *identifier, unsigned int hash ){
+        	return find( identifier, hash );
+        }
         /*
          * Clone the object, define it as 'identifier' if it's not
          * defined yet, otherwise replace the old value with this one.
@@ -137,6 +201,25 @@ class MemorySegment : public ITree<Object> {
          * 			constant value.
          */
         Object *add( char *identifier, Object *object );
+        /*
+         * Define 'identifier' as the object itself, without cloning it and
+         * without freeing the old value, used to bind foreach loop variables
+         * directly to collection items.
+         */
+        INLINE Object *bind( char *identifier, Object *object ){
+        	Object *prev = H_UNDEFINED;
+
+        	lock();
+        	if( (prev = get( identifier )) == H_UNDEFINED ){
+				insert( identifier, object );
+			}
+			else{
+				replace( identifier, prev, object );
+			}
+        	unlock();
+
+        	return object;
+        }
         /*
          * Unlikely ::add, this method will not clone the object, but just
          * define it and mark it as a constant value.
@@ -156,36 +239,31 @@ class MemorySegment : public ITree<Object> {
         	return o;
         }
         /*
-         * This method will push 'value' onto the stack, with an anonymous identifier.
+         * This method will push 'value' onto the stack as an anonymous value.
          *
          * NOTE 1 : The object will not be cloned because this method is used with
          * 			builtin functions, so we do not care about reference overwriting
          * 			or issues like that.
          */
         INLINE Object *push( Object *value ){
-        	char label[0xFF] = {0};
-        	sprintf( label, "HANONYMOUSIDENTIFIER%d", m_elements );
-        	return MemorySegment::insert( label, value );
+        	args.push_back( value );
+        	return value;
         }
         /*
-         * Special method to push temporary values onto the stack.
+         * Protect a temporary value from the garbage collector, return
+         * the position to be passed to pop_tmp once the value is not
+         * needed anymore.
          */
-        INLINE Object *push_tmp( Object *value ){
-        	char label[0xFF] = {0};
-
-			sprintf( label, "HTMPOBJ%p", value );
-
-			return MemorySegment::insert( label, value );
+        INLINE size_t push_tmp( Object *value ){
+        	roots.push_back( value );
+        	return roots.size() - 1;
         }
         /*
-		 * Special method to remove temporary values from the stack.
+		 * Release the temporary value at position 'index' and every
+		 * value pushed after it.
 		 */
-		INLINE void remove_tmp( Object *value ){
-			char label[0xFF] = {0};
-
-			sprintf( label, "HTMPOBJ%p", value );
-
-			remove( label );
+		INLINE void pop_tmp( size_t index ){
+			roots.resize( index );
 		}
 
         /*
@@ -199,6 +277,8 @@ class MemorySegment : public ITree<Object> {
          */
         INLINE void release(){
         	clear();
+        	args.clear();
+        	roots.clear();
         }
 };
 
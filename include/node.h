@@ -21,13 +21,17 @@
 
 #include "types.h"
 #include "common.h"
+#include "itree.h"
 #include <vector>
 #include <list>
 #include <string>
+#include <map>
+#include <time.h>
 
 using std::vector;
 using std::list;
 using std::string;
+using std::map;
 
 /*
  * Cast a linked list item to a Node pointer
@@ -62,39 +66,156 @@ enum H_NODE_TYPE {
 /* pre declaration of class Node */
 class  Node;
 
+/*
+ * Kind of lookup a switch statement uses to find its case.
+ */
+enum switch_kind_t {
+	/* case labels are evaluated and compared in order */
+	skLinear = 0,
+	/* all labels are integer or char constants */
+	skInteger,
+	/* all labels are string constants */
+	skString
+};
+
+/*
+ * Lookup table of a switch statement, built on its first execution
+ * (see vm_exec_switch), mapping each constant label to the statements
+ * of the first case with that label.
+ */
+typedef struct _switch_table {
+	switch_kind_t kind;
+	/*
+	 * Integer labels close enough to each other are mapped by a jump
+	 * table starting from 'base', sparse ones by 'ivalues'.
+	 */
+	long 			  base;
+	vector<Node *>	  jumps;
+	map<long, Node *> ivalues;
+	/*
+	 * String labels.
+	 */
+	ITree<Node>		  svalues;
+
+	_switch_table() : kind(skLinear), base(0) {
+
+	}
+}
+switch_table_t;
+
 /* possible values for a generic node */
 class NodeValue {
     public :
-
-        Object  *constant;
+		/*
+		 * Name of the identifier, declared function or method, called
+		 * function, instantiated type or catched exception.
+		 */
         string   identifier;
+        switch_table_t *switch_table;
+        /*
+         * Node kind specific values, only the ones of the kind of
+         * the node are meaningful.
+         */
+        union {
+        	/* constants */
+        	Object  *constant;
+        	/* calls by alias */
+        	Node    *alias;
+        	/* switch statements */
+        	struct {
+				Node *switch_block;
+				Node *default_block;
+        	};
+        	/* attribute requests and method calls */
+        	struct {
+				Node *owner;
+				Node *member;
+        	};
+        	/* try/catch/finally statements */
+        	struct {
+				Node *try_block;
+				Node *catch_block;
+				Node *finally_block;
+        	};
+        	/* class declarations */
+        	llist_t  extends;
+        };
 
-        Node    *switch_block;
-        Node    *default_block;
-
-        string   function;
-        bool	 vargs;
-
+        size_t	 argc;
         access_t access;
+        bool	 vargs;
         bool	 is_static;
-        string   method;
 
-        string   call;
-        Node    *alias;
-        size_t	 argc;
-
-        Node    *owner;
-        Node    *member;
+        NodeValue();
+};
 
-        Node	*try_block;
-        string	 exception_id;
-        Node    *catch_block;
-        Node	*finally_block;
+/*
+ * Children of a node, stored contiguously to be accessed by index.
+ */
+typedef struct _node_list {
+	Node  **nodes;
+	size_t  items;
+	size_t  size;
+}
+node_list_t;
 
-        llist_t  extends;
+/*
+ * Nodes created while parsing are allocated from an arena, so that
+ * a tree is laid out in a few big chunks instead of being scattered
+ * around the heap, and it's released at once when the parsed code
+ * has been executed.
+ * Nodes created when no arena is active (clones made at runtime for
+ * functions and methods) are allocated on the heap.
+ */
+#define NODE_ARENA_CHUNK_SIZE 65536
+
+typedef struct _node_arena {
+	vector<char *> chunks;
+	/* bytes used in the last chunk */
+	size_t		   used;
+}
+node_arena_t;
+
+/* create an arena and allocate nodes from it on the calling thread */
+node_arena_t *node_arena_begin();
+/* stop allocating nodes from the current arena and return it */
+node_arena_t *node_arena_end();
+/* free the arena, every node allocated from it must be deleted already */
+void 		  node_arena_release( node_arena_t *arena );
 
-        NodeValue();
-};
+/*
+ * A parsed tree kept alive after being executed, so the same source can
+ * be executed again without parsing it (see hyb_parse_string), it owns
+ * the arena its nodes were allocated from.
+ */
+typedef struct _node_ast {
+	Node		 *root;
+	node_arena_t *arena;
+	/* modification time of the parsed file, if any */
+	time_t		  mtime;
+	/* one for the cache keeping it, plus one for each running execution */
+	size_t		  refs;
+}
+node_ast_t;
+
+/* delete the nodes of a tree and release its arena */
+void 		  node_ast_release( node_ast_t *ast );
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#	define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+/*
+ * Extra data of a reentrant scanner, shared with the pure parser, so
+ * each parse has its own vm and tree to fill instead of global ones.
+ */
+typedef struct _node_parser {
+	/* the vm whose source is being parsed */
+	vm_t 	   *vm;
+	/* where the parser will store the parsed tree */
+	node_ast_t *ast;
+}
+node_parser_t;
 
 /* node base class */
 class Node {
@@ -105,30 +226,35 @@ public  :
 	H_NODE_TYPE  type;
 	int      	 opcode;
     Node		*body;
-    llist_t		 children;
+    node_list_t	 children;
     NodeValue 	 value;
 
     Node();
     Node( H_NODE_TYPE type, size_t lineno );
-    ~Node();
+    virtual ~Node();
+
+    static void *operator new( size_t size );
+    static void  operator delete( void *p );
 
     INLINE void addChild( Node *child ){
-    	ll_append( &children, child );
+    	if( children.items == children.size ){
+    		children.size  = (children.size ? children.size << 1 : 2);
+    		children.nodes = (Node **)realloc( children.nodes, sizeof(Node *) * children.size );
+    	}
+    	children.nodes[children.items++] = child;
     }
+    /*
+     * Move the nodes of 'list' to the children and destroy it.
+     */
+    void addChildren( llist_t *list );
 
     INLINE Node *child( size_t i ){
-        switch(i){
-			case 0 : return (Node *)children.head->data;
-			case 1 : return (Node *)children.head->next->data;
-			case 2 : return (Node *)children.head->next->next->data;
-			case 3 : return (Node *)children.head->next->next->next->data;
-
-			default :
-				/*
-				 * THIS SHOULD NEVER HAPPEN!
-				 */
-				assert( false );
-        }
+    	/*
+		 * THIS SHOULD NEVER HAPPEN!
+		 */
+    	assert( i < children.items );
+
+        return children.nodes[i];
     }
 
     INLINE char *id(){
@@ -209,12 +335,31 @@ class MethodCallNode : public Node {
 
 /* function declarations */
 class FunctionNode : public Node {
+    private :
+
+		/* count identifiers inside 'node', nested declarations excluded */
+		static size_t countIdentifiers( Node *node );
+
     public :
+		/*
+		 * Parameters names, pointing to the identifier children, so
+		 * they're not collected again on every call.
+		 */
+		vector<char *> params;
+		/*
+		 * Upper bound of the number of names a call of this function
+		 * will define on its frame (parameters and locals), used to
+		 * size the frame before the call.
+		 */
+		size_t		   frame_size;
 
         FunctionNode( size_t lineno, function_decl_t *declaration );
         FunctionNode( size_t lineno, function_decl_t *declaration, int argc, ... );
         FunctionNode( size_t lineno, const char *name );
 
+        /* fill 'params' and compute 'frame_size' once children are added */
+        void prepare();
+
         Node *clone();
 };
 
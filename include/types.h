@@ -156,6 +156,10 @@ typedef MemorySegment vframe_t;
 #define ob_is_vector(o)     ob_is_typeof(o,Vector)
 #define ob_vector_ucast(o)  ((Vector *)(o))
 #define ob_vector_val(o)    (((Vector *)(o)))
+#define ob_is_intarray(o)     ob_is_typeof(o,IntArray)
+#define ob_intarray_ucast(o)  ((IntArray *)(o))
+#define ob_is_floatarray(o)   ob_is_typeof(o,FloatArray)
+#define ob_floatarray_ucast(o) ((FloatArray *)(o))
 #define ob_is_map(o)        ob_is_typeof(o,Map)
 #define ob_map_ucast(o)     ((Map *)(o))
 #define ob_map_val(o)	    (Map *)(o)
@@ -280,10 +284,14 @@ typedef void     (*ob_set_attribute_function_t) ( Object *, char *, Object * );
 typedef void     (*ob_define_method_function_t) ( Object *, char *, Node * );
 typedef Node   * (*ob_get_method_function_t)	( Object *, char *, int );
 typedef Object * (*ob_call_method_function_t)	( vm_t *, vframe_t *, Object *, char *, char *, Node * );
+// iterator protocol
+typedef struct _ob_iterator_t ob_iterator_t;
+typedef void     (*ob_iter_begin_function_t)    ( Object *, ob_iterator_t * );
+typedef bool     (*ob_iter_next_function_t)     ( Object *, ob_iterator_t *, Object **, Object ** );
 /*
  * Object type codes enumeration.
  * otEndMarker is used to mark the last allowed type in
- * vm_function_t::types.
+ * vm_function_decl_t::types.
  */
 enum H_OBJECT_TYPE {
 	otEndMarker = -1,
@@ -301,8 +309,14 @@ enum H_OBJECT_TYPE {
     otHandle,
     otStructure,
     otClass,
-    otReference
+    otReference,
+    otIntArray,
+    otFloatArray
 };
+/*
+ * Number of type codes, used to size tables indexed by type code.
+ */
+#define H_OBJECT_TYPES (otFloatArray + 1)
 
 /*
  * Set the object_type_t::size field to zero for collections, the
@@ -327,6 +341,8 @@ INLINE const char *ob_type_to_string( H_OBJECT_TYPE type ){
 		case otStructure : return "structure";
 		case otClass     : return "class";
 		case otReference : return "reference";
+		case otIntArray  : return "intarray";
+		case otFloatArray: return "floatarray";
 	}
 	/*
 	 * We should never get here!
@@ -368,6 +384,7 @@ typedef struct _object_type_t {
     ob_traverse_function_t		traverse;
     ob_unary_function_t         clone;
     ob_free_function_t          free;
+    ob_free_function_t          unshare;
     ob_size_function_t			get_size;
     ob_serialize_function_t     serialize;
     ob_deserialize_function_t   deserialize;
@@ -449,6 +466,10 @@ typedef struct _object_type_t {
     ob_define_method_function_t define_method;
     ob_get_method_function_t    get_method;
     ob_call_method_function_t   call_method;
+
+    /** iterator protocol **/
+    ob_iter_begin_function_t    iter_begin;
+    ob_iter_next_function_t     iter_next;
 }
 object_type_t;
 
@@ -479,6 +500,12 @@ Object* ob_clone( Object *o );
  * Eventually free object inner elements (for colletions) and decrement its reference counter.
  */
 bool    ob_free( Object *o );
+/*
+ * Collections cloned with copy on write share their items with the
+ * original object, make sure 'o' owns its items before they're modified
+ * in place.
+ */
+void    ob_unshare( Object *o );
 /*
  * Return the size of the object or, in case it's a collection, the number of its elements.
  */
@@ -775,6 +802,20 @@ Node   *ob_get_method( Object *c, char *name, int argc = -1 );
  * Execute a class method.
  */
 Object *ob_call_method( vm_t *vm, vframe_t *frame, Object *owner, char *owner_id, char *method_id, Node *argv );
+/*
+ * Initialize the iterator 'it' to loop the object 'o'.
+ * Types that do not implement the iterator protocol are iterated
+ * with ob_get_size and ob_cl_at.
+ */
+void    ob_iter_begin( Object *o, ob_iterator_t *it );
+/*
+ * Fetch the next item from the iterator, storing its key (or index) into
+ * 'key' if not NULL and the item itself into 'value'.
+ * Items are returned as they are stored inside the collection, without
+ * cloning them.
+ * Return false when there are no more items.
+ */
+bool    ob_iter_next( ob_iterator_t *it, Object **key, Object **value );
 /**
  * Types definition.
  */
@@ -899,14 +940,27 @@ Binary;
 
 typedef vector<Object *>::iterator BinaryIterator;
 
+/*
+ * Share counters of copy on write collections (see vector_clone) are
+ * shared by objects that could be owned by different threads (thread
+ * and pool task arguments), so they're updated atomically.
+ */
+#define ob_share_inc(s) __sync_add_and_fetch( (s), 1 )
+#define ob_share_dec(s) __sync_sub_and_fetch( (s), 1 )
+
 DECLARE_TYPE(Vector);
 
 typedef struct _Vector {
     BASE_OBJECT_HEADER;
     size_t           items;
     vector<Object *> value;
+    /*
+     * Number of vectors sharing the items of this one (copy on write),
+     * NULL if the items are not shared.
+     */
+    size_t          *shares;
 
-    _Vector() : items(0), BASE_OBJECT_HEADER_INIT(Vector) {
+    _Vector() : items(0), shares(NULL), BASE_OBJECT_HEADER_INIT(Vector) {
         // define to test space reservation optimization
         #ifdef RESERVED_VECTORS_SPACE
             value.reserve( RESERVE_VECTORS_SPACE );
@@ -916,6 +970,43 @@ typedef struct _Vector {
 Vector;
 
 typedef vector<Object *>::iterator VectorIterator;
+/*
+ * Typed numeric arrays, unlike vectors they hold their items unboxed
+ * into a contiguous buffer, so reductions and elementwise operators
+ * are plain loops over long or double values that the compiler
+ * is able to vectorize.
+ */
+DECLARE_TYPE(IntArray);
+
+typedef struct _IntArray {
+    BASE_OBJECT_HEADER;
+    size_t       items;
+    vector<long> value;
+
+    _IntArray() : items(0), BASE_OBJECT_HEADER_INIT(IntArray) {
+
+    }
+}
+IntArray;
+
+DECLARE_TYPE(FloatArray);
+
+typedef struct _FloatArray {
+    BASE_OBJECT_HEADER;
+    size_t         items;
+    vector<double> value;
+
+    _FloatArray() : items(0), BASE_OBJECT_HEADER_INIT(FloatArray) {
+
+    }
+}
+FloatArray;
+/*
+ * Create a typed array from a vector (or any other collection) converting
+ * each item with ob_ivalue or ob_fvalue.
+ */
+Object *intarray_from_collection( Object *o );
+Object *floatarray_from_collection( Object *o );
 
 DECLARE_TYPE(Map);
 
@@ -926,8 +1017,13 @@ typedef struct _Map {
     size_t           items;
     vector<Object *> keys;
     vector<Object *> values;
+    /*
+     * Number of maps sharing the keys and values of this one
+     * (copy on write), NULL if they're not shared.
+     */
+    size_t          *shares;
 
-    _Map() : items(0), BASE_OBJECT_HEADER_INIT(Map) {
+    _Map() : items(0), shares(NULL), BASE_OBJECT_HEADER_INIT(Map) {
         // define to test space reservation optimization
         #ifdef RESERVED_VECTORS_SPACE
             keys.reserve( RESERVE_VECTORS_SPACE );
@@ -968,7 +1064,12 @@ typedef struct _class_attribute_t {
 		access(a),
 		value(v),
 		is_static(_static) {
-		pthread_mutex_init( &mutex, NULL );
+		/*
+		 * Only static attributes are shared among threads.
+		 */
+		if( is_static ){
+			pthread_mutex_init( &mutex, NULL );
+		}
 	}
 
 	INLINE void lock(){
@@ -990,28 +1091,158 @@ typedef struct _class_method_t {
 	 * different parameters, so we have to hold a vector of Nodes.
 	 */
 	prototypes_t prototypes;
+	/*
+	 * Prototypes indexed by their number of parameters, each item is
+	 * the first prototype declared with that number, or NULL.
+	 */
+	prototypes_t arities;
 
 	_class_method_t( string n, Node *m ) : name(n) {
-		prototypes.push_back(m);
+		add(m);
 	}
 
-	_class_method_t( string n, prototypes_t& p ) : name(n), prototypes(p) {
+	_class_method_t( string n, prototypes_t& p ) : name(n) {
+		for( size_t i = 0; i < p.size(); ++i ){
+			add( p[i] );
+		}
+	}
+	/*
+	 * Add a prototype to the method.
+	 */
+	void add( Node *m );
+	/*
+	 * Get the prototype declared with 'argc' parameters, or the first
+	 * one if there's no such prototype or argc < 0.
+	 */
+	INLINE Node *get( int argc ){
+		if( argc >= 0 && argc < arities.size() && arities[argc] != NULL ){
+			return arities[argc];
+		}
+		return prototypes.front();
 	}
 }
 class_method_t;
 
+/*
+ * Operators and descriptors a class can overload, used as indexes
+ * of the class_table_t slots.
+ */
+enum class_slot_t {
+	csRange = 0,
+	csRegexp,
+	csIncrement,
+	csDecrement,
+	csAdd,
+	csSub,
+	csMul,
+	csDiv,
+	csMod,
+	csInplaceAdd,
+	csInplaceSub,
+	csInplaceMul,
+	csInplaceDiv,
+	csInplaceMod,
+	csBwAnd,
+	csBwOr,
+	csBwNot,
+	csBwXor,
+	csBwLshift,
+	csBwRshift,
+	csBwInplaceAnd,
+	csBwInplaceOr,
+	csBwInplaceXor,
+	csBwInplaceLshift,
+	csBwInplaceRshift,
+	csLNot,
+	csLSame,
+	csLDiff,
+	csLLess,
+	csLGreater,
+	csLLessOrSame,
+	csLGreaterOrSame,
+	csLOr,
+	csLAnd,
+	csClPush,
+	csClAt,
+	csClSet,
+	/* descriptors */
+	csSize,
+	csToString,
+	csAttribute,
+	csMethod,
+	csIter,
+	csNext,
+	csSlots
+};
+/*
+ * Methods of a class that overload an operator or a descriptor,
+ * built once when the class is declared and shared among all its
+ * instances, a NULL slot means the class does not overload it.
+ */
+typedef struct _class_table_t {
+	class_method_t *slots[csSlots];
+}
+class_table_t;
+
+/*
+ * What the new operator needs to create an instance of a class,
+ * built once for the class prototype (see class_build_recipe).
+ */
+typedef struct _class_recipe_t {
+	/*
+	 * Prototype attributes in declaration order, instances get a
+	 * clone of the default value of non static ones and share the
+	 * static ones.
+	 */
+	vector<class_attribute_t *> attributes;
+	/*
+	 * Methods and operators table, shared by every instance.
+	 */
+	ITree<class_method_t>      *methods;
+	class_table_t              *table;
+}
+class_recipe_t;
+
 typedef struct _Class {
     BASE_OBJECT_HEADER;
     string name;
 
     ITree<class_attribute_t> c_attributes;
-    ITree<class_method_t>	 c_methods;
+    /*
+     * Methods tree, NULL until the first method is defined, owned by
+     * the class itself until its recipe is built, then by the recipe.
+     */
+    ITree<class_method_t>	*c_methods;
+    /*
+     * Operators and descriptors table, NULL until class_build_table
+     * is called for the class prototype.
+     */
+    class_table_t			*table;
+    /*
+     * Instantiation recipe, shared with the prototype.
+     */
+    class_recipe_t			*recipe;
 
-    _Class() : BASE_OBJECT_HEADER_INIT(Class) {
+    _Class() : BASE_OBJECT_HEADER_INIT(Class), c_methods(NULL), table(NULL), recipe(NULL) {
 
     }
 }
 Class;
+/*
+ * Build the operators and descriptors table of a class prototype,
+ * once all of its methods are defined.
+ */
+void    class_build_table( Object *me );
+/*
+ * Build the operators table and the instantiation recipe of a class
+ * prototype, once all of its attributes and methods are defined.
+ */
+void    class_build_recipe( Object *me );
+/*
+ * Create a new instance of the class prototype 'me', if it has no
+ * recipe, this is the same as ob_clone.
+ */
+Object *class_new_instance( Object *me );
 
 typedef ITree<class_attribute_t>::iterator ClassAttributeIterator;
 typedef ITree<class_method_t>::iterator	   ClassMethodIterator;
@@ -1040,6 +1271,22 @@ typedef struct _Handle {
     }
 }
 Handle;
+/*
+ * Iterator state, 'collection' is the object being iterated (a type
+ * iter_begin function could replace it, for instance references will
+ * set it to the referenced object), 'index' the position of the next
+ * item and 'cursor' an helper Integer to be passed to ob_cl_at.
+ */
+typedef struct _ob_iterator_t {
+	Object *collection;
+	size_t  index;
+	Integer cursor;
+
+	_ob_iterator_t() : collection(NULL), index(0), cursor(0) {
+
+	}
+}
+ob_iterator_t;
 /*
  * Inline handlers implementation
  */
@@ -1075,6 +1322,12 @@ INLINE bool ob_free( Object *o ){
     return false;
 }
 
+INLINE void ob_unshare( Object *o ){
+	if( o->type->unshare != NULL ){
+		o->type->unshare(o);
+	}
+}
+
 INLINE size_t ob_get_size( Object *o ){
 	return (o->type->get_size ? o->type->get_size(o) : o->type->size);
 }
@@ -1703,5 +1956,89 @@ INLINE Object *ob_call_method( vm_t *vm, vframe_t *frame, Object *owner, char *o
 	}
 }
 
+INLINE void ob_iter_begin( Object *o, ob_iterator_t *it ){
+	it->collection = o;
+	it->index	   = 0;
+
+	if( o->type->iter_begin != NULL ){
+		o->type->iter_begin( o, it );
+	}
+}
+
+INLINE bool ob_iter_next( ob_iterator_t *it, Object **key, Object **value ){
+	Object *o = it->collection;
+
+	if( o->type->iter_next != NULL ){
+		return o->type->iter_next( o, it, key, value );
+	}
+	/*
+	 * Generic iteration by index, the size is checked at each step
+	 * because the body of the loop could change it.
+	 */
+	if( it->index >= ob_get_size(o) ){
+		return false;
+	}
+
+	it->cursor.value = it->index++;
+	if( key ){
+		*key = (Object *)gc_new_integer( it->cursor.value );
+	}
+	*value = ob_cl_at( o, (Object *)&it->cursor );
+
+	return true;
+}
+
+/*
+ * Binary operators dispatch matrix.
+ *
+ * For each operator, ob_dispatch_table[op][a][b] is the function that
+ * computes 'a op b' given the type codes of a and b, it's the operator
+ * of the left type unless a specialized version for that pair of types
+ * is defined (see src/core/dispatch.cpp), so the right operand type
+ * does not need to be checked again inside the operator.
+ * Entries for types without the operator are NULL and ob_dispatch falls
+ * back to the ob_* function, which triggers the appropriate error.
+ */
+enum H_BINARY_OPERATOR {
+	opAdd = 0,
+	opSub,
+	opMul,
+	opDiv,
+	opMod,
+	opBwAnd,
+	opBwOr,
+	opBwXor,
+	opBwLshift,
+	opBwRshift,
+	opLSame,
+	opLDiff,
+	opLLess,
+	opLGreater,
+	opLLessOrSame,
+	opLGreaterOrSame,
+	opBinaryOperators
+};
+
+extern ob_binary_function_t ob_dispatch_table[opBinaryOperators][H_OBJECT_TYPES][H_OBJECT_TYPES];
+/*
+ * Fill the dispatch matrix, called by vm_init, only the first call
+ * does it.
+ */
+void ob_dispatch_init();
+/*
+ * Generic operator function given its code.
+ */
+Object *ob_dispatch_fallback( H_BINARY_OPERATOR op, Object *a, Object *b );
+
+INLINE Object *ob_dispatch( H_BINARY_OPERATOR op, Object *a, Object *b ){
+	ob_binary_function_t function = ob_dispatch_table[op][a->type->code][b->type->code];
+
+	if( function != NULL ){
+		return function( a, b );
+	}
+
+	return ob_dispatch_fallback( op, a, b );
+}
+
 #endif
 
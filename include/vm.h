@@ -25,6 +25,7 @@
 #include <sys/types.h>
 #include <dirent.h>
 #include <map>
+#include <set>
 #include "types.h"
 #include "memory.h"
 #include "code.h"
@@ -33,6 +34,7 @@
 using std::string;
 using std::vector;
 using std::map;
+using std::set;
 
 /*
  * VM timer flags.
@@ -74,7 +76,7 @@ using std::map;
 /*
  * Macro to define module exported functions structure.
  */
-#define HYBRIS_EXPORTED_FUNCTIONS() extern "C" vm_function_t hybris_module_functions[] =
+#define HYBRIS_EXPORTED_FUNCTIONS() extern "C" vm_function_decl_t hybris_module_functions[] =
 /*
  * Macro to easily access hybris functions parameters.
  */
@@ -82,7 +84,7 @@ using std::map;
 /*
  * Macro to easily access hybris functions parameters number.
  */
-#define vm_argc()     (data->size())
+#define vm_argc()     (data->argc())
 /*
  * Pre declaration of structure vm_t.
  */
@@ -96,6 +98,51 @@ typedef void     (*initializer_t)( vm_t * );
  */
 typedef Object * (*function_t)( vm_t *, vmem_t * );
 
+/*
+ * Maximum number of arguments numbers (see H_REQ_ARGC) and of typed
+ * arguments (see H_REQ_TYPES) a module function can declare.
+ */
+#define H_MAX_ARGC_VARIANTS 8
+#define H_MAX_TYPED_ARGS	16
+/*
+ * Exported function declaration, as found in the module
+ * hybris_module_functions array.
+ */
+typedef struct _vm_function_decl_t {
+	/*
+	 * Function identifier.
+	 */
+	const char   *identifier;
+	/*
+	 * Function pointer.
+	 */
+	function_t    function;
+	/*
+	 * Numbers of arguments required, terminated by -1.
+	 */
+	int		      argc[H_MAX_ARGC_VARIANTS];
+	/*
+	 * Allowed types of each argument, terminated by otEndMarker.
+	 */
+	H_OBJECT_TYPE types[H_MAX_TYPED_ARGS][H_OBJECT_TYPES + 1];
+}
+vm_function_decl_t;
+/*
+ * A module linked into the interpreter executable (see HYBRIS_STATIC_STDLIB),
+ * 'path' is relative to LIB_PATH and without the DYN_EXT extension
+ * (i.e. "std/io/file"), 'initializer' is NULL if the module has none.
+ */
+typedef struct _vm_static_module_t {
+	const char 		   *path;
+	vm_function_decl_t *functions;
+	initializer_t		initializer;
+}
+vm_static_module_t;
+/*
+ * Bit of type 'code' inside an argument types mask.
+ */
+#define H_TYPE_BIT(code) (1UL << (code))
+
 typedef struct _vm_function_t {
 	/*
 	 * Function identifier.
@@ -106,13 +153,14 @@ typedef struct _vm_function_t {
      */
     function_t    function;
     /*
-     * Number of arguments required.
+     * Numbers of arguments required, terminated by -1.
      */
-    int		      argc[HMAXARGS];
+    vector<int>	  argc;
     /*
-     * Allowed types of each argument.
+     * Mask of the allowed types (see H_TYPE_BIT) of each argument,
+     * arguments without a mask (or with a 0 mask) accept any type.
      */
-    H_OBJECT_TYPE types[HMAXARGS][20];
+    vector<ulong> types;
 }
 vm_function_t;
 
@@ -128,11 +176,18 @@ typedef struct vm_module {
 	void	      *handle;
     vector<string> domains;
     string         name;
+    string		   path;
     initializer_t  initializer;
     llist_t		   functions;
+    /*
+     * Names of the constants and structures defined by the module
+     * initializer, used to generate namespace manifests.
+     */
+    vector<string> constants;
 
     vm_module( string& module_name, string& module_path, void *ptr, initializer_t init ) :
     	name(module_name),
+    	path(module_path),
     	handle(ptr),
     	initializer(init){
 
@@ -150,9 +205,31 @@ typedef struct vm_module {
 }
 vm_module_t;
 
+/*
+ * A module listed in a namespace manifest (see vm_load_manifest) and not
+ * opened yet, it will be loaded once one of its symbols is first resolved.
+ */
+typedef struct _vm_lazy_module_t {
+	string path;
+	string name;
+	/*
+	 * Time spent loading the module when the manifest was generated.
+	 */
+	ulong  usecs;
+	bool   loaded;
+}
+vm_lazy_module_t;
+
+/*
+ * File name of the manifest inside each library directory.
+ */
+#define VM_MANIFEST_NAME "modules.manifest"
+
 typedef llist_t				      	  vm_modules_t;
+typedef ITree<vm_lazy_module_t>		  vm_lazy_index_t;
 typedef ITree<vm_function_t> 	  	  vm_mcache_t;
 typedef ITree<pcre>					  vm_pcache_t;
+typedef ITree<node_ast_t>			  vm_ast_cache_t;
 typedef llist_t		 			  	  vm_scope_t;
 typedef map< pthread_t, vm_scope_t *> vm_thread_scope_t;
 
@@ -188,7 +265,10 @@ typedef struct _vm_t {
 	#define VM_MCACHE_MUTEX 4
 	#define VM_PCRE_MUTEX 	5
 	#define VM_TSYNC_MUTEX  6
-	#define VM_MUTEXES 	    7
+	#define VM_SWITCH_MUTEX 7
+	#define VM_LAZY_MUTEX   8
+	#define VM_AST_MUTEX    9
+	#define VM_MUTEXES 	    10
 
 	pthread_mutex_t mutexes[VM_MUTEXES];
 
@@ -213,6 +293,17 @@ typedef struct _vm_t {
 	 * Current executing/parsing line number.
 	 */
 	size_t lineno;
+	/*
+	 * Files being parsed and line numbers to restore when an included
+	 * file ends.
+	 */
+	vector<string> files;
+	vector<int>	   lines;
+	/*
+	 * Canonical paths of the files already included, each file is
+	 * parsed only the first time it's included.
+	 */
+	set<string>	   included;
 	/*
 	 * The list of active memory frames on the main thread.
 	 */
@@ -243,17 +334,45 @@ typedef struct _vm_t {
 	 */
 	vmem_t vtypes;
 	/*
-	 * Functions lookup hashtable cache.
+	 * Functions exported by the loaded modules, indexed by name.
 	 */
 	vm_mcache_t mcache;
 	/*
 	 * Dynamically loaded modules instances.
 	 */
 	vm_modules_t modules;
+	/*
+	 * Modules linked into the executable, terminated by a NULL path,
+	 * or NULL if there are none.
+	 */
+	vm_static_module_t *statics;
+	/*
+	 * Modules listed by the imported namespaces manifests, and their
+	 * functions and constants names indexing them.
+	 */
+	vector<vm_lazy_module_t *> deferred;
+	vm_lazy_index_t			   lazy;
+	/*
+	 * The module whose initializer is running, if any.
+	 */
+	vm_module_t				  *loading;
 	/*
 	 * Compiled regular expressions cache.
 	 */
 	vm_pcache_t pcre_cache;
+	/*
+	 * Parsed trees of loaded files, indexed by canonical path, and of
+	 * evaluated strings, indexed by the string itself, used when the
+	 * ast cache is enabled.
+	 * Their constants are allocated in this vm heap, so each vm has
+	 * its own caches.
+	 */
+	vm_ast_cache_t ast_files;
+	vm_ast_cache_t ast_strings;
+	/*
+	 * Objects heap of this vm (see gc.h).
+	 */
+	gc_t gc;
 	/*
 	 * Flag set to true when vm_release is called, used to prevent
 	 * recursive calls when an error is triggered inside a class destructor.
@@ -278,11 +397,27 @@ vm_t;
 #define vm_pcre_unlock( vm )    pthread_mutex_unlock( &vm->mutexes[VM_PCRE_MUTEX] )
 #define vm_tsync_lock( vm )     pthread_mutex_lock( &vm->mutexes[VM_TSYNC_MUTEX] )
 #define vm_tsync_unlock( vm )   pthread_mutex_unlock( &vm->mutexes[VM_TSYNC_MUTEX] )
+#define vm_switch_lock( vm )    pthread_mutex_lock( &vm->mutexes[VM_SWITCH_MUTEX] )
+#define vm_switch_unlock( vm )  pthread_mutex_unlock( &vm->mutexes[VM_SWITCH_MUTEX] )
+#define vm_lazy_lock( vm )      pthread_mutex_lock( &vm->mutexes[VM_LAZY_MUTEX] )
+#define vm_lazy_unlock( vm )    pthread_mutex_unlock( &vm->mutexes[VM_LAZY_MUTEX] )
+#define vm_ast_lock( vm )       pthread_mutex_lock( &vm->mutexes[VM_AST_MUTEX] )
+#define vm_ast_unlock( vm )     pthread_mutex_unlock( &vm->mutexes[VM_AST_MUTEX] )
 
 /*
- * Alloc a virtual machine instance.
+ * Alloc a virtual machine instance and make it the current one
+ * of the calling thread.
  */
 vm_t 	   *vm_create();
+/*
+ * Each thread runs one vm at a time, the current one, whose heap
+ * tracks the objects allocated by the thread and which runs class
+ * descriptors and exceptions raised outside of vm_exec.
+ * Threads executing code of a vm they did not create must make it
+ * current first.
+ */
+vm_t 	   *vm_current();
+void		vm_set_current( vm_t *vm );
 /*
  * Initialize the virtual machine attributes and global constants.
  */
@@ -325,9 +460,41 @@ void    	vm_load_module( vm_t *vm, string path, string name );
  */
 void		vm_load_module( vm_t *vm, char *module );
 /*
- * Handle an entire namespace modules loading.
+ * Handle an entire namespace modules loading, if the namespace has a
+ * manifest its modules will be loaded on first use (see vm_lazy_load).
  */
 void   		vm_load_namespace( vm_t *vm, string path );
+/*
+ * Index the modules listed in the manifest of 'path' without opening
+ * them, return false if there's no manifest.
+ */
+bool		vm_load_manifest( vm_t *vm, string path );
+/*
+ * Load every module under 'path' and write the manifest of each
+ * directory of the tree.
+ */
+void		vm_write_manifest( vm_t *vm, string path );
+/*
+ * Load the not yet opened module exporting 'identifier', return true
+ * if such a module exists (and is now loaded).
+ */
+bool		vm_lazy_load( vm_t *vm, char *identifier );
+/*
+ * Print how many manifest modules were never loaded and the load time
+ * saved by not opening them.
+ */
+void		vm_lazy_report( vm_t *vm );
+/*
+ * Write the loaded modules, user functions, types and global variables
+ * to 'filename', so another process can start from this state instead
+ * of executing the same prelude (see vm_snapshot_load).
+ */
+void		vm_snapshot_save( vm_t *vm, const char *filename );
+/*
+ * Restore the state written by vm_snapshot_save into a newly
+ * initialized vm.
+ */
+void		vm_snapshot_load( vm_t *vm, const char *filename );
 /*
  * Throw an exception inside the script, causing the active frame,
  * if any, to be set with an exception state.
@@ -451,50 +618,39 @@ INLINE void vm_timer( vm_t *vm, int start = 0 ){
             char buffer[0xFF] = {0};
             hyb_timediff( vm->args.tm_end - vm->args.tm_start, buffer );
             fprintf( stdout, "\033[01;33m[TIME] Elapsed %s .\n\033[00m", buffer );
+            vm_lazy_report( vm );
         }
     }
 }
+/*
+ * Lookup a function among the ones of the loaded modules, without
+ * loading anything.
+ * A module could be loaded by another thread in the meanwhile, resizing
+ * the index, so it's only accessed with the mcache mutex locked.
+ */
+INLINE vm_function_t *vm_find_function( vm_t *vm, char *identifier ){
+	vm_function_t *function;
+
+	vm_mcache_lock( vm );
+	function = vm->mcache.find(identifier);
+	vm_mcache_unlock( vm );
+
+	return function;
+}
 /*
  * Find out if a function has been registered by some previously
  * loaded module and return its pointer.
- * Handle function pointer caching.
+ * Every exported function is indexed when its module is loaded
+ * (see vm_load_module), so a miss is answered by the lookup itself,
+ * unless the function belongs to a module that is not loaded yet.
  */
 INLINE vm_function_t *vm_get_function( vm_t *vm, char *identifier ){
-	vm_module_t   *module;
 	vm_function_t *function;
 
-	/*
-	 * First check if it's already cached.
-	 */
-	if( (function = vm->mcache.find(identifier)) != H_UNDEFINED ){
-		return function;
+	if( (function = vm_find_function( vm, identifier )) == H_UNDEFINED && vm_lazy_load( vm, identifier ) ){
+		function = vm_find_function( vm, identifier );
 	}
-	/*
-	 * Search it in dynamic loaded modules.
-	 */
-	ll_foreach( &vm->modules, m_item ){
-		module = ll_data( vm_module_t *, m_item );
-		/*
-		 * For each function of the module.
-		 */
-		ll_foreach( &module->functions, f_item ){
-			function = ll_data( vm_function_t *, f_item );
-			/*
-			 * Found it, add to the cache and return.
-			 */
-			if( function->identifier == identifier ){
-				vm_mcache_lock( vm );
-					vm->mcache.insert( identifier, function );
-				vm_mcache_unlock( vm );
-
-				return function;
-			}
-		}
-	}
-	/*
-	 * Nothing found, function not defined, nor cached.
-	 */
-	return H_UNDEFINED;
+	return function;
 }
 
 /*
@@ -507,6 +663,9 @@ INLINE Object * vm_define_structure( vm_t *vm, char *name, size_t nattrs, char *
    for( i = 0; i < nattrs; ++i ){
 	   ob_add_attribute( (Object *)type, attributes[i] );
    }
+   if( vm->loading ){
+	   vm->loading->constants.push_back(name);
+   }
   /*
    * Prevent the structure or class definition from being deleted by the gc.
    */
@@ -517,6 +676,9 @@ INLINE Object * vm_define_structure( vm_t *vm, char *name, size_t nattrs, char *
  * created object.
  */
 INLINE void vm_define_constant( vm_t *vm, char *name, Object *value ){
+   if( vm->loading ){
+	   vm->loading->constants.push_back(name);
+   }
   /*
    * Prevent the structure or class definition from being deleted by the gc.
    */
@@ -529,7 +691,12 @@ INLINE void vm_define_constant( vm_t *vm, char *name, Object *value ){
  * Find the object pointer of a user defined type (i.e. structures or classes).
  */
 INLINE Object * vm_get_type( vm_t *vm, char *name ){
-   return vm->vtypes.find(name);
+   Object *type;
+
+   if( (type = vm->vtypes.find(name)) == H_UNDEFINED && vm_lazy_load( vm, name ) ){
+	   type = vm->vtypes.find(name);
+   }
+   return type;
 }
 /*
  * Compile a regular expression and put it in a global cache.
@@ -597,12 +764,33 @@ void vm_parse_frame_argv( vframe_t *argv, char *format, ... );
 void 	  vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner, Object *cobj, int argc, Node *prototype, Node *argv );
 void 	  vm_prepare_stack( vm_t *vm, vframe_t &stack, string owner, Object *cobj, Node *ids, int argc, ... );
 void 	  vm_prepare_stack( vm_t *vm, vframe_t &stack, string owner, vector<string> ids, vmem_t *argv );
-void 	  vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner, vector<string> ids, Node *argv );
 void 	  vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner, Extern *fn_pointer, Node *argv );
 void 	  vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner, Node *argv );
 void 	  vm_prepare_stack( vm_t *vm, vframe_t *root, vm_function_t *function, vframe_t &stack, string owner, Node *argv );
 void 	  vm_prepare_stack( vm_t *vm, vframe_t *root, Node *function, vframe_t &stack, string owner, Node *argv );
+void 	  vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, FunctionNode *function, Node *argv );
 void 	  vm_dismiss_stack( vm_t *vm );
+/*
+ * Check the arguments of a call to a module function against its argc
+ * descriptors and types masks, on failure set 'error' and return false.
+ * vm_check_argc sets 'f_argc' to the matching descriptor, that is then
+ * given to vm_check_argv for each i-th argument.
+ */
+bool	  vm_check_argc( vm_function_t *function, int argc, int& f_argc, string& error );
+bool	  vm_check_argv( vm_function_t *function, int f_argc, int i, Object *value, string& error );
+/*
+ * Max number of released frames each thread keeps for reuse, and
+ * max number of names a frame is presized for.
+ */
+#define VM_FRAME_POOL_SIZE 128
+#define VM_FRAME_MAX_SIZE  64
+/*
+ * Get a frame able to hold 'size' names from the pool of the current
+ * thread (allocating a new one if the pool is empty), and put it back
+ * once the call is done.
+ */
+vframe_t *vm_frame_acquire( size_t size );
+void	  vm_frame_release( vframe_t *frame );
 /*
  * Handle hybris builtin function call.
  */
@@ -620,6 +808,11 @@ Object   *vm_exec_dll_function_call( vm_t *vm, vframe_t *, Node * );
  */
 Object   *vm_exec_threaded_call( vm_t *vm, string function_name, vmem_t *argv );
 Object   *vm_exec_threaded_call( vm_t *vm, Node *function, vframe_t *frame, vmem_t *argv );
+/*
+ * Call a user defined function with the values already pushed on 'argv',
+ * an unhandled exception is put on 'frame'.
+ */
+Object   *vm_exec_function( vm_t *vm, vframe_t *frame, FunctionNode *function, vmem_t *argv );
 /*
  * Node handler dispatcher.
  */
@@ -633,6 +826,17 @@ Object 	 *vm_exec_identifier( vm_t *vm, vframe_t *, Node * );
  * it's a class or a structure, and then lookup inside it the second one.
  */
 Object   *vm_exec_attribute_request( vm_t *vm, vframe_t *, Node * );
+/*
+ * Lookup the attribute requested by 'node' inside the already evaluated
+ * owner object, checking its access specifier.
+ */
+Object   *vm_get_attribute( Object *, Node * );
+/*
+ * Evaluate an expression which is going to be modified in place (target
+ * of inplace operators, subscript and attribute setting, references and
+ * method calls), unsharing copy on write collections it subscripts.
+ */
+Object   *vm_exec_lvalue( vm_t *vm, vframe_t *, Node * );
 /*
  * expression->expression(...), evaluate first expression to find out if
  * it's a class or a structure, and then lookup inside it the second one.
@@ -685,6 +889,7 @@ Object   *vm_exec_while( vm_t *vm, vframe_t *, Node * );
 Object   *vm_exec_do( vm_t *vm, vframe_t *, Node * );
 Object   *vm_exec_for( vm_t *vm, vframe_t *, Node * );
 Object   *vm_exec_foreach( vm_t *vm, vframe_t *, Node * );
+Object   *vm_exec_foreach_range( vm_t *vm, vframe_t *, Node *, Object *, Object * );
 Object   *vm_exec_foreach_mapping( vm_t *vm, vframe_t *, Node * );
 Object   *vm_exec_unless( vm_t *vm, vframe_t *, Node * );
 Object   *vm_exec_if( vm_t *vm, vframe_t *, Node * );
@@ -30,7 +30,7 @@
 #define MAX_MESSAGE_SIZE MAX_STRING_SIZE + 0xFF
 
 void yyerror( char *error ){
-    extern vm_t *__hyb_vm;
+    vm_t *vm = vm_current();
 
     /*
      * Make sure first character is uppercase.
@@ -41,7 +41,7 @@ void yyerror( char *error ){
      * If we are in CGI mode (stderr redirected to stdout), remove
      * all color bytes from the error string.
      */
-    if( __hyb_vm->args.cgi_mode && strchr( error, '\033' ) ){
+    if( vm->args.cgi_mode && strchr( error, '\033' ) ){
     	error += strlen( "\033[0133m" ) + 1;
     	*strrchr( error, '\033' ) = 0x00;
     }
@@ -51,7 +51,7 @@ void yyerror( char *error ){
      * Print line number only for syntax errors.
      */
     if( strstr( error, "Syntax error" ) ){
-    	fprintf( stderr, "[LINE %d] %s%c", vm_get_lineno(__hyb_vm), error, (strchr( error, '\n' ) ? 0x00 : '\n') );
+    	fprintf( stderr, "[LINE %d] %s%c", vm_get_lineno(vm), error, (strchr( error, '\n' ) ? 0x00 : '\n') );
     }
     else{
     	fprintf( stderr, "%s%c", error, (strchr( error, '\n' ) ? 0x00 : '\n') );
@@ -61,7 +61,7 @@ void yyerror( char *error ){
 	* If the error was triggered by a SIGSEGV signal, force
 	* the stack trace to printed.
 	*/
-	vm_print_stack_trace( __hyb_vm, (strstr( error, "SIGSEGV Signal Catched" ) != NULL) );
+	vm_print_stack_trace( vm, (strstr( error, "SIGSEGV Signal Catched" ) != NULL) );
 	/*
 	 * If an error occurred during releasing phase, an error in one class destructor
 	 * called from gc_release for instance, prevent to call those methods recursively.
@@ -69,12 +69,12 @@ void yyerror( char *error ){
 	 *
 	 * Fixes #575284
 	 */
-    if( __hyb_vm->releasing == false ){
+    if( vm->releasing == false ){
 
-		vm_fclose( __hyb_vm );
-		vm_release( __hyb_vm );
+		vm_fclose( vm );
+		vm_release( vm );
 
-		delete __hyb_vm;
+		vm_free( vm );
 	}
 
 	exit(-1);
@@ -0,0 +1,241 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "hybris.h"
+#include <math.h>
+
+ob_binary_function_t ob_dispatch_table[opBinaryOperators][H_OBJECT_TYPES][H_OBJECT_TYPES];
+
+/*
+ * Helper macro to define an operator specialized for a pair of types,
+ * 'a' and 'b' are the operands casted to their types.
+ */
+#define DEFINE_FUSED_OPERATOR( name, atype, btype, rtype, expr ) \
+	static Object *name( Object *me, Object *op ){ \
+		atype *a = (atype *)me; \
+		btype *b = (btype *)op; \
+		return (Object *)gc_new_ ## rtype( expr ); \
+	}
+
+/*
+ * integer op integer, the same results of int_* operators.
+ */
+DEFINE_FUSED_OPERATOR( ii_add, Integer, Integer, integer, a->value + b->value )
+DEFINE_FUSED_OPERATOR( ii_sub, Integer, Integer, integer, a->value - b->value )
+DEFINE_FUSED_OPERATOR( ii_mul, Integer, Integer, integer, a->value * b->value )
+DEFINE_FUSED_OPERATOR( ii_div, Integer, Integer, integer, a->value / b->value )
+DEFINE_FUSED_OPERATOR( ii_mod, Integer, Integer, integer, (b->value == 0 || b->value == 1 ? 0 : (b->value & (b->value - 1)) == 0 ? a->value & (b->value - 1) : a->value % b->value) )
+DEFINE_FUSED_OPERATOR( ii_bw_and, Integer, Integer, integer, a->value & b->value )
+DEFINE_FUSED_OPERATOR( ii_bw_or, Integer, Integer, integer, a->value | b->value )
+DEFINE_FUSED_OPERATOR( ii_bw_xor, Integer, Integer, integer, a->value ^ b->value )
+DEFINE_FUSED_OPERATOR( ii_bw_lshift, Integer, Integer, integer, a->value << b->value )
+DEFINE_FUSED_OPERATOR( ii_bw_rshift, Integer, Integer, integer, a->value >> b->value )
+DEFINE_FUSED_OPERATOR( ii_l_same, Integer, Integer, integer, a->value == b->value )
+DEFINE_FUSED_OPERATOR( ii_l_diff, Integer, Integer, integer, a->value != b->value )
+DEFINE_FUSED_OPERATOR( ii_l_less, Integer, Integer, integer, a->value < b->value )
+DEFINE_FUSED_OPERATOR( ii_l_greater, Integer, Integer, integer, a->value > b->value )
+DEFINE_FUSED_OPERATOR( ii_l_less_or_same, Integer, Integer, integer, a->value <= b->value )
+DEFINE_FUSED_OPERATOR( ii_l_greater_or_same, Integer, Integer, integer, a->value >= b->value )
+/*
+ * integer op float, the right operand is truncated as int_* operators do.
+ */
+DEFINE_FUSED_OPERATOR( if_add, Integer, Float, integer, a->value + (long)b->value )
+DEFINE_FUSED_OPERATOR( if_sub, Integer, Float, integer, a->value - (long)b->value )
+DEFINE_FUSED_OPERATOR( if_mul, Integer, Float, integer, a->value * (long)b->value )
+DEFINE_FUSED_OPERATOR( if_div, Integer, Float, integer, a->value / (long)b->value )
+DEFINE_FUSED_OPERATOR( if_l_same, Integer, Float, integer, a->value == (long)b->value )
+DEFINE_FUSED_OPERATOR( if_l_diff, Integer, Float, integer, a->value != (long)b->value )
+DEFINE_FUSED_OPERATOR( if_l_less, Integer, Float, integer, a->value < (long)b->value )
+DEFINE_FUSED_OPERATOR( if_l_greater, Integer, Float, integer, a->value > (long)b->value )
+DEFINE_FUSED_OPERATOR( if_l_less_or_same, Integer, Float, integer, a->value <= (long)b->value )
+DEFINE_FUSED_OPERATOR( if_l_greater_or_same, Integer, Float, integer, a->value >= (long)b->value )
+/*
+ * float op float, the same results of float_* operators.
+ */
+DEFINE_FUSED_OPERATOR( ff_add, Float, Float, float, a->value + b->value )
+DEFINE_FUSED_OPERATOR( ff_sub, Float, Float, float, a->value - b->value )
+DEFINE_FUSED_OPERATOR( ff_mul, Float, Float, float, a->value * b->value )
+DEFINE_FUSED_OPERATOR( ff_div, Float, Float, float, a->value / b->value )
+DEFINE_FUSED_OPERATOR( ff_mod, Float, Float, float, fmod( a->value, b->value ) )
+DEFINE_FUSED_OPERATOR( ff_l_same, Float, Float, float, a->value == b->value )
+DEFINE_FUSED_OPERATOR( ff_l_diff, Float, Float, float, a->value != b->value )
+DEFINE_FUSED_OPERATOR( ff_l_less, Float, Float, float, a->value < b->value )
+DEFINE_FUSED_OPERATOR( ff_l_greater, Float, Float, float, a->value > b->value )
+DEFINE_FUSED_OPERATOR( ff_l_less_or_same, Float, Float, float, a->value <= b->value )
+DEFINE_FUSED_OPERATOR( ff_l_greater_or_same, Float, Float, float, a->value >= b->value )
+/*
+ * float op integer, the right operand is promoted as float_* operators do.
+ */
+DEFINE_FUSED_OPERATOR( fi_add, Float, Integer, float, a->value + (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_sub, Float, Integer, float, a->value - (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_mul, Float, Integer, float, a->value * (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_div, Float, Integer, float, a->value / (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_mod, Float, Integer, float, fmod( a->value, (double)b->value ) )
+DEFINE_FUSED_OPERATOR( fi_l_same, Float, Integer, float, a->value == (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_l_diff, Float, Integer, float, a->value != (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_l_less, Float, Integer, float, a->value < (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_l_greater, Float, Integer, float, a->value > (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_l_less_or_same, Float, Integer, float, a->value <= (double)b->value )
+DEFINE_FUSED_OPERATOR( fi_l_greater_or_same, Float, Integer, float, a->value >= (double)b->value )
+
+/*
+ * Get the function pointer of the operator 'op' for the type 't'.
+ */
+static ob_binary_function_t ob_type_operator( object_type_t *t, H_BINARY_OPERATOR op ){
+	switch( op ){
+		case opAdd 			  : return t->add;
+		case opSub 			  : return t->sub;
+		case opMul 			  : return t->mul;
+		case opDiv 			  : return t->div;
+		case opMod 			  : return t->mod;
+		case opBwAnd 		  : return t->bw_and;
+		case opBwOr 		  : return t->bw_or;
+		case opBwXor 		  : return t->bw_xor;
+		case opBwLshift 	  : return t->bw_lshift;
+		case opBwRshift 	  : return t->bw_rshift;
+		case opLSame 		  : return t->l_same;
+		case opLDiff 		  : return t->l_diff;
+		case opLLess 		  : return t->l_less;
+		case opLGreater 	  : return t->l_greater;
+		case opLLessOrSame 	  : return t->l_less_or_same;
+		case opLGreaterOrSame : return t->l_greater_or_same;
+	}
+
+	return NULL;
+}
+
+static pthread_once_t __ob_dispatch_once = PTHREAD_ONCE_INIT;
+
+static void ob_dispatch_fill(){
+	/*
+	 * Every implemented type, indexed by its code.
+	 */
+	object_type_t *types[H_OBJECT_TYPES] = { NULL };
+	int			   op, a, b;
+
+	types[otBoolean]    = &Boolean_Type;
+	types[otInteger]    = &Integer_Type;
+	types[otFloat]      = &Float_Type;
+	types[otChar]       = &Char_Type;
+	types[otString]     = &String_Type;
+	types[otBinary]     = &Binary_Type;
+	types[otVector]     = &Vector_Type;
+	types[otMap]        = &Map_Type;
+	types[otAlias]      = &Alias_Type;
+	types[otExtern]     = &Extern_Type;
+	types[otHandle]     = &Handle_Type;
+	types[otStructure]  = &Structure_Type;
+	types[otClass]      = &Class_Type;
+	types[otReference]  = &Reference_Type;
+	types[otIntArray]   = &IntArray_Type;
+	types[otFloatArray] = &FloatArray_Type;
+
+	for( op = 0; op < opBinaryOperators; ++op ){
+		for( a = 0; a < H_OBJECT_TYPES; ++a ){
+			for( b = 0; b < H_OBJECT_TYPES; ++b ){
+				ob_dispatch_table[op][a][b] = (types[a] ? ob_type_operator( types[a], (H_BINARY_OPERATOR)op ) : NULL);
+			}
+		}
+	}
+
+#define SET_FUSED( op, a, b, function ) ob_dispatch_table[op][a][b] = function
+
+	SET_FUSED( opAdd, 			 otInteger, otInteger, ii_add );
+	SET_FUSED( opSub, 			 otInteger, otInteger, ii_sub );
+	SET_FUSED( opMul, 			 otInteger, otInteger, ii_mul );
+	SET_FUSED( opDiv, 			 otInteger, otInteger, ii_div );
+	SET_FUSED( opMod, 			 otInteger, otInteger, ii_mod );
+	SET_FUSED( opBwAnd, 		 otInteger, otInteger, ii_bw_and );
+	SET_FUSED( opBwOr, 			 otInteger, otInteger, ii_bw_or );
+	SET_FUSED( opBwXor, 		 otInteger, otInteger, ii_bw_xor );
+	SET_FUSED( opBwLshift, 		 otInteger, otInteger, ii_bw_lshift );
+	SET_FUSED( opBwRshift, 		 otInteger, otInteger, ii_bw_rshift );
+	SET_FUSED( opLSame, 		 otInteger, otInteger, ii_l_same );
+	SET_FUSED( opLDiff, 		 otInteger, otInteger, ii_l_diff );
+	SET_FUSED( opLLess, 		 otInteger, otInteger, ii_l_less );
+	SET_FUSED( opLGreater, 		 otInteger, otInteger, ii_l_greater );
+	SET_FUSED( opLLessOrSame, 	 otInteger, otInteger, ii_l_less_or_same );
+	SET_FUSED( opLGreaterOrSame, otInteger, otInteger, ii_l_greater_or_same );
+
+	SET_FUSED( opAdd, 			 otInteger, otFloat, if_add );
+	SET_FUSED( opSub, 			 otInteger, otFloat, if_sub );
+	SET_FUSED( opMul, 			 otInteger, otFloat, if_mul );
+	SET_FUSED( opDiv, 			 otInteger, otFloat, if_div );
+	SET_FUSED( opLSame, 		 otInteger, otFloat, if_l_same );
+	SET_FUSED( opLDiff, 		 otInteger, otFloat, if_l_diff );
+	SET_FUSED( opLLess, 		 otInteger, otFloat, if_l_less );
+	SET_FUSED( opLGreater, 		 otInteger, otFloat, if_l_greater );
+	SET_FUSED( opLLessOrSame, 	 otInteger, otFloat, if_l_less_or_same );
+	SET_FUSED( opLGreaterOrSame, otInteger, otFloat, if_l_greater_or_same );
+
+	SET_FUSED( opAdd, 			 otFloat, otFloat, ff_add );
+	SET_FUSED( opSub, 			 otFloat, otFloat, ff_sub );
+	SET_FUSED( opMul, 			 otFloat, otFloat, ff_mul );
+	SET_FUSED( opDiv, 			 otFloat, otFloat, ff_div );
+	SET_FUSED( opMod, 			 otFloat, otFloat, ff_mod );
+	SET_FUSED( opLSame, 		 otFloat, otFloat, ff_l_same );
+	SET_FUSED( opLDiff, 		 otFloat, otFloat, ff_l_diff );
+	SET_FUSED( opLLess, 		 otFloat, otFloat, ff_l_less );
+	SET_FUSED( opLGreater, 		 otFloat, otFloat, ff_l_greater );
+	SET_FUSED( opLLessOrSame, 	 otFloat, otFloat, ff_l_less_or_same );
+	SET_FUSED( opLGreaterOrSame, otFloat, otFloat, ff_l_greater_or_same );
+
+	SET_FUSED( opAdd, 			 otFloat, otInteger, fi_add );
+	SET_FUSED( opSub, 			 otFloat, otInteger, fi_sub );
+	SET_FUSED( opMul, 			 otFloat, otInteger, fi_mul );
+	SET_FUSED( opDiv, 			 otFloat, otInteger, fi_div );
+	SET_FUSED( opMod, 			 otFloat, otInteger, fi_mod );
+	SET_FUSED( opLSame, 		 otFloat, otInteger, fi_l_same );
+	SET_FUSED( opLDiff, 		 otFloat, otInteger, fi_l_diff );
+	SET_FUSED( opLLess, 		 otFloat, otInteger, fi_l_less );
+	SET_FUSED( opLGreater, 		 otFloat, otInteger, fi_l_greater );
+	SET_FUSED( opLLessOrSame, 	 otFloat, otInteger, fi_l_less_or_same );
+	SET_FUSED( opLGreaterOrSame, otFloat, otInteger, fi_l_greater_or_same );
+
+#undef SET_FUSED
+}
+/*
+ * The matrix is shared by every vm, vms running on other threads could
+ * be reading it while a new one is initialized, so fill it just once.
+ */
+void ob_dispatch_init(){
+	pthread_once( &__ob_dispatch_once, ob_dispatch_fill );
+}
+
+Object *ob_dispatch_fallback( H_BINARY_OPERATOR op, Object *a, Object *b ){
+	switch( op ){
+		case opAdd 			  : return ob_add( a, b );
+		case opSub 			  : return ob_sub( a, b );
+		case opMul 			  : return ob_mul( a, b );
+		case opDiv 			  : return ob_div( a, b );
+		case opMod 			  : return ob_mod( a, b );
+		case opBwAnd 		  : return ob_bw_and( a, b );
+		case opBwOr 		  : return ob_bw_or( a, b );
+		case opBwXor 		  : return ob_bw_xor( a, b );
+		case opBwLshift 	  : return ob_bw_lshift( a, b );
+		case opBwRshift 	  : return ob_bw_rshift( a, b );
+		case opLSame 		  : return ob_l_same( a, b );
+		case opLDiff 		  : return ob_l_diff( a, b );
+		case opLLess 		  : return ob_l_less( a, b );
+		case opLGreater 	  : return ob_l_greater( a, b );
+		case opLLessOrSame 	  : return ob_l_less_or_same( a, b );
+		case opLGreaterOrSame : return ob_l_greater_or_same( a, b );
+	}
+
+	return H_UNDEFINED;
+}
@@ -20,39 +20,145 @@
 #include "memory.h"
 
 NodeValue::NodeValue() :
-    constant(NULL),
     identifier(""),
-    function(""),
-    method(""),
-    access(asPublic),
-    is_static(false),
-    call(""),
+    switch_table(NULL),
     argc(0),
-    alias(NULL),
-    switch_block(NULL),
-    default_block(NULL),
-    owner(NULL),
-    member(NULL),
-    try_block(NULL),
-    exception_id(""),
-    catch_block(NULL),
-    finally_block(NULL) {
+    access(asPublic),
+    vargs(false),
+    is_static(false) {
+	/*
+	 * The largest member of the union, so every other member is NULL.
+	 */
+	ll_init( &extends );
+}
+
+/*
+ * Arena nodes are allocated from, per thread.
+ */
+static pthread_key_t  __node_arena_key;
+static pthread_once_t __node_arena_once = PTHREAD_ONCE_INIT;
+
+static void node_arena_key_create(){
+	pthread_key_create( &__node_arena_key, NULL );
+}
+
+INLINE node_arena_t *node_arena_current(){
+	pthread_once( &__node_arena_once, node_arena_key_create );
+
+	return (node_arena_t *)pthread_getspecific( __node_arena_key );
+}
+
+node_arena_t *node_arena_begin(){
+	node_arena_t *arena = new node_arena_t;
+
+	arena->used = NODE_ARENA_CHUNK_SIZE;
+
+	pthread_once( &__node_arena_once, node_arena_key_create );
+	pthread_setspecific( __node_arena_key, arena );
+
+	return arena;
+}
+
+node_arena_t *node_arena_end(){
+	node_arena_t *arena = node_arena_current();
+
+	pthread_setspecific( __node_arena_key, NULL );
 
+	return arena;
+}
+
+void node_arena_release( node_arena_t *arena ){
+	if( arena != NULL ){
+		for( size_t i = 0; i < arena->chunks.size(); ++i ){
+			free( arena->chunks[i] );
+		}
+		delete arena;
+	}
+}
+
+void node_ast_release( node_ast_t *ast ){
+	delete ast->root;
+
+	node_arena_release( ast->arena );
+
+	ast->root  = NULL;
+	ast->arena = NULL;
+}
+
+/*
+ * Every node is preceded by a word telling if it was allocated
+ * from an arena (so its memory is released with the arena itself)
+ * or from the heap.
+ */
+#define NODE_ALLOC_HEAP  0
+#define NODE_ALLOC_ARENA 1
+
+void *Node::operator new( size_t size ){
+	node_arena_t *arena = node_arena_current();
+	size_t       *block;
+
+	size = sizeof(size_t) + ((size + sizeof(void *) - 1) & ~(sizeof(void *) - 1));
+
+	if( arena == NULL ){
+		block    = (size_t *)malloc(size);
+		block[0] = NODE_ALLOC_HEAP;
+	}
+	else{
+		if( arena->used + size > NODE_ARENA_CHUNK_SIZE ){
+			arena->chunks.push_back( (char *)malloc(NODE_ARENA_CHUNK_SIZE) );
+			arena->used = 0;
+		}
+
+		block 		 = (size_t *)(arena->chunks.back() + arena->used);
+		block[0] 	 = NODE_ALLOC_ARENA;
+		arena->used += size;
+	}
+
+	return block + 1;
+}
+
+void Node::operator delete( void *p ){
+	if( p != NULL && ((size_t *)p)[-1] == NODE_ALLOC_HEAP ){
+		free( (size_t *)p - 1 );
+	}
 }
 
 Node::Node() : type(H_NT_NONE), lineno(0), body(NULL) {
-	ll_init( &children );
+	children.nodes = NULL;
+	children.items = children.size = 0;
 }
 
 Node::Node( H_NODE_TYPE type, size_t lineno ) : type(type), opcode(type), lineno(lineno), body(NULL) {
-	ll_init( &children );
+	children.nodes = NULL;
+	children.items = children.size = 0;
 }
 
 Node::~Node(){
-	ll_foreach( &children, child ){
-		delete ll_node( child );
+	for( size_t i = 0; i < children.items; ++i ){
+		delete children.nodes[i];
+	}
+	if( children.nodes != NULL ){
+		free( children.nodes );
+	}
+
+	if( value.switch_table != NULL ){
+		delete value.switch_table;
+	}
+}
+
+void Node::addChildren( llist_t *list ){
+	size_t needed = children.items + list->items;
+
+	if( needed > children.size ){
+		children.size  = needed;
+		children.nodes = (Node **)realloc( children.nodes, sizeof(Node *) * children.size );
+	}
+
+	ll_foreach( list, litem ){
+		children.nodes[children.items++] = ll_node(litem);
 	}
-	ll_clear( &children );
+
+	ll_destroy(list);
 }
 
 Node *Node::clone(){
@@ -121,7 +227,7 @@ ExpressionNode::ExpressionNode( size_t lineno, int expression, llist_t *list ) :
     opcode = expression;
 
     if( list != NULL ){
-    	ll_merge_destroy( &children, list );
+    	addChildren( list );
 	}
 }
 
@@ -141,8 +247,8 @@ Node *ExpressionNode::clone(){
 	Node *clone = new ExpressionNode( lineno, opcode, 0 ),
 		 *node;
 
-	ll_foreach( &children, nitem ){
-		node = ll_node(nitem);
+	for( size_t i = 0; i < children.items; ++i ){
+		node = children.nodes[i];
 		clone->addChild( node ? node->clone() : node );
 	}
 
@@ -172,7 +278,7 @@ StatementNode::StatementNode( size_t lineno, int statement, llist_t *identList,
 	addChild(expr);
 
 	if( identList ){
-		ll_merge_destroy( &children, identList );
+		addChildren( identList );
 	}
 }
 
@@ -181,7 +287,7 @@ StatementNode::StatementNode( size_t lineno, int statement, Node *sw, llist_t *c
     value.switch_block = sw;
 
     if( caselist != NULL ){
-    	ll_merge_destroy( &children, caselist );
+    	addChildren( caselist );
 	}
 }
 
@@ -191,7 +297,7 @@ StatementNode::StatementNode( size_t lineno, int statement, Node *sw, llist_t *c
     value.default_block   = deflt;
 
     if( caselist != NULL ){
-    	ll_merge_destroy( &children, caselist );
+    	addChildren( caselist );
 	}
 }
 
@@ -202,8 +308,8 @@ Node *StatementNode::clone(){
 	clone->value.switch_block  = ( value.switch_block  ? value.switch_block->clone() : NULL );
 	clone->value.default_block = ( value.default_block ? value.default_block->clone() : NULL );
 
-	ll_foreach( &children, nitem ){
-		node = ll_node(nitem);
+	for( size_t i = 0; i < children.items; ++i ){
+		node = children.nodes[i];
 		clone->addChild( node ? node->clone() : node );
 	}
 
@@ -243,8 +349,8 @@ Node *IdentifierNode::clone(){
 	clone->value.access    = value.access;
     clone->value.is_static = value.is_static;
 
-    ll_foreach( &children, nitem ){
-    	node = ll_node(nitem);
+    for( size_t i = 0; i < children.items; ++i ){
+    	node = children.nodes[i];
    		clone->addChild( node ? node->clone() : node );
    	}
 
@@ -258,7 +364,7 @@ AttributeRequestNode::AttributeRequestNode( size_t lineno, Node *owner, Node *me
 }
 
 Node *AttributeRequestNode::clone(){
-	return new AttributeRequestNode( lineno, value.owner, value.member );
+	return new AttributeRequestNode( lineno, value.owner->clone(), value.member->clone() );
 }
 
 /* class method call */
@@ -268,32 +374,34 @@ MethodCallNode::MethodCallNode( size_t lineno, Node *owner, Node *call ) : Node(
 }
 
 Node *MethodCallNode::clone(){
-	return new MethodCallNode( lineno, value.owner, value.member );
+	return new MethodCallNode( lineno, value.owner->clone(), value.member->clone() );
 }
 
 /* functions */
 FunctionNode::FunctionNode( size_t lineno, function_decl_t *declaration ) : Node(H_NT_FUNCTION,lineno) {
-    value.function = declaration->function;
+    value.identifier = declaration->function;
     value.vargs    = declaration->vargs;
     value.argc	   = declaration->argc;
 
 	/* add function prototype args children */
 	for( size_t i = 0; i < value.argc; ++i ){
-		addChild( new IdentifierNode( lineno, declaration->argv[i] ) );
+		addChild( new IdentifierNode( lineno, (char *)declaration->argv[i].c_str() ) );
 	}
+
+	prepare();
 }
 
 FunctionNode::FunctionNode( size_t lineno, function_decl_t *declaration, int argc, ... ) : Node(H_NT_FUNCTION,lineno) {
     va_list ap;
 	size_t  i;
 
-	value.function = declaration->function;
+	value.identifier = declaration->function;
     value.vargs    = declaration->vargs;
     value.argc	   = declaration->argc;
 
 	/* add function prototype args children */
 	for( i = 0; i < value.argc; ++i ){
-		addChild( new IdentifierNode( lineno, declaration->argv[i] ) );
+		addChild( new IdentifierNode( lineno, (char *)declaration->argv[i].c_str() ) );
 	}
 	/* add function body statements node */
 	va_start( ap, argc );
@@ -302,22 +410,68 @@ FunctionNode::FunctionNode( size_t lineno, function_decl_t *declaration, int arg
 		addChild( va_arg( ap, Node * ) );
 	}
 	va_end(ap);
+
+	prepare();
+}
+
+FunctionNode::FunctionNode( size_t lineno, const char *name ) : Node(H_NT_FUNCTION,lineno), frame_size(0) {
+    value.identifier = name;
+}
+
+size_t FunctionNode::countIdentifiers( Node *node ){
+	size_t count(0);
+
+	if( node == NULL ){
+		return 0;
+	}
+	/*
+	 * Nested declarations have their own frames.
+	 */
+	switch( node->type ){
+		case H_NT_FUNCTION    :
+		case H_NT_METHOD_DECL :
+		case H_NT_CLASS       :
+		case H_NT_STRUCT      :
+			return 0;
+
+		case H_NT_IDENTIFIER  :
+			count++;
+		break;
+	}
+
+	for( size_t i = 0; i < node->children.items; ++i ){
+		count += countIdentifiers( node->children.nodes[i] );
+	}
+
+	return count;
 }
 
-FunctionNode::FunctionNode( size_t lineno, const char *name ) : Node(H_NT_FUNCTION,lineno) {
-    value.function = name;
+void FunctionNode::prepare(){
+	size_t i;
+
+	params.clear();
+	frame_size = value.argc;
+
+	for( i = 0; i < children.items; ++i ){
+		if( i < value.argc ){
+			params.push_back( children.nodes[i]->id() );
+		}
+		else{
+			frame_size += countIdentifiers( children.nodes[i] );
+		}
+	}
 }
 
 Node *FunctionNode::clone(){
-	Node *clone = new FunctionNode( lineno, value.function.c_str() ),
+	Node *clone = new FunctionNode( lineno, value.identifier.c_str() ),
 		 *node,
 		 *nclone;
 
 	clone->value.argc  = value.argc;
 	clone->value.vargs = value.vargs;
 
-	ll_foreach( &children, nitem ){
-		node   = ll_node( nitem );
+	for( size_t i = 0; i < children.items; ++i ){
+		node   = children.nodes[i];
 		nclone = (node ? node->clone() : node);
 		if( node == body ){
 			clone->body = nclone;
@@ -325,21 +479,23 @@ Node *FunctionNode::clone(){
 		clone->addChild( nclone );
 	}
 
+	((FunctionNode *)clone)->prepare();
+
 	return clone;
 }
 
 /* function calls */
 CallNode::CallNode( size_t lineno, char *name, llist_t *argv ) : Node(H_NT_CALL,lineno) {
-    value.call = name;
+    value.identifier = name;
     if( argv != NULL ){
-    	ll_merge_destroy( &children, argv );
+    	addChildren( argv );
 	}
 }
 
 CallNode::CallNode( size_t lineno, Node *alias, llist_t *argv ) :  Node(H_NT_CALL,lineno) {
     value.alias = alias;
     if( argv != NULL ){
-    	ll_merge_destroy( &children, argv );
+    	addChildren( argv );
 	}
 }
 
@@ -348,13 +504,13 @@ Node *CallNode::clone(){
 		 *node;
 
     if( value.alias == NULL ){
-        clone = new CallNode( lineno, (char *)value.call.c_str(), NULL );
+        clone = new CallNode( lineno, (char *)value.identifier.c_str(), NULL );
     }
     else{
-        clone = new CallNode( lineno, value.alias, NULL );
+        clone = new CallNode( lineno, value.alias->clone(), NULL );
     }
-	ll_foreach( &children, nitem ){
-		node = ll_node(nitem);
+	for( size_t i = 0; i < children.items; ++i ){
+		node = children.nodes[i];
 		clone->addChild( node ? node->clone() : node );
 	}
 
@@ -365,7 +521,7 @@ Node *CallNode::clone(){
 TryCatchNode::TryCatchNode( size_t lineno, int statement, Node *try_block, char *exception_id, Node *catch_block, Node *finally_block ) : Node(H_NT_STATEMENT,lineno) {
 	opcode 	    		= statement;
 	value.try_block     = try_block;
-	value.exception_id  = exception_id;
+	value.identifier  = exception_id;
 	value.catch_block   = catch_block;
 	value.finally_block = finally_block;
 }
@@ -373,17 +529,17 @@ TryCatchNode::TryCatchNode( size_t lineno, int statement, Node *try_block, char
 Node *TryCatchNode::clone(){
 	return new TryCatchNode( lineno,
 							 opcode,
-							 value.try_block,
-							 (char *)value.exception_id.c_str(),
-							 value.catch_block,
-							 value.finally_block );
+							 (value.try_block ? value.try_block->clone() : NULL),
+							 (char *)value.identifier.c_str(),
+							 (value.catch_block ? value.catch_block->clone() : NULL),
+							 (value.finally_block ? value.finally_block->clone() : NULL) );
 }
 
 /* structure or class creation */
 NewNode::NewNode( size_t lineno, char *type, llist_t *argv ) : Node(H_NT_NEW,lineno){
 	value.identifier = type;
 	if( argv != NULL ){
-		ll_merge_destroy( &children, argv );
+		addChildren( argv );
 	}
 }
 
@@ -391,8 +547,8 @@ Node *NewNode::clone(){
 	Node *clone = new NewNode( lineno, id(), NULL ),
 		 *node;
 
-	ll_foreach( &children, nitem ){
-		node = ll_node(nitem);
+	for( size_t i = 0; i < children.items; ++i ){
+		node = children.nodes[i];
 		clone->addChild( node ? node->clone() : node );
 	}
 
@@ -403,13 +559,13 @@ Node *NewNode::clone(){
 StructureNode::StructureNode( size_t lineno, char *s_name, llist_t *attributes ) : Node(H_NT_STRUCT,lineno) {
     value.identifier = s_name;
     if( attributes != NULL ){
-    	ll_merge_destroy( &children, attributes );
+    	addChildren( attributes );
 	}
 }
 
 /* methods */
 MethodDeclarationNode::MethodDeclarationNode( size_t lineno, access_t access, method_decl_t *declaration, int argc, ... ) : Node(H_NT_METHOD_DECL,lineno) {
-    value.method = declaration->method;
+    value.identifier = declaration->method;
     value.vargs  = declaration->vargs;
     value.argc   = declaration->argc;
     value.access = access;
@@ -419,7 +575,7 @@ MethodDeclarationNode::MethodDeclarationNode( size_t lineno, access_t access, me
 
 	/* add method prototype args children */
 	for( i = 0; i < value.argc; ++i ){
-		addChild( new IdentifierNode( lineno, declaration->argv[i] ) );
+		addChild( new IdentifierNode( lineno, (char *)declaration->argv[i].c_str() ) );
 	}
 	/* add method body statements node */
 	va_start( ap, argc );
@@ -431,7 +587,7 @@ MethodDeclarationNode::MethodDeclarationNode( size_t lineno, access_t access, me
 }
 
 MethodDeclarationNode::MethodDeclarationNode( size_t lineno, access_t access, method_decl_t *declaration, bool is_static, int argc, ... ) : Node(H_NT_METHOD_DECL,lineno) {
-    value.method 	= declaration->method;
+    value.identifier 	= declaration->method;
     value.vargs  	= declaration->vargs;
     value.argc   	= declaration->argc;
     value.access 	= access;
@@ -442,7 +598,7 @@ MethodDeclarationNode::MethodDeclarationNode( size_t lineno, access_t access, me
 
 	/* add method prototype args children */
 	for( i = 0; i < value.argc; ++i ){
-		addChild( new IdentifierNode( lineno, declaration->argv[i] ) );
+		addChild( new IdentifierNode( lineno, (char *)declaration->argv[i].c_str() ) );
 	}
 	/* add method body statements node */
 	va_start( ap, argc );
@@ -454,12 +610,12 @@ MethodDeclarationNode::MethodDeclarationNode( size_t lineno, access_t access, me
 }
 
 MethodDeclarationNode::MethodDeclarationNode( size_t lineno, const char *name, access_t access ) : Node(H_NT_METHOD_DECL,lineno) {
-	value.method = name;
+	value.identifier = name;
 	value.access = access;
 }
 
 Node *MethodDeclarationNode::clone(){
-	Node *clone = new MethodDeclarationNode( lineno, value.method.c_str(), value.access ),
+	Node *clone = new MethodDeclarationNode( lineno, value.identifier.c_str(), value.access ),
 		 *node,
 		 *nclone;
 
@@ -467,8 +623,8 @@ Node *MethodDeclarationNode::clone(){
 	clone->value.vargs     = value.vargs;
 	clone->value.argc	   = value.argc;
 
-	ll_foreach( &children, nitem ){
-		node   = ll_node( nitem );
+	for( size_t i = 0; i < children.items; ++i ){
+		node   = children.nodes[i];
 		nclone = node ? node->clone() : node;
 		if( node == body ){
 			clone->body = nclone;
@@ -483,11 +639,10 @@ Node *MethodDeclarationNode::clone(){
 ClassNode::ClassNode( size_t lineno, char *classname, llist_t *extends, llist_t *members ) : Node(H_NT_CLASS,lineno) {
 	value.identifier = classname;
 	if( extends != NULL ){
-		ll_init( &value.extends );
 		ll_merge_destroy( &value.extends, extends );
 	}
 	if( members != NULL ){
-		ll_merge_destroy( &children, members );
+		addChildren( members );
 	}
 }
 
@@ -206,6 +206,20 @@ Object *binary_cl_set_reference( Object *me, Object *i, Object *v ){
     return me;
 }
 
+/** iterator protocol **/
+bool binary_iter_next( Object *me, ob_iterator_t *it, Object **key, Object **value ){
+	if( it->index >= ob_binary_ucast(me)->items ){
+		return false;
+	}
+
+	if( key ){
+		*key = (Object *)gc_new_integer( it->index );
+	}
+	*value = ob_binary_ucast(me)->value[it->index++];
+
+	return true;
+}
+
 IMPLEMENT_TYPE(Binary) {
     /** type code **/
     otBinary,
@@ -220,6 +234,7 @@ IMPLEMENT_TYPE(Binary) {
     binary_traverse, // traverse
 	binary_clone, // clone
 	binary_free, // free
+	0, // unshare
 	binary_get_size, // get_size
 	binary_serialize, // serialize
 	binary_deserialize, // deserialize
@@ -298,6 +313,10 @@ IMPLEMENT_TYPE(Binary) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    binary_iter_next  // iter_next
 };
 
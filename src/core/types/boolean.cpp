@@ -190,6 +190,7 @@ IMPLEMENT_TYPE(Boolean) {
     0, // traverse
 	bool_clone, // clone
 	0, // free
+	0, // unshare
 	0, // get_size
 	bool_serialize, // serialize
 	bool_deserialize, // deserialize
@@ -268,6 +269,10 @@ IMPLEMENT_TYPE(Boolean) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
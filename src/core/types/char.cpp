@@ -412,6 +412,7 @@ IMPLEMENT_TYPE(Char) {
     0, // traverse
 	char_clone, // clone
 	0, // free
+	0, // unshare
 	0, // get_size
 	char_serialize, // serialize
 	char_deserialize, // deserialize
@@ -490,6 +491,10 @@ IMPLEMENT_TYPE(Char) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
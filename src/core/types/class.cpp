@@ -17,6 +17,180 @@
  * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "hybris.h"
+/*
+ * Method names of the overloadable operators and descriptors,
+ * indexed by class_slot_t.
+ */
+static const char *__class_slots[csSlots] = {
+	"..",		// csRange
+	"~=",		// csRegexp
+	"++",		// csIncrement
+	"--",		// csDecrement
+	"+",		// csAdd
+	"-",		// csSub
+	"*",		// csMul
+	"/",		// csDiv
+	"%",		// csMod
+	"+=",		// csInplaceAdd
+	"-=",		// csInplaceSub
+	"*=",		// csInplaceMul
+	"/=",		// csInplaceDiv
+	"%=",		// csInplaceMod
+	"&",		// csBwAnd
+	"|",		// csBwOr
+	"~",		// csBwNot
+	"^",		// csBwXor
+	"<<",		// csBwLshift
+	">>",		// csBwRshift
+	"&=",		// csBwInplaceAnd
+	"|=",		// csBwInplaceOr
+	"^=",		// csBwInplaceXor
+	"<<=",		// csBwInplaceLshift
+	">>=",		// csBwInplaceRshift
+	"!",		// csLNot
+	"==",		// csLSame
+	"!=",		// csLDiff
+	"<",		// csLLess
+	">",		// csLGreater
+	"<=",		// csLLessOrSame
+	">=",		// csLGreaterOrSame
+	"||",		// csLOr
+	"&&",		// csLAnd
+	"[]=",		// csClPush
+	"[]",		// csClAt
+	"[]<",		// csClSet
+	"__size",	// csSize
+	"__to_string",	// csToString
+	"__attribute",	// csAttribute
+	"__method",	// csMethod
+	"__iter",	// csIter
+	"__next",	// csNext
+};
+
+void _class_method_t::add( Node *m ){
+	/*
+	 * The last child of a method is its body itself.
+	 */
+	size_t argc = m->children.items - 1;
+
+	prototypes.push_back(m);
+
+	if( argc >= arities.size() ){
+		arities.resize( argc + 1, NULL );
+	}
+	if( arities[argc] == NULL ){
+		arities[argc] = m;
+	}
+}
+
+void class_build_table( Object *me ){
+	Class *cme = ob_class_ucast(me);
+	size_t i;
+
+	if( cme->table == NULL ){
+		cme->table = new class_table_t;
+	}
+
+	for( i = 0; i < csSlots; ++i ){
+		cme->table->slots[i] = (cme->c_methods ? cme->c_methods->find( (char *)__class_slots[i] ) : NULL);
+	}
+}
+
+void class_build_recipe( Object *me ){
+	Class 		   *cme = ob_class_ucast(me);
+	class_recipe_t *recipe = new class_recipe_t;
+	ClassAttributeIterator ai;
+
+	class_build_table(me);
+
+	itree_foreach( class_attribute_t, ai, cme->c_attributes ){
+		recipe->attributes.push_back( (*ai)->value );
+	}
+	/*
+	 * From now on the methods belong to the recipe.
+	 */
+	if( cme->c_methods == NULL ){
+		cme->c_methods = new ITree<class_method_t>();
+	}
+	recipe->methods = cme->c_methods;
+	recipe->table   = cme->table;
+	cme->recipe     = recipe;
+}
+/*
+ * Give the class its own copy of a methods tree shared with its
+ * recipe, so it can define new methods.
+ */
+static void class_unshare_methods( Class *cme ){
+	ITree<class_method_t> *methods = new ITree<class_method_t>();
+	ClassMethodIterator    mi;
+
+	itree_foreach( class_method_t, mi, *cme->c_methods ){
+		methods->insert( (char *)(*mi)->label.c_str(),
+						 new class_method_t( (*mi)->value->name, (*mi)->value->prototypes ) );
+	}
+
+	cme->c_methods = methods;
+	cme->recipe    = NULL;
+}
+
+Object *class_new_instance( Object *me ){
+	Class 		   *cme    = ob_class_ucast(me),
+				   *instance;
+	class_recipe_t *recipe = cme->recipe;
+	class_attribute_t *attribute;
+	Object  	   *a_value;
+	size_t 			i, nattrs;
+
+	if( recipe == NULL ){
+		return ob_clone(me);
+	}
+
+	instance = gc_new_class();
+	nattrs   = recipe->attributes.size();
+
+	instance->c_attributes.reserve( nattrs );
+
+	for( i = 0; i < nattrs; ++i ){
+		attribute = recipe->attributes[i];
+		/*
+		 * Static attributes storage is shared, others are initialized
+		 * with a clone of their default value.
+		 */
+		if( attribute->is_static ){
+			instance->c_attributes.insert( (char *)attribute->name.c_str(), attribute );
+		}
+		else{
+			a_value = ob_clone( attribute->value );
+			a_value->referenced = true;
+
+			instance->c_attributes.insert( (char *)attribute->name.c_str(),
+										   new class_attribute_t( attribute->name, attribute->access, a_value ) );
+		}
+	}
+
+	instance->name 	    = cme->name;
+	instance->c_methods = recipe->methods;
+	instance->table     = recipe->table;
+	instance->recipe    = recipe;
+
+	return (Object *)instance;
+}
+/*
+ * Get the method overloading the operator or descriptor 'slot' with
+ * 'argc' parameters, if the class has no table yet, look it up by name.
+ */
+INLINE Node *class_get_slot( Object *me, class_slot_t slot, int argc ){
+	Class 		   *cme = ob_class_ucast(me);
+	class_method_t *method;
+
+	if( cme->table != NULL ){
+		method = cme->table->slots[slot];
+
+		return (method != NULL ? method->get(argc) : H_UNDEFINED);
+	}
+
+	return ob_get_method( me, (char *)__class_slots[slot], argc );
+}
 /*
  * Special function to execute a __method class descriptor.
  */
@@ -24,12 +198,11 @@ Object *class_call_undefined_method( vm_t *vm, Object *c, char *c_name, char *me
 	Node    *method = H_UNDEFINED;
 	vframe_t stack,
 			*frame;
-	ll_item_t *iitem;
 	Object  *value  = H_UNDEFINED,
 			*result = H_UNDEFINED;
 	size_t i, argc(argv->children.items);
 
-	method = ob_get_method( c, (char *)"__method", 2 );
+	method = class_get_slot( c, csMethod, 2 );
 	if( method == H_UNDEFINED ){
 		return H_UNDEFINED;
 	}
@@ -42,21 +215,23 @@ Object *class_call_undefined_method( vm_t *vm, Object *c, char *c_name, char *me
 	/*
 	 * Prevent args from being garbage collected.
 	 */
-	frame->push( (Object *)args );
+	size_t root = frame->push_tmp( (Object *)args );
 
 	stack.owner = string(c_name) + "::" + string("__method");
 
 	c->referenced = true;
 	stack.insert( "me", c );
 	stack.add( "name", (Object *)gc_new_string(method_name) );
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, frame, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, frame, argv->child(i) );
 
 		if( frame->state.is(Exception) ){
+			frame->pop_tmp(root);
 			vm_pop_frame( vm );
 			return frame->state.e_value;
 		}
 		else if( frame->state.is(Return) ){
+			frame->pop_tmp(root);
 			vm_pop_frame( vm );
 			return frame->state.r_value;
 		}
@@ -70,6 +245,10 @@ Object *class_call_undefined_method( vm_t *vm, Object *c, char *c_name, char *me
 		}
 	}
 	stack.add( "argv", (Object *)args );
+	/*
+	 * Now the stack holds args.
+	 */
+	frame->pop_tmp(root);
 
 	/* call the method */
 	result = vm_exec( vm, &stack, method->body );
@@ -89,27 +268,27 @@ Object *class_call_undefined_method( vm_t *vm, Object *c, char *c_name, char *me
 }
 
 /*
- * Call the operator 'op_name' of class 'me' with 'argc' arguments if overloaded,
+ * Call the operator 'slot' of class 'me' with 'argc' arguments if overloaded,
  * otherwise print a syntax error.
  */
-Object *class_call_overloaded_operator( Object *me, const char *op_name, int argc, ... ){
+Object *class_call_overloaded_operator( Object *me, class_slot_t slot, int argc, ... ){
+	const char *op_name = __class_slots[slot];
 	Node    *op = H_UNDEFINED;
 	vframe_t stack;
-	ll_item_t *iitem;
 	Object  *result = H_UNDEFINED,
 			*value  = H_UNDEFINED;
 	unsigned int i, op_argc;
 	va_list ap;
-	extern vm_t *__hyb_vm;
+	vm_t *vm = vm_current();
 
-	if( (op = ob_get_method( me, (char *)op_name, argc )) == H_UNDEFINED ){
+	if( (op = class_get_slot( me, slot, argc )) == H_UNDEFINED ){
 		hyb_error( H_ET_SYNTAX, "class %s does not overload '%s' operator", ob_typename(me), op_name );
 	}
 
 	/*
 	 * Check for heavy recursions and/or nested calls.
 	 */
-	if( vm_scope_size(__hyb_vm) >= VM_MAX_RECURSION ){
+	if( vm_scope_size(vm) >= VM_MAX_RECURSION ){
 		hyb_error( H_ET_GENERIC, "Reached max number of nested calls" );
 	}
 
@@ -129,29 +308,29 @@ Object *class_call_overloaded_operator( Object *me, const char *op_name, int arg
 
 	stack.owner = string(ob_typename(me)) + ":: operator " + string(op_name);
 
-	vm_add_frame( __hyb_vm, &stack );
+	vm_add_frame( vm, &stack );
 
 	me->referenced = true;
 	stack.insert( "me", me );
 	va_start( ap, argc );
-	for( i = 0, iitem = op->children.head; i < argc; ++i, iitem = iitem->next ){
+	for( i = 0; i < argc; ++i ){
 		value = va_arg( ap, Object * );
 		value->referenced = true;
-		stack.insert( ll_node( iitem )->id(), value );
+		stack.insert( op->child(i)->id(), value );
 	}
 	va_end(ap);
 
 	/* call the operator */
-	result = vm_exec( __hyb_vm, &stack, op->body );
+	result = vm_exec( vm, &stack, op->body );
 
-	vm_pop_frame( __hyb_vm );
+	vm_pop_frame( vm );
 
 	/*
 	 * Check for unhandled exceptions and put them on the root
 	 * memory frame.
 	 */
 	if( stack.state.is(Exception) ){
-		vm_frame( __hyb_vm )->state.set( Exception, stack.state.e_value );
+		vm_frame( vm )->state.set( Exception, stack.state.e_value );
 	}
 
 	/* return method evaluation value */
@@ -159,21 +338,21 @@ Object *class_call_overloaded_operator( Object *me, const char *op_name, int arg
 }
 
 /*
- * Call the descriptor 'ds_name' of class 'me' with 'argc' arguments if overloaded,
+ * Call the descriptor 'slot' of class 'me' with 'argc' arguments if overloaded,
  * if the descriptor is not overloaded, return NULL if lazy = true or print a
  * syntax error.
  */
-Object *class_call_overloaded_descriptor( Object *me, const char *ds_name, bool lazy, int argc, ... ){
+Object *class_call_overloaded_descriptor( Object *me, class_slot_t slot, bool lazy, int argc, ... ){
+	const char *ds_name = __class_slots[slot];
 	Node    *ds = H_UNDEFINED;
 	vframe_t stack;
-	ll_item_t *iitem;
 	Object  *result = H_UNDEFINED,
 			*value  = H_UNDEFINED;
 	unsigned int i, ds_argc;
 	va_list ap;
-	extern vm_t *__hyb_vm;
+	vm_t *vm = vm_current();
 
-	if( (ds = ob_get_method( me, (char *)ds_name, argc )) == H_UNDEFINED ){
+	if( (ds = class_get_slot( me, slot, argc )) == H_UNDEFINED ){
 		if( lazy == false ){
 			hyb_error( H_ET_SYNTAX, "class %s does not overload '%s' descriptor", ob_typename(me), ds_name );
 		}
@@ -185,7 +364,7 @@ Object *class_call_overloaded_descriptor( Object *me, const char *ds_name, bool
 	/*
 	 * Check for heavy recursions and/or nested calls.
 	 */
-	if( vm_scope_size(__hyb_vm) >= VM_MAX_RECURSION ){
+	if( vm_scope_size(vm) >= VM_MAX_RECURSION ){
 		hyb_error( H_ET_GENERIC, "Reached max number of nested calls" );
 	}
 
@@ -202,7 +381,7 @@ Object *class_call_overloaded_descriptor( Object *me, const char *ds_name, bool
 								 argc );
 	}
 
-	vm_add_frame( __hyb_vm, &stack );
+	vm_add_frame( vm, &stack );
 
 	/*
 	 * Create the "me" reference to the class itself, used inside
@@ -213,23 +392,23 @@ Object *class_call_overloaded_descriptor( Object *me, const char *ds_name, bool
 	me->referenced = true;
 	stack.insert( "me", me );
 	va_start( ap, argc );
-	for( i = 0, iitem = ds->children.head; i < argc; ++i, iitem = iitem->next ){
+	for( i = 0; i < argc; ++i ){
 		value = va_arg( ap, Object * );
-		stack.insert( ll_node( iitem )->id(), value );
+		stack.insert( ds->child(i)->id(), value );
 	}
 	va_end(ap);
 
 	/* call the descriptor */
-	result = vm_exec( __hyb_vm, &stack, ds->body );
+	result = vm_exec( vm, &stack, ds->body );
 
-	vm_pop_frame( __hyb_vm );
+	vm_pop_frame( vm );
 
 	/*
 	 * Check for unhandled exceptions and put them on the root
 	 * memory frame.
 	 */
 	if( stack.state.is(Exception) ){
-		vm_frame( __hyb_vm )->state.set( Exception, stack.state.e_value );
+		vm_frame( vm )->state.set( Exception, stack.state.e_value );
 	}
 
 	/* return method evaluation value */
@@ -256,6 +435,8 @@ Object *class_clone( Object *me ){
     ClassPrototypesIterator pi;
     prototypes_t 				  prototypes;
 
+    cclone->c_attributes.reserve( cme->c_attributes.size() );
+
     itree_foreach( class_attribute_t, ai, cme->c_attributes ){
     	/*
     	 * If the attribute is not static, clone the entire structure.
@@ -280,27 +461,39 @@ Object *class_clone( Object *me ){
     	}
     }
 
-    itree_foreach( class_method_t, mi, cme->c_methods ){
-    	prototypes.clear();
-    	vv_foreach( vector<Node *>, pi, (*mi)->value->prototypes ){
-    		prototypes.push_back( (*pi)->clone() );
-    	}
+    /*
+     * Methods built in a recipe are shared, otherwise they're cloned.
+     */
+    if( cme->recipe != NULL ){
+    	cclone->c_methods = cme->c_methods;
+    	cclone->recipe    = cme->recipe;
+    }
+    else if( cme->c_methods != NULL ){
+    	cclone->c_methods = new ITree<class_method_t>();
 
-    	cclone->c_methods.insert( (char *)(*mi)->value->name.c_str(),
-								  new class_method_t(
-										  (*mi)->value->name,
-										  prototypes
-								  )
-							    );
+		itree_foreach( class_method_t, mi, *cme->c_methods ){
+			prototypes.clear();
+			vv_foreach( vector<Node *>, pi, (*mi)->value->prototypes ){
+				prototypes.push_back( (*pi)->clone() );
+			}
+
+			cclone->c_methods->insert( (char *)(*mi)->value->name.c_str(),
+									   new class_method_t(
+											  (*mi)->value->name,
+											  prototypes
+									   )
+									 );
+		}
     }
 
-    cclone->name = cme->name;
+    cclone->name  = cme->name;
+    cclone->table = cme->table;
 
     return (Object *)(cclone);
 }
 
 size_t class_get_size( Object *me ){
-	Object *size = class_call_overloaded_descriptor( me, "__size", false, 0 );
+	Object *size = class_call_overloaded_descriptor( me, csSize, false, 0 );
 	return ob_ivalue(size);
 }
 
@@ -315,30 +508,33 @@ void class_free( Object *me ){
     /*
      * Check if the class has a destructors and call it.
      */
-    if( (method = cme->c_methods.find( "__expire" )) ){
+    if( cme->c_methods && (method = cme->c_methods->find( "__expire" )) ){
 		vv_foreach( vector<Node *>, pi, method->prototypes ){
 			Node *dtor = (*pi);
 			vframe_t stack;
-			extern vm_t *__hyb_vm;
+			vm_t *vm = vm_current();
 
 			stack.owner = string(ob_typename(me)) + "::__expire";
 			stack.insert( "me", me );
 
-			vm_add_frame( __hyb_vm, &stack );
+			vm_add_frame( vm, &stack );
 
-			vm_exec( __hyb_vm, &stack, dtor->body );
+			vm_exec( vm, &stack, dtor->body );
 
-			vm_pop_frame( __hyb_vm );
+			vm_pop_frame( vm );
 		}
     }
 	/*
-	 * Delete c_methods structure pointers.
+	 * Delete c_methods structure pointers, unless they belong to a recipe.
 	 */
-	itree_foreach( class_method_t, mi, cme->c_methods ){
-		method = (*mi)->value;
-		delete method;
+	if( cme->c_methods != NULL && cme->recipe == NULL ){
+		itree_foreach( class_method_t, mi, *cme->c_methods ){
+			method = (*mi)->value;
+			delete method;
+		}
+		delete cme->c_methods;
 	}
-	cme->c_methods.clear();
+	cme->c_methods = NULL;
 	/*
 	 * Delete c_attributes structure pointers and decrement values references.
 	 */
@@ -371,7 +567,7 @@ bool class_lvalue( Object *me ){
 string class_svalue( Object *me ){
 	Object *svalue = H_UNDEFINED;
 
-	if( (svalue = class_call_overloaded_descriptor( me, "__to_string", true, 0 )) == H_UNDEFINED ){
+	if( (svalue = class_call_overloaded_descriptor( me, csToString, true, 0 )) == H_UNDEFINED ){
 		return "<" + ob_class_ucast(me)->name + ">";
 	}
 	else{
@@ -380,17 +576,17 @@ string class_svalue( Object *me ){
 }
 
 void class_print( Object *me, int tabs ){
-	Object *svalue = class_call_overloaded_descriptor( me, "__to_string", false, 0 );
+	Object *svalue = class_call_overloaded_descriptor( me, csToString, false, 0 );
 
 	ob_print( svalue, tabs );
 }
 
 Object *class_range( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "..", 1, op );
+	return class_call_overloaded_operator( me, csRange, 1, op );
 }
 
 Object *class_regexp( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "~=", 1, op );
+	return class_call_overloaded_operator( me, csRegexp, 1, op );
 }
 
 /** arithmetic operators **/
@@ -403,146 +599,146 @@ Object *class_assign( Object *me, Object *op ){
 }
 
 Object *class_increment( Object *me ){
-	return class_call_overloaded_operator( me, "++", 0 );
+	return class_call_overloaded_operator( me, csIncrement, 0 );
 }
 
 Object *class_decrement( Object *me ){
-	return class_call_overloaded_operator( me, "--", 0 );
+	return class_call_overloaded_operator( me, csDecrement, 0 );
 }
 
 Object *class_add( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "+", 1, op );
+	return class_call_overloaded_operator( me, csAdd, 1, op );
 }
 
 Object *class_sub( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "-", 1, op );
+	return class_call_overloaded_operator( me, csSub, 1, op );
 }
 
 Object *class_mul( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "*", 1, op );
+	return class_call_overloaded_operator( me, csMul, 1, op );
 }
 
 Object *class_div( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "/", 1, op );
+	return class_call_overloaded_operator( me, csDiv, 1, op );
 }
 
 Object *class_mod( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "%", 1, op );
+	return class_call_overloaded_operator( me, csMod, 1, op );
 }
 
 Object *class_inplace_add( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "+=", 1, op );
+	return class_call_overloaded_operator( me, csInplaceAdd, 1, op );
 }
 
 Object *class_inplace_sub( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "-=", 1, op );
+	return class_call_overloaded_operator( me, csInplaceSub, 1, op );
 }
 
 Object *class_inplace_mul( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "*=", 1, op );
+	return class_call_overloaded_operator( me, csInplaceMul, 1, op );
 }
 
 Object *class_inplace_div( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "/=", 1, op );
+	return class_call_overloaded_operator( me, csInplaceDiv, 1, op );
 }
 
 Object *class_inplace_mod( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "%=", 1, op );
+	return class_call_overloaded_operator( me, csInplaceMod, 1, op );
 }
 
 /** bitwise operators **/
 Object *class_bw_and( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "&", 1, op );
+	return class_call_overloaded_operator( me, csBwAnd, 1, op );
 }
 
 Object *class_bw_or( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "|", 1, op );
+	return class_call_overloaded_operator( me, csBwOr, 1, op );
 }
 
 Object *class_bw_not( Object *me ){
-	return class_call_overloaded_operator( me, "~", 0 );
+	return class_call_overloaded_operator( me, csBwNot, 0 );
 }
 
 Object *class_bw_xor( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "^", 1, op );
+	return class_call_overloaded_operator( me, csBwXor, 1, op );
 }
 
 Object *class_bw_lshift( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "<<", 1, op );
+	return class_call_overloaded_operator( me, csBwLshift, 1, op );
 }
 
 Object *class_bw_rshift( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, ">>", 1, op );
+	return class_call_overloaded_operator( me, csBwRshift, 1, op );
 }
 
 Object *class_bw_inplace_and( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "&=", 1, op );
+	return class_call_overloaded_operator( me, csBwInplaceAnd, 1, op );
 }
 
 Object *class_bw_inplace_or( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "|=", 1, op );
+	return class_call_overloaded_operator( me, csBwInplaceOr, 1, op );
 }
 
 Object *class_bw_inplace_xor( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "^=", 1, op );
+	return class_call_overloaded_operator( me, csBwInplaceXor, 1, op );
 }
 
 Object *class_bw_inplace_lshift( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "<<=", 1, op );
+	return class_call_overloaded_operator( me, csBwInplaceLshift, 1, op );
 }
 
 Object *class_bw_inplace_rshift( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, ">>=", 1, op );
+	return class_call_overloaded_operator( me, csBwInplaceRshift, 1, op );
 }
 
 /** logic operators **/
 Object *class_l_not( Object *me ){
-	return class_call_overloaded_operator( me, "!", 0 );
+	return class_call_overloaded_operator( me, csLNot, 0 );
 }
 
 Object *class_l_same( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "==", 1, op );
+	return class_call_overloaded_operator( me, csLSame, 1, op );
 }
 
 Object *class_l_diff( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "!=", 1, op );
+	return class_call_overloaded_operator( me, csLDiff, 1, op );
 }
 
 Object *class_l_less( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "<", 1, op );
+	return class_call_overloaded_operator( me, csLLess, 1, op );
 }
 
 Object *class_l_greater( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, ">", 1, op );
+	return class_call_overloaded_operator( me, csLGreater, 1, op );
 }
 
 Object *class_l_less_or_same( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "<=", 1, op );
+	return class_call_overloaded_operator( me, csLLessOrSame, 1, op );
 }
 
 Object *class_l_greater_or_same( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, ">=", 1, op );
+	return class_call_overloaded_operator( me, csLGreaterOrSame, 1, op );
 }
 
 Object *class_l_or( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "||", 1, op );
+	return class_call_overloaded_operator( me, csLOr, 1, op );
 }
 
 Object *class_l_and( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "&&", 1, op );
+	return class_call_overloaded_operator( me, csLAnd, 1, op );
 }
 
 /* collection operators */
 Object *class_cl_push( Object *me, Object *op ){
-	return class_call_overloaded_operator( me, "[]=", 1, op );
+	return class_call_overloaded_operator( me, csClPush, 1, op );
 }
 
 Object *class_cl_at( Object *me, Object *index ){
-	return class_call_overloaded_operator( me, "[]", 1, index );
+	return class_call_overloaded_operator( me, csClAt, 1, index );
 }
 
 Object *class_cl_set( Object *me, Object *index, Object *op ){
-	return class_call_overloaded_operator( me, "[]<", 2, index, op );
+	return class_call_overloaded_operator( me, csClSet, 2, index, op );
 }
 
 /** class operators **/
@@ -601,8 +797,8 @@ Object *class_get_attribute( Object *me, char *name, bool with_descriptor /* = t
 	 * Else, if the class overloads the __attribute descriptor
 	 * and with_descriptor = true, call it.
 	 */
-	else if( with_descriptor ){
-		return class_call_overloaded_descriptor( me, "__attribute", true, 1, (Object *)gc_new_string(name) );
+	else if( with_descriptor && class_get_slot( me, csAttribute, 1 ) != H_UNDEFINED ){
+		return class_call_overloaded_descriptor( me, csAttribute, true, 1, (Object *)gc_new_string(name) );
 	}
 	/*
 	 * Nothing found.
@@ -632,7 +828,7 @@ void class_set_attribute_reference( Object *me, char *name, Object *value ){
 		attribute->unlock();
 	}
 	else{
-		class_call_overloaded_descriptor( me, "__attribute", false, 2, (Object *)gc_new_string(name), value );
+		class_call_overloaded_descriptor( me, csAttribute, false, 2, (Object *)gc_new_string(name), value );
 	}
 }
 
@@ -644,57 +840,41 @@ void class_define_method( Object *me, char *name, Node *code ){
 	Class *cme = ob_class_ucast(me);
 	class_method_t *method;
 
+	if( cme->c_methods == NULL ){
+		cme->c_methods = new ITree<class_method_t>();
+	}
+	else if( cme->recipe != NULL ){
+		class_unshare_methods(cme);
+	}
 	/*
 	 * Check if there's already a method with that name, in this case
 	 * push the node to the variations vector.
 	 */
-	if( (method = cme->c_methods.find(name)) ){
-		method->prototypes.push_back( code->clone() );
+	if( (method = cme->c_methods->find(name)) ){
+		method->add( code->clone() );
 	}
 	/*
 	 * Otherwise define a new method.
 	 */
 	else{
-		cme->c_methods.insert( name, new class_method_t( name, code->clone() ) );
+		cme->c_methods->insert( name, new class_method_t( name, code->clone() ) );
 	}
+	/*
+	 * The table has to be built again.
+	 */
+	cme->table = NULL;
 }
 
 Node *class_get_method( Object *me, char *name, int argc ){
 	Class *cme = ob_class_ucast(me);
 	class_method_t *method;
 
-	if( method = cme->c_methods.find(name) ){
+	if( cme->c_methods && (method = cme->c_methods->find(name)) ){
 		/*
-		 * If no parameters number is specified, return the first method found.
+		 * Return the prototype with 'argc' parameters if any, otherwise
+		 * (or if no parameters number is specified) the first one.
 		 */
-		if( argc < 0 ){
-			return (*method->prototypes.begin());
-		}
-		/*
-		 * Otherwise, find the best match.
-		 */
-		ClassPrototypesIterator pi;
-		Node *best_match = NULL;
-		int   best_match_argc, match_argc;
-
-		vv_foreach( vector<Node *>, pi, method->prototypes ){
-			/*
-			 * The last child of a method is its body itself, so we compare
-			 * call children with method->children.items - 1 to ignore the body.
-			 */
-			if( best_match == NULL ){
-				best_match 		= *pi;
-				best_match_argc = best_match->children.items - 1;
-			}
-			else{
-				match_argc = (*pi)->children.items - 1;
-				if( match_argc != best_match_argc && match_argc == argc ){
-					return (*pi);
-				}
-			}
-		}
-
-		return best_match;
+		return method->get(argc);
 	}
 	else{
 		return NULL;
@@ -705,7 +885,6 @@ Object *class_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, c
 	size_t 	 method_argc,
 			 i,
 		 	 argc   = argv->children.items;
-	ll_item_t *aitem, *iitem;
 	Object  *value  = H_UNDEFINED,
 			*result = H_UNDEFINED;
 	Node    *method = class_get_method( me, method_id, argc );
@@ -794,8 +973,8 @@ Object *class_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, c
 	/*
 	 * Evaluate each object and insert it into the stack
 	 */
-	for( i = 0, aitem = argv->children.head, iitem = method->children.head; i < argc; ++i, aitem = aitem->next ){
-		value = vm_exec( vm, frame, ll_node( aitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, frame, argv->child(i) );
 		value->referenced = true;
 		/*
 		 * Check if vm_exec raised an exception.
@@ -817,8 +996,7 @@ Object *class_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, c
 			stack.push( value );
 		}
 		else{
-			stack.insert( ll_node(iitem)->id(), value );
-			iitem = iitem->next;
+			stack.insert( method->child(i)->id(), value );
 		}
 	}
 	/* execute the method */
@@ -841,6 +1019,93 @@ Object *class_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, c
 	return (result == H_UNDEFINED ? H_DEFAULT_RETURN : result);
 }
 
+/** iterator protocol **/
+
+/*
+ * Call the parameterless descriptor 'ds_name' of class 'me' and store its return
+ * value into 'result', return false if the descriptor ended without
+ * executing a return statement (used by __next to signal the end of
+ * the iteration).
+ */
+static bool class_call_iterator_descriptor( Object *me, class_slot_t slot, Object **result ){
+	const char *ds_name = __class_slots[slot];
+	Node    *ds = H_UNDEFINED;
+	vframe_t stack;
+	Object  *value = H_UNDEFINED;
+	bool     returned;
+	vm_t    *vm = vm_current();
+
+	if( (ds = class_get_slot( me, slot, 0 )) == H_UNDEFINED ){
+		hyb_error( H_ET_SYNTAX, "class %s does not overload '%s' descriptor", ob_typename(me), ds_name );
+	}
+
+	if( vm_scope_size(vm) >= VM_MAX_RECURSION ){
+		hyb_error( H_ET_GENERIC, "Reached max number of nested calls" );
+	}
+
+	vm_add_frame( vm, &stack );
+
+	stack.owner = string(ob_typename(me)) + "::" + string(ds_name);
+
+	me->referenced = true;
+	stack.insert( "me", me );
+
+	value    = vm_exec( vm, &stack, ds->body );
+	returned = stack.state.is(Return);
+
+	vm_pop_frame( vm );
+
+	if( stack.state.is(Exception) ){
+		vm_frame( vm )->state.set( Exception, stack.state.e_value );
+		return false;
+	}
+
+	*result = (value == H_UNDEFINED ? H_DEFAULT_RETURN : value);
+
+	return returned;
+}
+
+void class_iter_begin( Object *me, ob_iterator_t *it ){
+	Object *iterator = H_UNDEFINED;
+	/*
+	 * If the class defines an __iter descriptor, iterate the object
+	 * it returns, otherwise if it defines __next the class is an
+	 * iterator itself, and if none of them is defined the generic
+	 * iteration with __size and __at is used.
+	 */
+	if( class_get_slot( me, csIter, 0 ) != H_UNDEFINED ){
+		if( class_call_iterator_descriptor( me, csIter, &iterator ) && iterator != me ){
+			ob_iter_begin( iterator, it );
+		}
+	}
+}
+
+bool class_iter_next( Object *me, ob_iterator_t *it, Object **key, Object **value ){
+	if( class_get_slot( me, csNext, 0 ) != H_UNDEFINED ){
+		if( class_call_iterator_descriptor( me, csNext, value ) == false ){
+			return false;
+		}
+		if( key ){
+			*key = (Object *)gc_new_integer( it->index );
+		}
+		it->index++;
+
+		return true;
+	}
+
+	if( it->index >= ob_get_size(me) ){
+		return false;
+	}
+
+	it->cursor.value = it->index++;
+	if( key ){
+		*key = (Object *)gc_new_integer( it->cursor.value );
+	}
+	*value = ob_cl_at( me, (Object *)&it->cursor );
+
+	return true;
+}
+
 IMPLEMENT_TYPE(Class) {
     /** type code **/
     otClass,
@@ -855,6 +1120,7 @@ IMPLEMENT_TYPE(Class) {
     class_traverse, // traverse
 	class_clone, // clone
 	class_free, // free
+	0, // unshare
 	class_get_size, // get_size
 	0, // serialize
 	0, // deserialize
@@ -933,6 +1199,10 @@ IMPLEMENT_TYPE(Class) {
     class_set_attribute_reference,  // set_attribute_reference
     class_define_method, // define_method
     class_get_method,  // get_method
-    class_call_method  // call_method
+    class_call_method, // call_method
+
+    /** iterator protocol **/
+    class_iter_begin, // iter_begin
+    class_iter_next  // iter_next
 };
 
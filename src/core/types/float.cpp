@@ -377,6 +377,7 @@ IMPLEMENT_TYPE(Float) {
     0, // traverse
 	float_clone, // clone
 	0, // free
+	0, // unshare
 	0, // get_size
 	float_serialize, // serialize
 	float_deserialize, // deserialize
@@ -455,6 +456,10 @@ IMPLEMENT_TYPE(Float) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
@@ -148,6 +148,7 @@ IMPLEMENT_TYPE(Handle) {
     0, // traverse
 	handle_clone, // clone
 	0, // free
+	0, // unshare
 	0, // get_size
 	0, // serialize
 	0, // deserialize
@@ -226,6 +227,10 @@ IMPLEMENT_TYPE(Handle) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
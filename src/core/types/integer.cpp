@@ -433,6 +433,7 @@ IMPLEMENT_TYPE(Integer) {
     0, // traverse
 	int_clone, // clone
 	0, // free
+	0, // unshare
 	0, // get_size
 	int_serialize, // serialize
 	int_deserialize, // deserialize
@@ -509,7 +510,11 @@ IMPLEMENT_TYPE(Integer) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
 IMPLEMENT_TYPE(Alias) {
@@ -526,6 +531,7 @@ IMPLEMENT_TYPE(Alias) {
     0, // traverse
 	alias_clone, // clone
 	0, // free
+	0, // unshare
 	0, // get_size
 	int_serialize, // serialize
 	int_deserialize, // deserialize
@@ -602,7 +608,11 @@ IMPLEMENT_TYPE(Alias) {
     0, // set_attribute_reference;
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
 IMPLEMENT_TYPE(Extern) {
@@ -619,6 +629,7 @@ IMPLEMENT_TYPE(Extern) {
     0, // traverse
 	extern_clone, // clone
 	0, // free
+	0, // unshare
 	0, // get_size
 	int_serialize, // serialize
 	int_deserialize, // deserialize
@@ -697,5 +708,9 @@ IMPLEMENT_TYPE(Extern) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
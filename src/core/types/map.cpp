@@ -98,20 +98,20 @@ Object *map_traverse( Object *me, int index ){
 }
 
 Object *map_clone( Object *me ){
-    MapIterator ki, vi;
     Map *mclone = gc_new_map(),
-              *mme    = (Map *)me;
-    Object    *kclone,
-              *vclone;
-
-    for( ki = mme->keys.begin(), vi = mme->values.begin(); ki != mme->keys.end() && vi != mme->values.end(); ki++, vi++ ){
-        kclone = ob_clone( *ki );
-        vclone = ob_clone( *vi );
-
-        mclone->keys.push_back(kclone);
-        mclone->values.push_back(vclone);
-        mclone->items++;
+        *mme    = (Map *)me;
+    /*
+     * Copy on write, see vector_clone.
+     */
+    if( mme->shares == NULL ){
+    	mme->shares = new size_t(1);
     }
+    ob_share_inc( mme->shares );
+
+    mclone->keys   = mme->keys;
+    mclone->values = mme->values;
+    mclone->items  = mme->items;
+    mclone->shares = mme->shares;
 
     return (Object *)mclone;
 }
@@ -119,11 +119,40 @@ Object *map_clone( Object *me ){
 void map_free( Object *me ){
 	Map *mme = (Map *)me;
 
+	if( mme->shares != NULL ){
+		if( ob_share_dec( mme->shares ) == 0 ){
+			delete mme->shares;
+		}
+		mme->shares = NULL;
+	}
+
     mme->keys.clear();
     mme->values.clear();
     mme->items = 0;
 }
 
+void map_unshare( Object *me ){
+	Map *mme = (Map *)me;
+
+	if( mme->shares != NULL ){
+		/*
+		 * See vector_unshare.
+		 */
+		if( ob_share_dec( mme->shares ) > 0 ){
+			size_t i;
+
+			for( i = 0; i < mme->items; ++i ){
+				mme->keys[i]   = ob_clone( mme->keys[i] );
+				mme->values[i] = ob_clone( mme->values[i] );
+			}
+		}
+		else{
+			delete mme->shares;
+		}
+		mme->shares = NULL;
+	}
+}
+
 size_t map_get_size( Object *me ){
 	return ob_map_ucast(me)->items;
 }
@@ -224,6 +253,8 @@ Object *map_cl_pop( Object *me ){
     	return vm_raise_exception( "could not pop an element from an empty map" );
     }
 
+    map_unshare(me);
+
     Object *kitem = ((Map *)me)->keys[last_idx],
            *vitem = ((Map *)me)->values[last_idx];
 
@@ -240,6 +271,8 @@ Object *map_cl_pop( Object *me ){
 Object *map_cl_remove( Object *me, Object *k ){
     int idx = map_find( me, k );
     if( idx != -1 ){
+    	map_unshare(me);
+
         Object *kitem = ((Map *)me)->keys[idx],
                *vitem = ((Map *)me)->values[idx];
 
@@ -268,6 +301,9 @@ Object *map_cl_at( Object *me, Object *k ){
 
 Object *map_cl_set_reference( Object *me, Object *k, Object *v ){
     int idx = map_find( me, k );
+
+    map_unshare(me);
+
     if( idx != -1 ){
         Object *item = ((Map *)me)->values[idx];
         ob_free(item);
@@ -293,7 +329,6 @@ Object *map_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, cha
 	if( (method = ob_get_builtin_method( me, method_id )) == NULL ){
 		hyb_error( H_ET_SYNTAX, "Map type does not have a '%s' method", method_id );
 	}
-	ll_item_t *iitem;
 	Object  *value,
 			*result;
 	vframe_t stack;
@@ -308,8 +343,8 @@ Object *map_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, cha
 	/*
 	 * Evaluate each object and insert it into the stack
 	 */
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, frame, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, frame, argv->child(i) );
 
 		if( frame->state.is(Exception) ){
 			vm_pop_frame( vm );
@@ -345,6 +380,20 @@ static ob_builtin_method_t map_builtin_methods[] = {
 	OB_BUILIN_METHODS_END_MARKER
 };
 
+/** iterator protocol **/
+bool map_iter_next( Object *me, ob_iterator_t *it, Object **key, Object **value ){
+	if( it->index >= ob_map_ucast(me)->items ){
+		return false;
+	}
+
+	if( key ){
+		*key = ob_map_ucast(me)->keys[it->index];
+	}
+	*value = ob_map_ucast(me)->values[it->index++];
+
+	return true;
+}
+
 IMPLEMENT_TYPE(Map) {
     /** type code **/
     otMap,
@@ -359,6 +408,7 @@ IMPLEMENT_TYPE(Map) {
     map_traverse, // traverse
 	map_clone, // clone
 	map_free, // free
+	map_unshare, // unshare
 	map_get_size, // get_size
 	0, // serialize
 	0, // deserialize
@@ -437,6 +487,10 @@ IMPLEMENT_TYPE(Map) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    map_call_method  // call_method
+    map_call_method, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    map_iter_next  // iter_next
 };
 
@@ -0,0 +1,843 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "hybris.h"
+#include <limits.h>
+
+/*
+ * IntArray and FloatArray share the very same implementation, the only
+ * difference is the item type (long or double), so every kernel down here
+ * is a template over the item type and each type function is just a thin
+ * wrapper around it.
+ *
+ * Kernels work on raw restrict'ed pointers with no function calls inside
+ * the loops, this way -O3 (with -ffast-math for doubles) turns them into
+ * SIMD code.
+ */
+#define NA_RESTRICT __restrict__
+
+template< typename T > struct na_object;
+
+template<> struct na_object<long> {
+	typedef IntArray array_t;
+
+	static INLINE bool    is( Object *o )      { return ob_is_intarray(o); }
+	static INLINE long    value( Object *o )   { return ob_ivalue(o); }
+	static INLINE Object *box( long v )        { return ob_dcast( gc_new_integer(v) ); }
+	static INLINE array_t *create()            { return gc_new_intarray(); }
+	static INLINE const char *name()           { return "intarray"; }
+	static INLINE const char *format()         { return "%ld\n"; }
+	static const bool integral = true;
+};
+
+template<> struct na_object<double> {
+	typedef FloatArray array_t;
+
+	static INLINE bool    is( Object *o )      { return ob_is_floatarray(o); }
+	static INLINE double  value( Object *o )   { return ob_fvalue(o); }
+	static INLINE Object *box( double v )      { return ob_dcast( gc_new_float(v) ); }
+	static INLINE array_t *create()            { return gc_new_floatarray(); }
+	static INLINE const char *name()           { return "floatarray"; }
+	static INLINE const char *format()         { return "%lf\n"; }
+	static const bool integral = false;
+};
+
+#define na_ucast(T,o) ((typename na_object<T>::array_t *)(o))
+
+/** kernels **/
+template< typename T > static T na_sum( const T * NA_RESTRICT v, size_t n ){
+	/*
+	 * Four independent accumulators break the loop carried dependency
+	 * and map directly on vector lanes.
+	 */
+	T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	size_t i;
+
+	for( i = 0; i + 4 <= n; i += 4 ){
+		s0 += v[i];
+		s1 += v[i + 1];
+		s2 += v[i + 2];
+		s3 += v[i + 3];
+	}
+	for( ; i < n; ++i ){
+		s0 += v[i];
+	}
+
+	return (s0 + s1) + (s2 + s3);
+}
+
+template< typename T > static T na_min( const T * NA_RESTRICT v, size_t n ){
+	T m = v[0];
+	size_t i;
+
+	for( i = 1; i < n; ++i ){
+		m = v[i] < m ? v[i] : m;
+	}
+
+	return m;
+}
+
+template< typename T > static T na_max( const T * NA_RESTRICT v, size_t n ){
+	T m = v[0];
+	size_t i;
+
+	for( i = 1; i < n; ++i ){
+		m = v[i] > m ? v[i] : m;
+	}
+
+	return m;
+}
+
+/*
+ * 'R' is the accumulator type, double as soon as one of the two operands
+ * is a FloatArray so that mixed products are not truncated.
+ */
+template< typename R, typename T, typename U > static R na_dot( const T * NA_RESTRICT a, const U * NA_RESTRICT b, size_t n ){
+	R s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	size_t i;
+
+	for( i = 0; i + 4 <= n; i += 4 ){
+		s0 += (R)a[i]     * (R)b[i];
+		s1 += (R)a[i + 1] * (R)b[i + 1];
+		s2 += (R)a[i + 2] * (R)b[i + 2];
+		s3 += (R)a[i + 3] * (R)b[i + 3];
+	}
+	for( ; i < n; ++i ){
+		s0 += (R)a[i] * (R)b[i];
+	}
+
+	return (s0 + s1) + (s2 + s3);
+}
+
+struct na_add { template< typename T > static INLINE T apply( T a, T b ){ return a + b; } };
+struct na_sub { template< typename T > static INLINE T apply( T a, T b ){ return a - b; } };
+struct na_mul { template< typename T > static INLINE T apply( T a, T b ){ return a * b; } };
+struct na_div { template< typename T > static INLINE T apply( T a, T b ){ return a / b; } };
+
+template< typename OP, typename T > static void na_apply_scalar( T * NA_RESTRICT r, const T * NA_RESTRICT a, T b, size_t n ){
+	size_t i;
+	for( i = 0; i < n; ++i ){
+		r[i] = OP::apply( a[i], b );
+	}
+}
+
+template< typename OP, typename T, typename U > static void na_apply_array( T * NA_RESTRICT r, const T * NA_RESTRICT a, const U * NA_RESTRICT b, size_t n ){
+	size_t i;
+	for( i = 0; i < n; ++i ){
+		r[i] = OP::apply( a[i], (T)b[i] );
+	}
+}
+/*
+ * In place versions, 'r' aliases 'a' (and 'b' too for a statement like
+ * a *= a) so no restrict here, the compiler will emit a runtime alias
+ * check and still use the vectorized loop when possible.
+ */
+template< typename OP, typename T > static void na_inplace_scalar( T *r, T b, size_t n ){
+	size_t i;
+	for( i = 0; i < n; ++i ){
+		r[i] = OP::apply( r[i], b );
+	}
+}
+
+template< typename OP, typename T, typename U > static void na_inplace_array( T *r, const U *b, size_t n ){
+	size_t i;
+	for( i = 0; i < n; ++i ){
+		r[i] = OP::apply( r[i], (T)b[i] );
+	}
+}
+/*
+ * Integer division by zero, as well as LONG_MIN / -1, would just kill the
+ * process with a SIGFPE, so operands are checked before the division kernels
+ * are executed, return the error message or NULL if it's safe to divide.
+ */
+template< typename T, typename U > static const char *na_div_error( const T *a, const U *b, size_t n ){
+	size_t i;
+	for( i = 0; i < n; ++i ){
+		if( (long)b[i] == 0 ){
+			return "division by zero";
+		}
+		else if( (long)b[i] == -1 && (long)a[i] == LONG_MIN ){
+			return "integer overflow in division";
+		}
+	}
+	return NULL;
+}
+
+template< typename T > static const char *na_div_error( const T *a, T b, size_t n ){
+	size_t i;
+
+	if( (long)b == 0 ){
+		return "division by zero";
+	}
+	else if( (long)b == -1 ){
+		for( i = 0; i < n; ++i ){
+			if( (long)a[i] == LONG_MIN ){
+				return "integer overflow in division";
+			}
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Compute 'me' <op> 'op' where 'op' could be an IntArray, a FloatArray
+ * or any scalar object, and store the result into 'dst' (which could
+ * be 'me' itself for in place operators).
+ */
+template< typename OP, typename T > static Object *na_binary( Object *me, Object *op, Object *dst, bool is_div ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me),
+								   *adst = na_ucast(T,dst);
+	size_t n = ame->items;
+	bool   integral = na_object<T>::integral;
+
+	if( ob_is_intarray(op) || ob_is_floatarray(op) ){
+		size_t op_items = ob_is_intarray(op) ? ob_intarray_ucast(op)->items : ob_floatarray_ucast(op)->items;
+		if( op_items != n ){
+			return vm_raise_exception( "array size mismatch (%d vs %d)", n, op_items );
+		}
+	}
+
+	if( dst != me ){
+		adst->value.resize(n);
+		adst->items = n;
+	}
+
+	if( n == 0 ){
+		return dst;
+	}
+
+	T *r = &adst->value[0];
+	const T *a = &ame->value[0];
+	const char *error;
+
+	if( ob_is_intarray(op) ){
+		const long *b = &ob_intarray_ucast(op)->value[0];
+		if( is_div && integral && (error = na_div_error( a, b, n )) != NULL ){
+			return vm_raise_exception( error );
+		}
+		if( dst == me ){
+			na_inplace_array<OP>( r, b, n );
+		}
+		else{
+			na_apply_array<OP>( r, a, b, n );
+		}
+	}
+	else if( ob_is_floatarray(op) ){
+		const double *b = &ob_floatarray_ucast(op)->value[0];
+		if( is_div && integral && (error = na_div_error( a, b, n )) != NULL ){
+			return vm_raise_exception( error );
+		}
+		if( dst == me ){
+			na_inplace_array<OP>( r, b, n );
+		}
+		else{
+			na_apply_array<OP>( r, a, b, n );
+		}
+	}
+	else{
+		T b = na_object<T>::value(op);
+		if( is_div && integral && (error = na_div_error( a, b, n )) != NULL ){
+			return vm_raise_exception( error );
+		}
+		if( dst == me ){
+			na_inplace_scalar<OP>( r, b, n );
+		}
+		else{
+			na_apply_scalar<OP>( r, a, b, n );
+		}
+	}
+
+	return dst;
+}
+
+template< typename OP, typename T > INLINE Object *na_operator( Object *me, Object *op, bool is_div = false ){
+	return na_binary<OP,T>( me, op, ob_dcast( na_object<T>::create() ), is_div );
+}
+
+template< typename OP, typename T > INLINE Object *na_inplace_operator( Object *me, Object *op, bool is_div = false ){
+	return na_binary<OP,T>( me, op, me, is_div );
+}
+
+/** builtin methods **/
+template< typename T > static Object *na_builtin_sum( vm_t *vm, Object *me, vframe_t *data ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+
+	return na_object<T>::box( ame->items ? na_sum( &ame->value[0], ame->items ) : 0 );
+}
+
+template< typename T > static Object *na_builtin_min( vm_t *vm, Object *me, vframe_t *data ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+
+	if( ame->items == 0 ){
+		return vm_raise_exception( "could not compute the minimum of an empty array" );
+	}
+
+	return na_object<T>::box( na_min( &ame->value[0], ame->items ) );
+}
+
+template< typename T > static Object *na_builtin_max( vm_t *vm, Object *me, vframe_t *data ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+
+	if( ame->items == 0 ){
+		return vm_raise_exception( "could not compute the maximum of an empty array" );
+	}
+
+	return na_object<T>::box( na_max( &ame->value[0], ame->items ) );
+}
+
+template< typename T > static Object *na_builtin_mean( vm_t *vm, Object *me, vframe_t *data ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+
+	if( ame->items == 0 ){
+		return vm_raise_exception( "could not compute the mean of an empty array" );
+	}
+
+	return ob_dcast( gc_new_float( (double)na_sum( &ame->value[0], ame->items ) / (double)ame->items ) );
+}
+
+template< typename T > static Object *na_builtin_dot( vm_t *vm, Object *me, vframe_t *data ){
+	if( vm_argc() != 1 ){
+		hyb_error( H_ET_SYNTAX, "method 'dot' requires 1 parameter (called with %d)", vm_argc() );
+	}
+
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	Object *op = vm_argv(0);
+	size_t  n  = ame->items;
+
+	if( ob_is_intarray(op) ){
+		if( ob_intarray_ucast(op)->items != n ){
+			return vm_raise_exception( "array size mismatch (%d vs %d)", n, ob_intarray_ucast(op)->items );
+		}
+		return na_object<T>::box( n ? na_dot<T>( &ame->value[0], &ob_intarray_ucast(op)->value[0], n ) : 0 );
+	}
+	else if( ob_is_floatarray(op) ){
+		if( ob_floatarray_ucast(op)->items != n ){
+			return vm_raise_exception( "array size mismatch (%d vs %d)", n, ob_floatarray_ucast(op)->items );
+		}
+		return ob_dcast( gc_new_float( n ? na_dot<double>( &ame->value[0], &ob_floatarray_ucast(op)->value[0], n ) : 0.0 ) );
+	}
+
+	hyb_error( H_ET_SYNTAX, "method 'dot' requires an intarray or a floatarray parameter, '%s' given", ob_typename(op) );
+
+	return H_DEFAULT_ERROR;
+}
+
+template< typename T > static Object *na_builtin_tovector( vm_t *vm, Object *me, vframe_t *data ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	Vector *v = gc_new_vector();
+	size_t  i;
+
+	v->value.reserve( ame->items );
+	for( i = 0; i < ame->items; ++i ){
+		ob_cl_push_reference( ob_dcast(v), na_object<T>::box( ame->value[i] ) );
+	}
+
+	return ob_dcast(v);
+}
+
+template< typename T > static Object *na_from_collection( Object *o ){
+	typename na_object<T>::array_t *array = na_object<T>::create();
+	size_t i, size( ob_get_size(o) );
+
+	if( ob_is_intarray(o) || ob_is_floatarray(o) ){
+		array->value.resize(size);
+		for( i = 0; i < size; ++i ){
+			array->value[i] = ob_is_intarray(o) ? (T)ob_intarray_ucast(o)->value[i] : (T)ob_floatarray_ucast(o)->value[i];
+		}
+	}
+	else if( ob_is_vector(o) ){
+		array->value.resize(size);
+		for( i = 0; i < size; ++i ){
+			array->value[i] = na_object<T>::value( ob_vector_ucast(o)->value[i] );
+		}
+	}
+	else{
+		Integer index(0);
+
+		array->value.resize(size);
+		for( ; (size_t)index.value < size; ++index.value ){
+			array->value[index.value] = na_object<T>::value( ob_cl_at( o, (Object *)&index ) );
+		}
+	}
+	array->items = size;
+
+	return ob_dcast(array);
+}
+
+/** generic function pointers **/
+template< typename T > static Object *na_clone( Object *me ){
+	typename na_object<T>::array_t *clone = na_object<T>::create();
+
+	clone->value = na_ucast(T,me)->value;
+	clone->items = na_ucast(T,me)->items;
+
+	return ob_dcast(clone);
+}
+
+template< typename T > static void na_free( Object *me ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	/*
+	 * The gc deletes the object through an Object pointer, so the
+	 * vector destructor is never called, release its buffer here.
+	 */
+	vector<T>().swap( ame->value );
+	ame->items = 0;
+}
+
+template< typename T > static size_t na_get_size( Object *me ){
+	return na_ucast(T,me)->items;
+}
+
+template< typename T > static Object *na_to_fd( Object *me, int fd, size_t size ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	size_t s = (size > ame->items ? ame->items : size != 0 ? size : ame->items);
+	int    written(0);
+
+	if( s ){
+		written = write( fd, &ame->value[0], s * sizeof(T) );
+	}
+
+	return ob_dcast( gc_new_integer(written) );
+}
+
+template< typename T > static int na_cmp( Object *me, Object *cmp ){
+	if( !na_object<T>::is(cmp) ){
+		return 1;
+	}
+
+	typename na_object<T>::array_t *ame  = na_ucast(T,me),
+								   *acmp = na_ucast(T,cmp);
+	size_t i;
+
+	if( ame->items > acmp->items ){
+		return 1;
+	}
+	else if( ame->items < acmp->items ){
+		return -1;
+	}
+
+	for( i = 0; i < ame->items; ++i ){
+		if( ame->value[i] > acmp->value[i] ){
+			return 1;
+		}
+		else if( ame->value[i] < acmp->value[i] ){
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+template< typename T > static long na_ivalue( Object *me ){
+	return static_cast<long>( na_ucast(T,me)->items );
+}
+
+template< typename T > static double na_fvalue( Object *me ){
+	return static_cast<double>( na_ucast(T,me)->items );
+}
+
+template< typename T > static bool na_lvalue( Object *me ){
+	return static_cast<bool>( na_ucast(T,me)->items );
+}
+
+template< typename T > static string na_svalue( Object *me ){
+	return string("<") + na_object<T>::name() + ">";
+}
+
+template< typename T > static void na_print( Object *me, int tabs ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	size_t i;
+	int    j;
+
+	for( j = 0; j < tabs; ++j ){
+		fprintf( stdout, "\t" );
+	}
+	fprintf( stdout, "%s {\n", na_object<T>::name() );
+	for( i = 0; i < ame->items; ++i ){
+		for( j = 0; j < tabs + 1; ++j ){
+			fprintf( stdout, "\t" );
+		}
+		fprintf( stdout, na_object<T>::format(), ame->value[i] );
+	}
+	for( j = 0; j < tabs; ++j ){
+		fprintf( stdout, "\t" );
+	}
+	fprintf( stdout, "}\n" );
+}
+
+/** arithmetic operators **/
+template< typename T > static Object *na_assign( Object *me, Object *op ){
+	na_free<T>(me);
+
+	Object *clone = ob_clone(op);
+
+	return me = clone;
+}
+
+/** collection operators **/
+template< typename T > static Object *na_cl_push( Object *me, Object *o ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+
+	ame->value.push_back( na_object<T>::value(o) );
+	ame->items++;
+
+	return me;
+}
+
+template< typename T > static Object *na_cl_pop( Object *me ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+
+	if( ame->items == 0 ){
+		return vm_raise_exception( "could not pop an element from an empty array" );
+	}
+
+	T last = ame->value.back();
+	ame->value.pop_back();
+	ame->items--;
+
+	return na_object<T>::box(last);
+}
+
+template< typename T > static Object *na_cl_remove( Object *me, Object *i ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	size_t idx = ob_ivalue(i);
+
+	if( idx >= ame->items ){
+		return vm_raise_exception( "index out of bounds" );
+	}
+
+	T item = ame->value[idx];
+	ame->value.erase( ame->value.begin() + idx );
+	ame->items--;
+
+	return na_object<T>::box(item);
+}
+
+template< typename T > static Object *na_cl_at( Object *me, Object *i ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	size_t idx = ob_ivalue(i);
+
+	if( idx >= ame->items ){
+		return vm_raise_exception( "index out of bounds" );
+	}
+
+	return na_object<T>::box( ame->value[idx] );
+}
+
+template< typename T > static Object *na_cl_set( Object *me, Object *i, Object *v ){
+	typename na_object<T>::array_t *ame = na_ucast(T,me);
+	size_t idx = ob_ivalue(i);
+
+	if( idx >= ame->items ){
+		return vm_raise_exception( "index out of bounds" );
+	}
+
+	ame->value[idx] = na_object<T>::value(v);
+
+	return me;
+}
+
+template< typename T > static Object *na_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, char *method_id, Node *argv ){
+	ob_type_builtin_method_t *method = NULL;
+
+	if( (method = ob_get_builtin_method( me, method_id )) == NULL ){
+		hyb_error( H_ET_SYNTAX, "%s type does not have a '%s' method", na_object<T>::name(), method_id );
+	}
+
+	Object  *value,
+			*result;
+	vframe_t stack;
+	size_t   i, argc = argv->children.items;
+
+	vm_add_frame( vm, &stack );
+
+	stack.owner = ob_typename(me) + string("::") + method_id;
+
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, frame, argv->child(i) );
+
+		if( frame->state.is(Exception) ){
+			vm_pop_frame( vm );
+			return frame->state.e_value;
+		}
+		else if( frame->state.is(Return) ){
+			vm_pop_frame( vm );
+			return frame->state.r_value;
+		}
+
+		stack.push( value );
+	}
+
+	result = ((ob_type_builtin_method_t)method)( vm, me, &stack );
+
+	vm_pop_frame( vm );
+
+	return (result == H_UNDEFINED ? H_DEFAULT_RETURN : result);
+}
+
+/*
+ * Non template entry points, used by the type tables and by the
+ * std.lang.type module.
+ */
+Object *intarray_from_collection( Object *o ){
+	return na_from_collection<long>(o);
+}
+
+Object *floatarray_from_collection( Object *o ){
+	return na_from_collection<double>(o);
+}
+
+Object *__intarray_size( vm_t *vm, Object *me, vframe_t *data ){
+	return ob_dcast( gc_new_integer( ob_intarray_ucast(me)->items ) );
+}
+
+Object *__floatarray_size( vm_t *vm, Object *me, vframe_t *data ){
+	return ob_dcast( gc_new_integer( ob_floatarray_ucast(me)->items ) );
+}
+
+Object *intarray_add( Object *me, Object *op ){ return na_operator<na_add,long>( me, op ); }
+Object *intarray_sub( Object *me, Object *op ){ return na_operator<na_sub,long>( me, op ); }
+Object *intarray_mul( Object *me, Object *op ){ return na_operator<na_mul,long>( me, op ); }
+Object *intarray_div( Object *me, Object *op ){ return na_operator<na_div,long>( me, op, true ); }
+Object *intarray_inplace_add( Object *me, Object *op ){ return na_inplace_operator<na_add,long>( me, op ); }
+Object *intarray_inplace_sub( Object *me, Object *op ){ return na_inplace_operator<na_sub,long>( me, op ); }
+Object *intarray_inplace_mul( Object *me, Object *op ){ return na_inplace_operator<na_mul,long>( me, op ); }
+Object *intarray_inplace_div( Object *me, Object *op ){ return na_inplace_operator<na_div,long>( me, op, true ); }
+
+Object *floatarray_add( Object *me, Object *op ){ return na_operator<na_add,double>( me, op ); }
+Object *floatarray_sub( Object *me, Object *op ){ return na_operator<na_sub,double>( me, op ); }
+Object *floatarray_mul( Object *me, Object *op ){ return na_operator<na_mul,double>( me, op ); }
+Object *floatarray_div( Object *me, Object *op ){ return na_operator<na_div,double>( me, op, true ); }
+Object *floatarray_inplace_add( Object *me, Object *op ){ return na_inplace_operator<na_add,double>( me, op ); }
+Object *floatarray_inplace_sub( Object *me, Object *op ){ return na_inplace_operator<na_sub,double>( me, op ); }
+Object *floatarray_inplace_mul( Object *me, Object *op ){ return na_inplace_operator<na_mul,double>( me, op ); }
+Object *floatarray_inplace_div( Object *me, Object *op ){ return na_inplace_operator<na_div,double>( me, op, true ); }
+
+static ob_builtin_method_t intarray_builtin_methods[] = {
+	{ "size",     (ob_type_builtin_method_t *)__intarray_size },
+	{ "sum",      (ob_type_builtin_method_t *)na_builtin_sum<long> },
+	{ "min",      (ob_type_builtin_method_t *)na_builtin_min<long> },
+	{ "max",      (ob_type_builtin_method_t *)na_builtin_max<long> },
+	{ "mean",     (ob_type_builtin_method_t *)na_builtin_mean<long> },
+	{ "dot",      (ob_type_builtin_method_t *)na_builtin_dot<long> },
+	{ "tovector", (ob_type_builtin_method_t *)na_builtin_tovector<long> },
+	OB_BUILIN_METHODS_END_MARKER
+};
+
+static ob_builtin_method_t floatarray_builtin_methods[] = {
+	{ "size",     (ob_type_builtin_method_t *)__floatarray_size },
+	{ "sum",      (ob_type_builtin_method_t *)na_builtin_sum<double> },
+	{ "min",      (ob_type_builtin_method_t *)na_builtin_min<double> },
+	{ "max",      (ob_type_builtin_method_t *)na_builtin_max<double> },
+	{ "mean",     (ob_type_builtin_method_t *)na_builtin_mean<double> },
+	{ "dot",      (ob_type_builtin_method_t *)na_builtin_dot<double> },
+	{ "tovector", (ob_type_builtin_method_t *)na_builtin_tovector<double> },
+	OB_BUILIN_METHODS_END_MARKER
+};
+
+IMPLEMENT_TYPE(IntArray) {
+    /** type code **/
+    otIntArray,
+	/** type name **/
+    "intarray",
+	/** type basic size **/
+    OB_COLLECTION_SIZE,
+    /** type builtin methods **/
+    intarray_builtin_methods,
+	/** generic function pointers **/
+    0, // type_name
+    0, // traverse
+	na_clone<long>, // clone
+	na_free<long>, // free
+	0, // unshare
+	na_get_size<long>, // get_size
+	0, // serialize
+	0, // deserialize
+	na_to_fd<long>, // to_fd
+	0, // from_fd
+	na_cmp<long>, // cmp
+	na_ivalue<long>, // ivalue
+	na_fvalue<long>, // fvalue
+	na_lvalue<long>, // lvalue
+	na_svalue<long>, // svalue
+	na_print<long>, // print
+	0, // scanf
+	0, // to_string
+	0, // to_int
+	0, // range
+	0, // regexp
+
+	/** arithmetic operators **/
+	na_assign<long>, // assign
+    0, // factorial
+    0, // increment
+    0, // decrement
+    0, // minus
+    intarray_add, // add
+    intarray_sub, // sub
+    intarray_mul, // mul
+    intarray_div, // div
+    0, // mod
+    intarray_inplace_add, // inplace_add
+    intarray_inplace_sub, // inplace_sub
+    intarray_inplace_mul, // inplace_mul
+    intarray_inplace_div, // inplace_div
+    0, // inplace_mod
+
+	/** bitwise operators **/
+	0, // bw_and
+    0, // bw_or
+    0, // bw_not
+    0, // bw_xor
+    0, // bw_lshift
+    0, // bw_rshift
+    0, // bw_inplace_and
+    0, // bw_inplace_or
+    0, // bw_inplace_xor
+    0, // bw_inplace_lshift
+    0, // bw_inplace_rshift
+
+	/** logic operators **/
+    0, // l_not
+    0, // l_same
+    0, // l_diff
+    0, // l_less
+    0, // l_greater
+    0, // l_less_or_same
+    0, // l_greater_or_same
+    0, // l_or
+    0, // l_and
+
+	/** collection operators **/
+	na_cl_push<long>, // cl_push
+	na_cl_push<long>, // cl_push_reference
+	na_cl_pop<long>, // cl_pop
+	na_cl_remove<long>, // cl_remove
+	na_cl_at<long>, // cl_at
+	na_cl_set<long>, // cl_set
+	na_cl_set<long>, // cl_set_reference
+
+	/** structure operators **/
+	0, // define_attribute
+	0, // attribute_access
+	0, // attribute_is_static
+	0, // set_attribute_access
+    0, // add_attribute;
+    0, // get_attribute;
+    0, // set_attribute;
+    0, // set_attribute_reference
+    0, // define_method
+    0, // get_method
+    na_call_method<long>  // call_method
+};
+
+IMPLEMENT_TYPE(FloatArray) {
+    /** type code **/
+    otFloatArray,
+	/** type name **/
+    "floatarray",
+	/** type basic size **/
+    OB_COLLECTION_SIZE,
+    /** type builtin methods **/
+    floatarray_builtin_methods,
+	/** generic function pointers **/
+    0, // type_name
+    0, // traverse
+	na_clone<double>, // clone
+	na_free<double>, // free
+	0, // unshare
+	na_get_size<double>, // get_size
+	0, // serialize
+	0, // deserialize
+	na_to_fd<double>, // to_fd
+	0, // from_fd
+	na_cmp<double>, // cmp
+	na_ivalue<double>, // ivalue
+	na_fvalue<double>, // fvalue
+	na_lvalue<double>, // lvalue
+	na_svalue<double>, // svalue
+	na_print<double>, // print
+	0, // scanf
+	0, // to_string
+	0, // to_int
+	0, // range
+	0, // regexp
+
+	/** arithmetic operators **/
+	na_assign<double>, // assign
+    0, // factorial
+    0, // increment
+    0, // decrement
+    0, // minus
+    floatarray_add, // add
+    floatarray_sub, // sub
+    floatarray_mul, // mul
+    floatarray_div, // div
+    0, // mod
+    floatarray_inplace_add, // inplace_add
+    floatarray_inplace_sub, // inplace_sub
+    floatarray_inplace_mul, // inplace_mul
+    floatarray_inplace_div, // inplace_div
+    0, // inplace_mod
+
+	/** bitwise operators **/
+	0, // bw_and
+    0, // bw_or
+    0, // bw_not
+    0, // bw_xor
+    0, // bw_lshift
+    0, // bw_rshift
+    0, // bw_inplace_and
+    0, // bw_inplace_or
+    0, // bw_inplace_xor
+    0, // bw_inplace_lshift
+    0, // bw_inplace_rshift
+
+	/** logic operators **/
+    0, // l_not
+    0, // l_same
+    0, // l_diff
+    0, // l_less
+    0, // l_greater
+    0, // l_less_or_same
+    0, // l_greater_or_same
+    0, // l_or
+    0, // l_and
+
+	/** collection operators **/
+	na_cl_push<double>, // cl_push
+	na_cl_push<double>, // cl_push_reference
+	na_cl_pop<double>, // cl_pop
+	na_cl_remove<double>, // cl_remove
+	na_cl_at<double>, // cl_at
+	na_cl_set<double>, // cl_set
+	na_cl_set<double>, // cl_set_reference
+
+	/** structure operators **/
+	0, // define_attribute
+	0, // attribute_access
+	0, // attribute_is_static
+	0, // set_attribute_access
+    0, // add_attribute;
+    0, // get_attribute;
+    0, // set_attribute;
+    0, // set_attribute_reference
+    0, // define_method
+    0, // get_method
+    na_call_method<double>  // call_method
+};
@@ -42,6 +42,12 @@ Object *ref_clone( Object *me ){
     return (Object *)rclone;
 }
 
+void ref_unshare( Object *me ){
+	if( ob_ref_ucast(me)->value ){
+		ob_unshare( ob_ref_ucast(me)->value );
+	}
+}
+
 size_t ref_get_size( Object *me ){
 	return ob_ref_ucast(me)->value ? ob_get_size( ob_ref_ucast(me)->value ) : 0;
 }
@@ -452,6 +458,14 @@ Object *ref_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, cha
 	return ob_call_method( vm, frame, me, me_id, method_id, argv );
 }
 
+/** iterator protocol **/
+void ref_iter_begin( Object *me, ob_iterator_t *it ){
+	/*
+	 * Iterate the referenced object.
+	 */
+	ob_iter_begin( ob_ref_ucast(me)->value, it );
+}
+
 IMPLEMENT_TYPE(Reference) {
     /** type code **/
     otReference,
@@ -466,6 +480,7 @@ IMPLEMENT_TYPE(Reference) {
     ref_traverse, // traverse
 	ref_clone, // clone
 	0, // free
+	ref_unshare, // unshare
 	ref_get_size, // get_size
 	ref_serialize, // serialize
 	ref_deserialize, // deserialize
@@ -544,6 +559,10 @@ IMPLEMENT_TYPE(Reference) {
     ref_set_attribute_reference,  // set_attribute_reference
     ref_define_method, // define_method
     ref_get_method,  // get_method
-    ref_call_method // call_method
+    ref_call_method, // call_method
+
+    /** iterator protocol **/
+    ref_iter_begin, // iter_begin
+    0  // iter_next
 };
 
@@ -79,8 +79,8 @@ Object *__string_replace( vm_t *vm, Object *me, vframe_t *data ){
 
 	string str  = ob_string_ucast(me)->value,
 		   tmp  = str,
-		   find = ob_svalue( data->at(0) ),
-		   repl = ob_svalue( data->at(1) );
+		   find = ob_svalue( vm_argv(0) ),
+		   repl = ob_svalue( vm_argv(1) );
 
 	int    i,
 		   f_len( find.length() ),
@@ -149,7 +149,15 @@ Object *__string_repeat( vm_t *vm, Object *me, vframe_t *data ){
 
 /** generic function pointers **/
 Object *string_clone( Object *me ){
-    return (Object *)gc_new_string( ob_string_ucast(me)->value.c_str() );
+	String *sclone = gc_new_string("");
+	/*
+	 * Assign the std::string instead of building a new one from its
+	 * C string, so no strlen is needed, the buffer is still copied.
+	 */
+	sclone->value = ob_string_ucast(me)->value;
+	sclone->items = ob_string_ucast(me)->items;
+
+    return (Object *)sclone;
 }
 
 size_t string_get_size( Object *me ){
@@ -288,9 +296,9 @@ void string_parse_pcre( string& raw, string& regex, int& opts ){
     string       pattern("^/(.*?)/([i|m|s|x|U]*)$"),
 				 sopts;
     pcre 		*compiled;
-    extern vm_t *__hyb_vm;
+    vm_t        *vm = vm_current();
 
-    compiled = vm_pcre_compile( __hyb_vm, pattern, 0, &error, &eoffset );
+    compiled = vm_pcre_compile( vm, pattern, 0, &error, &eoffset );
     rc 		 = pcre_fullinfo( compiled, 0, PCRE_INFO_CAPTURECOUNT, &ccount );
     offsets  = new int[ 3 * (ccount + 1) ];
     rc 		 = pcre_exec( compiled, 0, raw.c_str(), raw.length(), 0, 0, offsets, 3 * (ccount + 1) );
@@ -329,12 +337,12 @@ Object * string_regexp( Object *me, Object *r ){
 	const char  *error;
 	pcre 		*compiled;
 	Object      *_pcre_return;
-	extern vm_t *__hyb_vm;
+	vm_t        *vm = vm_current();
 
 
 	string_parse_pcre( rawreg, pattern, opts );
 
-	compiled = vm_pcre_compile( __hyb_vm, pattern, opts, &error, &eoffset );
+	compiled = vm_pcre_compile( vm, pattern, opts, &error, &eoffset );
 	if( !compiled ){
 		return vm_raise_exception( "error during regex evaluation at offset %d (%s)", eoffset, error );
     }
@@ -448,7 +456,6 @@ Object *string_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id,
 	if( (method = ob_get_builtin_method( me, method_id )) == NULL ){
 		hyb_error( H_ET_SYNTAX, "String type does not have a '%s' method", method_id );
 	}
-	ll_item_t *iitem;
 	Object  *value,
 			*result;
 	vframe_t stack;
@@ -463,8 +470,8 @@ Object *string_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id,
 	/*
 	 * Evaluate each object and insert it into the stack
 	 */
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, frame, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, frame, argv->child(i) );
 
 		if( frame->state.is(Exception) ){
 			vm_pop_frame( vm );
@@ -515,6 +522,7 @@ IMPLEMENT_TYPE(String) {
     0, // traverse
 	string_clone, // clone
 	0, // free
+	0, // unshare
 	string_get_size, // get_size
 	string_serialize, // serialize
 	string_deserialize, // deserialize
@@ -593,6 +601,10 @@ IMPLEMENT_TYPE(String) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    string_call_method // call_method
+    string_call_method, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
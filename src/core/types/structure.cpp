@@ -142,6 +142,7 @@ IMPLEMENT_TYPE(Structure) {
     struct_traverse, // traverse
 	struct_clone, // clone
 	struct_free, // free
+	0, // unshare
 	struct_get_size, // get_size
 	0, // serialize
 	0, // deserialize
@@ -220,6 +221,10 @@ IMPLEMENT_TYPE(Structure) {
     struct_set_attribute_reference, // set_attribute_reference
     0, // define_method
     0, // get_method
-    0  // call_method
+    0, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    0  // iter_next
 };
 
@@ -40,13 +40,16 @@ Object *__vector_contains( vm_t *vm, Object *me, vframe_t *data ){
 		hyb_error( H_ET_SYNTAX, "method 'contains' requires 1 parameter (called with %d)", vm_argc() );
 	}
 
-	Object *array = me,
-		   *find  = vm_argv(0);
-	Integer index(0);
-	int size( ob_get_size(array) );
+	Vector *array = ob_vector_ucast(me);
+	Object *find  = vm_argv(0);
+	size_t  i;
 
-	for( ; index.value < size; ++index.value ){
-		if( ob_cmp( ob_cl_at( array, (Object *)&index ), find ) == 0 ){
+	/*
+	 * Items are read directly, ob_cl_at could hand them out to be
+	 * modified, so it would unshare a copy on write vector.
+	 */
+	for( i = 0; i < array->items; ++i ){
+		if( ob_cmp( array->value[i], find ) == 0 ){
 			return (Object *)gc_new_boolean(true);
 		}
 	}
@@ -55,15 +58,14 @@ Object *__vector_contains( vm_t *vm, Object *me, vframe_t *data ){
 }
 
 Object *__vector_unique( vm_t *vm, Object *me, vframe_t *data ){
-	Object *array  = me,
-		   *unique = (Object *)gc_new_vector(),
+	Vector *array  = ob_vector_ucast(me);
+	Object *unique = (Object *)gc_new_vector(),
 		   *item;
-	Integer index(0);
-	int size( ob_get_size(array) );
+	size_t  i;
 	bool contains;
 
-	for( ; index.value < size; ++index.value ){
-		item 	 = ob_cl_at( array, (Object *)&index );
+	for( i = 0; i < array->items; ++i ){
+		item 	 = array->value[i];
 		contains = false;
 
 		Integer index_u(0);
@@ -101,14 +103,13 @@ Object *__vector_join( vm_t *vm, Object *me, vframe_t *data ){
 }
 
 Object *__vector_max( vm_t *vm, Object *me, vframe_t *data ){
-	Object *array = me,
-		   *obj,
+	Vector *array = ob_vector_ucast(me);
+	Object *obj,
 		   *max   = NULL;
-	Integer index(0);
-	int size( ob_get_size(array) );
+	size_t  i;
 
-	for( ; index.value < size; ++index.value ){
-		obj = ob_cl_at( array, (Object *)&index );
+	for( i = 0; i < array->items; ++i ){
+		obj = array->value[i];
 		if( max == NULL || ob_cmp( obj, max ) == 1 ){
 			max = obj;
 		}
@@ -118,14 +119,13 @@ Object *__vector_max( vm_t *vm, Object *me, vframe_t *data ){
 }
 
 Object *__vector_min( vm_t *vm, Object *me, vframe_t *data ){
-	Object *array = me,
-		   *obj,
+	Vector *array = ob_vector_ucast(me);
+	Object *obj,
 		   *min   = NULL;
-	Integer index(0);
-	int size( ob_get_size(array) );
+	size_t  i;
 
-	for( ; index.value < size; ++index.value ){
-		obj = ob_cl_at( array, (Object *)&index );
+	for( i = 0; i < array->items; ++i ){
+		obj = array->value[i];
 		if( min == NULL || ob_cmp( obj, min ) == -1 ){
 			min = obj;
 		}
@@ -140,13 +140,21 @@ Object *vector_traverse( Object *me, int index ){
 }
 
 Object *vector_clone( Object *me ){
-    VectorIterator i;
     Vector *vclone = gc_new_vector(),
            *vme    = ob_vector_ucast(me);
-
-    vv_foreach( vector<Object *>, i, vme->value ){
-        ob_cl_push_reference( (Object *)vclone, ob_clone( *i ) );
+    /*
+     * Copy on write, the clone just shares the items of this vector,
+     * they will be cloned by vector_unshare the first time one of the
+     * two vectors is modified.
+     */
+    if( vme->shares == NULL ){
+    	vme->shares = new size_t(1);
     }
+    ob_share_inc( vme->shares );
+
+    vclone->value  = vme->value;
+    vclone->items  = vme->items;
+    vclone->shares = vme->shares;
 
     return (Object *)vclone;
 }
@@ -154,10 +162,40 @@ Object *vector_clone( Object *me ){
 void vector_free( Object *me ){
     Vector *vme = ob_vector_ucast(me);
 
+    if( vme->shares != NULL ){
+    	if( ob_share_dec( vme->shares ) == 0 ){
+    		delete vme->shares;
+    	}
+    	vme->shares = NULL;
+    }
+
     vme->items = 0;
     vme->value.clear();
 }
 
+void vector_unshare( Object *me ){
+	Vector *vme = ob_vector_ucast(me);
+
+	if( vme->shares != NULL ){
+		/*
+		 * Checking the counter and decrementing it is a single atomic
+		 * step, so if two sharers unshare at the same time only one of
+		 * them clones the items and the other keeps them.
+		 */
+		if( ob_share_dec( vme->shares ) > 0 ){
+			VectorIterator i;
+
+			vv_foreach( vector<Object *>, i, vme->value ){
+				*i = ob_clone( *i );
+			}
+		}
+		else{
+			delete vme->shares;
+		}
+		vme->shares = NULL;
+	}
+}
+
 size_t vector_get_size( Object *me ){
 	return ob_vector_ucast(me)->items;
 }
@@ -273,6 +311,8 @@ Object *vector_add( Object *me, Object *op ){
 Object *vector_sub( Object *me, Object *op ){
 	Object *clone = ob_clone(me);
 
+	vector_unshare(clone);
+
 	if( ob_is_vector(op) ){
 		Vector *vclone = ob_vector_ucast(clone),
 			   *vop    = ob_vector_ucast(op);
@@ -335,8 +375,10 @@ Object *vector_inplace_add( Object *me, Object *op ){
 }
 
 Object *vector_inplace_sub( Object *me, Object *op ){
+	vector_unshare(me);
+
 	if( ob_is_vector(op) ){
-		Vector *vme = ob_vector_ucast(vme),
+		Vector *vme = ob_vector_ucast(me),
 			   *vop = ob_vector_ucast(op);
 		size_t i, sz_op( vop->items );
 		VectorIterator vi( vme->value.begin() );
@@ -388,6 +430,8 @@ Object *vector_cl_push( Object *me, Object *o ){
 }
 
 Object *vector_cl_push_reference( Object *me, Object *o ){
+	vector_unshare(me);
+
     ob_vector_ucast(me)->value.push_back( o );
     ob_vector_ucast(me)->items++;
 
@@ -400,6 +444,8 @@ Object *vector_cl_pop( Object *me ){
     	return vm_raise_exception( "could not pop an element from an empty array" );
     }
 
+    vector_unshare(me);
+
     Object *last_item = ob_vector_ucast(me)->value[last_idx];
     ob_vector_ucast(me)->value.pop_back();
     ob_vector_ucast(me)->items--;
@@ -414,6 +460,8 @@ Object *vector_cl_remove( Object *me, Object *i ){
     	return vm_raise_exception( "index out of bounds" );
     }
 
+    vector_unshare(me);
+
     Object *item = ob_vector_ucast(me)->value[idx];
     ob_vector_ucast(me)->value.erase( ob_vector_ucast(me)->value.begin() + idx );
     ob_vector_ucast(me)->items--;
@@ -442,6 +490,8 @@ Object *vector_cl_set_reference( Object *me, Object *i, Object *v ){
     	return vm_raise_exception( "index out of bounds" );
     }
 
+    vector_unshare(me);
+
     Object *old = ob_vector_ucast(me)->value[idx];
 
     ob_free(old);
@@ -451,6 +501,25 @@ Object *vector_cl_set_reference( Object *me, Object *i, Object *v ){
     return me;
 }
 
+/** iterator protocol **/
+bool vector_iter_next( Object *me, ob_iterator_t *it, Object **key, Object **value ){
+	/*
+	 * Items are read directly, without the cursor Integer and the
+	 * bound check of vector_cl_at, the size is checked at each step
+	 * because the loop body could change it.
+	 */
+	if( it->index >= ob_vector_ucast(me)->items ){
+		return false;
+	}
+
+	if( key ){
+		*key = (Object *)gc_new_integer( it->index );
+	}
+	*value = ob_vector_ucast(me)->value[it->index++];
+
+	return true;
+}
+
 Object *vector_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id, char *method_id, Node *argv ){
 	ob_type_builtin_method_t *method = NULL;
 
@@ -458,7 +527,6 @@ Object *vector_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id,
 		hyb_error( H_ET_SYNTAX, "Vector type does not have a '%s' method", method_id );
 	}
 
-	ll_item_t *iitem;
 	Object  *value,
 			*result;
 	vframe_t stack;
@@ -473,8 +541,8 @@ Object *vector_call_method( vm_t *vm, vframe_t *frame, Object *me, char *me_id,
 	/*
 	 * Evaluate each object and insert it into the stack
 	 */
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, frame, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, frame, argv->child(i) );
 
 		if( frame->state.is(Exception) ){
 			vm_pop_frame( vm );
@@ -526,6 +594,7 @@ IMPLEMENT_TYPE(Vector) {
     vector_traverse, // traverse
 	vector_clone, // clone
 	vector_free, // free
+	vector_unshare, // unshare
 	vector_get_size, // get_size
 	0, // serialize
 	0, // deserialize
@@ -604,6 +673,10 @@ IMPLEMENT_TYPE(Vector) {
     0, // set_attribute_reference
     0, // define_method
     0, // get_method
-    vector_call_method  // call_method
+    vector_call_method, // call_method
+
+    /** iterator protocol **/
+    0, // iter_begin
+    vector_iter_next  // iter_next
 };
 
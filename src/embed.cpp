@@ -0,0 +1,321 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "hybris.h"
+#include "embed.h"
+
+extern char **environ;
+
+struct _hyb_vm {
+	vm_t  *vm;
+	/* vm_init keeps references to them */
+	int	   argc;
+	char **argv;
+	/* last unhandled exception message */
+	string error;
+};
+
+struct _hyb_function {
+	hyb_vm_t	  *vm;
+	/* either a user defined function or a module one */
+	FunctionNode  *function;
+	vm_function_t *native;
+	/* arguments of the next call */
+	vmem_t		   args;
+	/* value returned by the last call */
+	Object		  *result;
+};
+
+/*
+ * Values handed to the host (pushed arguments and call results) are kept
+ * among the temporary roots of the main frame, so the gc does not free them
+ * while they are not referenced by any frame.
+ */
+static void hyb_pin( vm_t *vm, Object *o ){
+	vm->vmem.push_tmp(o);
+}
+
+static void hyb_unpin( vm_t *vm, Object *o ){
+	vector<Object *>& roots = vm->vmem.roots;
+	size_t 			  i;
+
+	for( i = roots.size(); i > 0; --i ){
+		if( roots[i - 1] == o ){
+			roots.erase( roots.begin() + (i - 1) );
+			return;
+		}
+	}
+}
+/*
+ * Move an unhandled exception of the main frame, if any, to the error
+ * message of the vm, return -1 if there was one.
+ */
+static int hyb_check_exception( hyb_vm_t *hvm ){
+	vm_t   *vm = hvm->vm;
+	Object *e;
+
+	if( vm->vmem.state.is(Exception) == false ){
+		hvm->error.clear();
+		return 0;
+	}
+
+	e = vm->vmem.state.e_value;
+	if( e && e->type->svalue ){
+		hvm->error = ob_svalue(e);
+	}
+	else{
+		hvm->error = string("Unhandled '") + (e ? ob_typename(e) : "void") + "' exception";
+	}
+
+	vm->vmem.state.reset();
+
+	return -1;
+}
+
+hyb_vm_t *hyb_vm_create( int argc, char *argv[], char *envp[] ){
+	static char *no_argv[] = { (char *)"hybris", NULL };
+	hyb_vm_t 	*hvm 	   = new hyb_vm_t;
+
+	if( argc < 1 || argv == NULL ){
+		argc = 1;
+		argv = no_argv;
+	}
+
+	hvm->vm   = vm_create();
+	hvm->argc = argc;
+	hvm->argv = argv;
+
+	vm_init( hvm->vm, 1, &hvm->argc, &hvm->argv, (envp ? envp : environ) );
+
+	vm_set_state( hvm->vm, vmExecuting );
+
+	return hvm;
+}
+
+void hyb_vm_destroy( hyb_vm_t *hvm ){
+	vm_release( hvm->vm );
+	vm_free( hvm->vm );
+
+	delete hvm;
+}
+
+int hyb_vm_load( hyb_vm_t *hvm, const char *filename ){
+	vm_set_current( hvm->vm );
+
+	if( hyb_file_exists( (char *)filename ) == 0 ){
+		hvm->error = string("'") + filename + "' no such file or directory";
+		return -1;
+	}
+
+	hyb_parse_file( hvm->vm, filename );
+
+	return hyb_check_exception( hvm );
+}
+
+int hyb_vm_eval( hyb_vm_t *hvm, const char *source ){
+	vm_set_current( hvm->vm );
+
+	hyb_parse_string( hvm->vm, source );
+
+	return hyb_check_exception( hvm );
+}
+
+const char *hyb_vm_error( hyb_vm_t *hvm ){
+	return (hvm->error.empty() ? NULL : hvm->error.c_str());
+}
+
+hyb_function_t *hyb_function_get( hyb_vm_t *hvm, const char *name ){
+	vm_t 		   *vm 		 = hvm->vm;
+	Node 		   *function = H_UNDEFINED;
+	vm_function_t  *native   = H_UNDEFINED;
+	hyb_function_t *fn;
+
+	vm_set_current( vm );
+
+	if( (function = vm->vcode.get( (char *)name )) == H_UNDEFINED &&
+		(native = vm_get_function( vm, (char *)name )) == H_UNDEFINED ){
+		return NULL;
+	}
+
+	fn = new hyb_function_t;
+
+	fn->vm		   = hvm;
+	fn->function   = (FunctionNode *)function;
+	fn->native	   = native;
+	fn->result	   = H_UNDEFINED;
+	/*
+	 * Copy the name, the host may free it once we return.
+	 */
+	fn->args.owner = string(name);
+
+	return fn;
+}
+
+void hyb_function_free( hyb_function_t *fn ){
+	vm_t  *vm = fn->vm->vm;
+	size_t i;
+
+	for( i = fn->args.argc(); i > 0; --i ){
+		hyb_unpin( vm, fn->args.argv(i - 1) );
+	}
+	if( fn->result ){
+		hyb_unpin( vm, fn->result );
+	}
+
+	delete fn;
+}
+
+INLINE void hyb_push( hyb_function_t *fn, Object *value ){
+	hyb_pin( fn->vm->vm, value );
+
+	fn->args.push( value );
+}
+
+void hyb_push_boolean( hyb_function_t *fn, int value ){
+	vm_set_current( fn->vm->vm );
+
+	hyb_push( fn, (Object *)gc_new_boolean( value != 0 ) );
+}
+
+void hyb_push_integer( hyb_function_t *fn, long value ){
+	vm_set_current( fn->vm->vm );
+
+	hyb_push( fn, (Object *)gc_new_integer(value) );
+}
+
+void hyb_push_float( hyb_function_t *fn, double value ){
+	vm_set_current( fn->vm->vm );
+
+	hyb_push( fn, (Object *)gc_new_float(value) );
+}
+
+void hyb_push_char( hyb_function_t *fn, char value ){
+	vm_set_current( fn->vm->vm );
+
+	hyb_push( fn, (Object *)gc_new_char(value) );
+}
+
+void hyb_push_string( hyb_function_t *fn, const char *value ){
+	vm_set_current( fn->vm->vm );
+
+	hyb_push( fn, (Object *)gc_new_string(value) );
+}
+
+void hyb_push_value( hyb_function_t *fn, hyb_value_t *value ){
+	hyb_push( fn, value );
+}
+
+hyb_value_t *hyb_function_call( hyb_function_t *fn ){
+	hyb_vm_t *hvm	 = fn->vm;
+	vm_t 	 *vm 	 = hvm->vm;
+	Object   *result = H_UNDEFINED;
+	size_t	  i, argc( fn->args.argc() );
+	int		  f_argc;
+
+	vm_set_current( vm );
+	/*
+	 * The previous result is not referenced by the host anymore.
+	 */
+	if( fn->result ){
+		hyb_unpin( vm, fn->result );
+		fn->result = H_UNDEFINED;
+	}
+
+	if( fn->native ){
+		/*
+		 * Module functions rely on the same arguments checks of the
+		 * calls made by scripts (see vm_prepare_stack), but errors are
+		 * reported to the host instead of terminating the process.
+		 */
+		if( vm_check_argc( fn->native, (int)argc, f_argc, hvm->error ) ){
+			for( i = 0; i < argc && vm_check_argv( fn->native, f_argc, (int)i, fn->args.argv(i), hvm->error ); ++i );
+
+			if( i == argc && (result = fn->native->function( vm, &fn->args )) == H_UNDEFINED ){
+				result = H_VOID_VALUE;
+			}
+		}
+	}
+	else if( argc < fn->function->params.size() || (argc > fn->function->params.size() && !fn->function->value.vargs) ){
+		char message[0xFF] = {0};
+
+		snprintf( message, sizeof(message), "function '%s' requires %s%d parameters (called with %d)",
+				  fn->function->value.identifier.c_str(),
+				  (fn->function->value.vargs ? "at least " : ""),
+				  (int)fn->function->params.size(),
+				  (int)argc );
+
+		hvm->error = message;
+	}
+	else{
+		result = vm_exec_function( vm, &vm->vmem, fn->function, &fn->args );
+	}
+
+	for( i = argc; i > 0; --i ){
+		hyb_unpin( vm, fn->args.argv(i - 1) );
+	}
+	fn->args.release();
+
+	if( result == H_UNDEFINED || hyb_check_exception( hvm ) != 0 ){
+		return NULL;
+	}
+
+	fn->result = result;
+
+	hyb_pin( vm, result );
+	/*
+	 * Calls made by the host are not nested in any statement, so
+	 * this is the only chance to collect their garbage.
+	 */
+	gc_collect( vm );
+
+	return result;
+}
+
+int hyb_value_type( hyb_value_t *value ){
+	return value->type->code;
+}
+
+int hyb_value_boolean( hyb_value_t *value ){
+	return ob_lvalue(value);
+}
+
+long hyb_value_integer( hyb_value_t *value ){
+	return ob_ivalue(value);
+}
+
+double hyb_value_float( hyb_value_t *value ){
+	return ob_fvalue(value);
+}
+
+const char *hyb_value_string( hyb_value_t *value ){
+	return (ob_is_string(value) ? ob_lpcstr_val(value) : NULL);
+}
+
+size_t hyb_value_size( hyb_value_t *value ){
+	return ob_get_size(value);
+}
+
+hyb_value_t *hyb_value_at( hyb_value_t *value, size_t index ){
+	Integer i( (long)index );
+
+	if( index >= ob_get_size(value) ){
+		return NULL;
+	}
+
+	return ob_cl_at( value, (Object *)&i );
+}
@@ -0,0 +1,615 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "hybris.h"
+#include "parser.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+
+/*
+ * FastCGI 1.0 records, roles and status codes.
+ */
+#define FCGI_VERSION_1		   1
+#define FCGI_HEADER_LEN		   8
+#define FCGI_MAX_CONTENT	   65535
+
+#define FCGI_BEGIN_REQUEST	   1
+#define FCGI_ABORT_REQUEST	   2
+#define FCGI_END_REQUEST	   3
+#define FCGI_PARAMS			   4
+#define FCGI_STDIN			   5
+#define FCGI_STDOUT			   6
+#define FCGI_STDERR			   7
+#define FCGI_GET_VALUES		   9
+#define FCGI_GET_VALUES_RESULT 10
+#define FCGI_UNKNOWN_TYPE	   11
+
+#define FCGI_RESPONDER		   1
+#define FCGI_KEEP_CONN		   1
+
+#define FCGI_REQUEST_COMPLETE  0
+#define FCGI_CANT_MPX_CONN	   1
+#define FCGI_UNKNOWN_ROLE	   3
+
+/*
+ * The request being received on a connection, requests are served one
+ * at a time, so a connection can't multiplex them.
+ */
+typedef struct _fcgi_request {
+	int	   id;
+	bool   keep_conn;
+	/* encoded name-value pairs */
+	string params;
+	string input;
+}
+fcgi_request_t;
+
+static bool fcgi_read( int fd, unsigned char *buffer, size_t size ){
+	ssize_t n;
+
+	while( size > 0 ){
+		if( (n = read( fd, buffer, size )) <= 0 ){
+			if( n < 0 && errno == EINTR ){
+				continue;
+			}
+			return false;
+		}
+		buffer += n;
+		size   -= n;
+	}
+
+	return true;
+}
+
+static bool fcgi_write( int fd, const unsigned char *buffer, size_t size ){
+	ssize_t n;
+
+	while( size > 0 ){
+		if( (n = write( fd, buffer, size )) <= 0 ){
+			if( n < 0 && errno == EINTR ){
+				continue;
+			}
+			return false;
+		}
+		buffer += n;
+		size   -= n;
+	}
+
+	return true;
+}
+
+static bool fcgi_record( int fd, int type, int id, const unsigned char *data, size_t size ){
+	unsigned char header[FCGI_HEADER_LEN] = { FCGI_VERSION_1,
+											  (unsigned char)type,
+											  (unsigned char)(id >> 8),
+											  (unsigned char)(id & 0xFF),
+											  (unsigned char)(size >> 8),
+											  (unsigned char)(size & 0xFF),
+											  0,
+											  0 };
+
+	return fcgi_write( fd, header, FCGI_HEADER_LEN ) && fcgi_write( fd, data, size );
+}
+/*
+ * Send 'data' as a stream of records, terminated by an empty one.
+ */
+static bool fcgi_stream( int fd, int type, int id, string& data ){
+	const unsigned char *ptr  = (const unsigned char *)data.data();
+	size_t				 left = data.size(),
+						 size;
+
+	while( left > 0 ){
+		size = ( left > FCGI_MAX_CONTENT ? FCGI_MAX_CONTENT : left );
+		if( fcgi_record( fd, type, id, ptr, size ) == false ){
+			return false;
+		}
+		ptr  += size;
+		left -= size;
+	}
+
+	return fcgi_record( fd, type, id, NULL, 0 );
+}
+
+static bool fcgi_end_request( int fd, int id, int status ){
+	unsigned char body[8] = { 0, 0, 0, 0, (unsigned char)status, 0, 0, 0 };
+
+	return fcgi_record( fd, FCGI_END_REQUEST, id, body, sizeof(body) );
+}
+
+INLINE void fcgi_put_pair( string& pairs, const char *name, const char *value ){
+	pairs += (char)strlen(name);
+	pairs += (char)strlen(value);
+	pairs += name;
+	pairs += value;
+}
+
+INLINE bool fcgi_get_length( string& pairs, size_t& i, size_t& length ){
+	const unsigned char *p = (const unsigned char *)pairs.data();
+
+	if( i < pairs.size() && (p[i] & 0x80) == 0 ){
+		length = p[i++];
+		return true;
+	}
+	else if( i + 4 <= pairs.size() ){
+		length = ((p[i] & 0x7F) << 24) | (p[i + 1] << 16) | (p[i + 2] << 8) | p[i + 3];
+		i 	  += 4;
+		return true;
+	}
+
+	return false;
+}
+/*
+ * Decode the request parameters as "NAME=VALUE" strings.
+ */
+static void fcgi_get_params( string& pairs, vector<string>& env ){
+	size_t i = 0,
+		   nlength,
+		   vlength;
+
+	while( fcgi_get_length( pairs, i, nlength ) && fcgi_get_length( pairs, i, vlength ) && i + nlength + vlength <= pairs.size() ){
+		env.push_back( pairs.substr( i, nlength ) + "=" + pairs.substr( i + nlength, vlength ) );
+		i += nlength + vlength;
+	}
+}
+
+static void fcgi_read_file( FILE *fp, string& data ){
+	char   buffer[0xFFFF];
+	size_t n;
+
+	fflush(fp);
+	rewind(fp);
+	data.clear();
+	while( (n = fread( buffer, 1, sizeof(buffer), fp )) > 0 ){
+		data.append( buffer, n );
+	}
+}
+/*
+ * Execute the top level statements of the script, if 'declarations'
+ * is true only function, structure and class declarations are executed,
+ * otherwise everything but them, since they're resident.
+ */
+static void fcgi_exec( vm_t *vm, Node *node, bool declarations ){
+	if( node == NULL || vm->vmem.state.is(Exception) || vm->vmem.state.is(Return) ){
+		return;
+	}
+	else if( node->type == H_NT_EXPRESSION && node->opcode == T_EOSTMT ){
+		fcgi_exec( vm, node->child(0), declarations );
+		fcgi_exec( vm, node->child(1), declarations );
+	}
+	else if( node->type == H_NT_FUNCTION || node->type == H_NT_STRUCT || node->type == H_NT_CLASS ){
+		if( declarations ){
+			vm_exec( vm, &vm->vmem, node );
+		}
+	}
+	else if( declarations == false ){
+		vm_exec( vm, &vm->vmem, node );
+	}
+}
+/*
+ * Execute the script for 'request', with its parameters as environment
+ * and its input as stdin, collecting stdout and stderr.
+ */
+static void fcgi_run( vm_t *vm, vector<Node *>& roots, fcgi_request_t *request, string& out, string& err ){
+	vector<string> env;
+	vector<char *> envp;
+	char 		 **prev_env = vm->env;
+	FILE		  *fin  = tmpfile(),
+				  *fout = tmpfile(),
+				  *ferr = tmpfile();
+	int			   saved[3],
+				   i;
+
+	if( fin == NULL || fout == NULL || ferr == NULL ){
+		hyb_error( H_ET_GENERIC, "could not create FastCGI request buffers" );
+	}
+
+	fcgi_get_params( request->params, env );
+	for( i = 0; i < env.size(); ++i ){
+		envp.push_back( (char *)env[i].c_str() );
+	}
+	envp.push_back(NULL);
+
+	fwrite( request->input.data(), 1, request->input.size(), fin );
+	fflush(fin);
+	rewind(fin);
+
+	fflush(stdout);
+	fflush(stderr);
+	for( i = 0; i < 3; ++i ){
+		saved[i] = dup(i);
+	}
+	dup2( fileno(fin),  STDIN_FILENO );
+	dup2( fileno(fout), STDOUT_FILENO );
+	dup2( fileno(ferr), STDERR_FILENO );
+	clearerr(stdin);
+
+	vm->env = &envp[0];
+
+	for( i = 0; i < roots.size(); ++i ){
+		fcgi_exec( vm, roots[i], false );
+	}
+
+	if( vm->vmem.state.is(Exception) ){
+		if( vm->vmem.state.e_value->type->svalue ){
+			fprintf( stderr, "ERROR : Unhandled exception : %s\n", ob_svalue(vm->vmem.state.e_value).c_str() );
+		}
+		else{
+			fprintf( stderr, "ERROR : Unhandled '%s' exception .\n", ob_typename(vm->vmem.state.e_value) );
+		}
+	}
+	/*
+	 * Every request starts with an empty global frame.
+	 */
+	vm->vmem.release();
+	vm->vmem.state.reset();
+	vm->env = prev_env;
+
+	fflush(stdout);
+	fflush(stderr);
+	for( i = 0; i < 3; ++i ){
+		dup2( saved[i], i );
+		close( saved[i] );
+	}
+
+	fcgi_read_file( fout, out );
+	fcgi_read_file( ferr, err );
+
+	fclose(fin);
+	fclose(fout);
+	fclose(ferr);
+
+	gc_collect(vm);
+}
+/*
+ * Serve the requests of a connection until it's closed, or until a
+ * request without the keep connection flag is completed.
+ */
+static void fcgi_serve( vm_t *vm, vector<Node *>& roots, int fd ){
+	unsigned char  header[FCGI_HEADER_LEN],
+				   content[FCGI_MAX_CONTENT + 0xFF];
+	fcgi_request_t request;
+	int			   type,
+				   id;
+	size_t		   length;
+	string		   out,
+				   err,
+				   values;
+
+	request.id = 0;
+
+	while( fcgi_read( fd, header, FCGI_HEADER_LEN ) ){
+		type   = header[1];
+		id	   = (header[2] << 8) | header[3];
+		length = (header[4] << 8) | header[5];
+
+		if( header[0] != FCGI_VERSION_1 || fcgi_read( fd, content, length + header[6] ) == false ){
+			return;
+		}
+
+		switch( type ){
+			case FCGI_BEGIN_REQUEST :
+				if( request.id != 0 ){
+					fcgi_end_request( fd, id, FCGI_CANT_MPX_CONN );
+				}
+				else if( ((content[0] << 8) | content[1]) != FCGI_RESPONDER ){
+					fcgi_end_request( fd, id, FCGI_UNKNOWN_ROLE );
+				}
+				else{
+					request.id		  = id;
+					request.keep_conn = (content[2] & FCGI_KEEP_CONN);
+					request.params.clear();
+					request.input.clear();
+				}
+			break;
+
+			case FCGI_ABORT_REQUEST :
+				if( id == request.id ){
+					request.id = 0;
+					if( fcgi_end_request( fd, id, FCGI_REQUEST_COMPLETE ) == false || request.keep_conn == false ){
+						return;
+					}
+				}
+			break;
+
+			case FCGI_PARAMS :
+				if( id == request.id ){
+					request.params.append( (char *)content, length );
+				}
+			break;
+
+			case FCGI_STDIN :
+				if( id == request.id && length > 0 ){
+					request.input.append( (char *)content, length );
+				}
+				/*
+				 * An empty record ends the input, the request can be executed.
+				 */
+				else if( id == request.id ){
+					fcgi_run( vm, roots, &request, out, err );
+
+					request.id = 0;
+					if( fcgi_stream( fd, FCGI_STDOUT, id, out ) == false ||
+						( err.size() && fcgi_stream( fd, FCGI_STDERR, id, err ) == false ) ||
+						fcgi_end_request( fd, id, FCGI_REQUEST_COMPLETE ) == false ||
+						request.keep_conn == false ){
+						return;
+					}
+				}
+			break;
+
+			case FCGI_GET_VALUES :
+				values.clear();
+				fcgi_put_pair( values, "FCGI_MAX_CONNS", "1" );
+				fcgi_put_pair( values, "FCGI_MAX_REQS", "1" );
+				fcgi_put_pair( values, "FCGI_MPXS_CONNS", "0" );
+
+				fcgi_record( fd, FCGI_GET_VALUES_RESULT, 0, (unsigned char *)values.data(), values.size() );
+			break;
+
+			default :
+				if( id == 0 ){
+					unsigned char body[8] = { (unsigned char)type, 0, 0, 0, 0, 0, 0, 0 };
+
+					fcgi_record( fd, FCGI_UNKNOWN_TYPE, 0, body, sizeof(body) );
+				}
+		}
+	}
+}
+
+/*
+ * Accept and serve connections until the socket is closed.
+ */
+static void fcgi_accept( vm_t *vm, vector<Node *>& roots, int server ){
+	int client;
+
+	for(;;){
+		if( (client = accept( server, NULL, NULL )) < 0 ){
+			if( errno == EINTR ){
+				continue;
+			}
+			break;
+		}
+
+		fcgi_serve( vm, roots, client );
+
+		close(client);
+	}
+}
+
+static volatile sig_atomic_t __fcgi_stop = 0;
+
+static void fcgi_stop_handler( int signo ){
+	__fcgi_stop = 1;
+}
+/*
+ * SIGCHLD and SIGALRM only have to interrupt sigsuspend.
+ */
+static void fcgi_wake_handler( int signo ){
+
+}
+
+static void fcgi_signal( int signo, void (*handler)(int) ){
+	struct sigaction action;
+
+	memset( &action, 0x00, sizeof(action) );
+	/*
+	 * No SA_RESTART, signals must interrupt the supervisor.
+	 */
+	action.sa_handler = handler;
+	action.sa_flags	  = (signo == SIGCHLD ? SA_NOCLDSTOP : 0);
+	sigemptyset( &action.sa_mask );
+
+	sigaction( signo, &action, NULL );
+}
+/*
+ * Fork a worker serving the shared socket, the parsed tree and every
+ * page of the parent are shared copy on write, 'mask' is the signal
+ * mask to restore in the worker.
+ */
+static pid_t fcgi_spawn( vm_t *vm, vector<Node *>& roots, int server, sigset_t *mask ){
+	pid_t pid = fork();
+
+	if( pid == 0 ){
+		signal( SIGTERM, SIG_DFL );
+		signal( SIGINT,  SIG_DFL );
+		signal( SIGCHLD, SIG_DFL );
+		signal( SIGALRM, SIG_DFL );
+
+		sigprocmask( SIG_SETMASK, mask, NULL );
+
+		fcgi_accept( vm, roots, server );
+
+		_exit(0);
+	}
+	else if( pid < 0 ){
+		hyb_error( H_ET_WARNING, "could not fork a FastCGI worker, retrying" );
+	}
+
+	return pid;
+}
+/*
+ * Start 'n' workers and restart the ones that exit (or could not be
+ * forked) until we're asked to stop, then stop them all.
+ *
+ * The signals we wait for are blocked while the supervisor is busy, and
+ * only delivered inside sigsuspend, so a SIGTERM can't get lost between
+ * the check of __fcgi_stop and the wait.
+ */
+static void fcgi_supervise( vm_t *vm, vector<Node *>& roots, int server, int n ){
+	vector<pid_t>  workers( n, 0 );
+	vector<time_t> started( n, 0 );
+	sigset_t	   blocked,
+				   prev;
+	pid_t		   pid;
+	int			   status,
+				   missing,
+				   i;
+
+	fcgi_signal( SIGTERM, fcgi_stop_handler );
+	fcgi_signal( SIGINT,  fcgi_stop_handler );
+	fcgi_signal( SIGCHLD, fcgi_wake_handler );
+	fcgi_signal( SIGALRM, fcgi_wake_handler );
+
+	sigemptyset( &blocked );
+	sigaddset( &blocked, SIGTERM );
+	sigaddset( &blocked, SIGINT );
+	sigaddset( &blocked, SIGCHLD );
+	sigaddset( &blocked, SIGALRM );
+	sigprocmask( SIG_BLOCK, &blocked, &prev );
+
+	while( __fcgi_stop == 0 ){
+		/*
+		 * Reap the workers that exited.
+		 */
+		while( (pid = waitpid( -1, &status, WNOHANG )) > 0 ){
+			for( i = 0; i < n && workers[i] != pid; ++i );
+
+			if( i == n ){
+				continue;
+			}
+
+			if( WIFSIGNALED(status) ){
+				hyb_error( H_ET_WARNING, "FastCGI worker %d killed by signal %d, restarting it", pid, WTERMSIG(status) );
+			}
+			else{
+				hyb_error( H_ET_WARNING, "FastCGI worker %d exited with status %d, restarting it", pid, WEXITSTATUS(status) );
+			}
+
+			workers[i] = 0;
+		}
+		/*
+		 * Start the missing ones, but don't fork in a loop if workers
+		 * die as soon as they start, nor if fork fails, try again in
+		 * a second.
+		 */
+		for( i = 0, missing = 0; i < n; ++i ){
+			if( workers[i] > 0 ){
+				continue;
+			}
+			else if( time(NULL) - started[i] < 1 ){
+				++missing;
+			}
+			else{
+				workers[i] = fcgi_spawn( vm, roots, server, &prev );
+				started[i] = time(NULL);
+				if( workers[i] <= 0 ){
+					++missing;
+				}
+			}
+		}
+
+		if( missing ){
+			alarm(1);
+		}
+		/*
+		 * Wait for a worker to exit, the retry timer or a stop request.
+		 */
+		if( __fcgi_stop == 0 ){
+			sigsuspend( &prev );
+		}
+	}
+
+	alarm(0);
+
+	for( i = 0; i < n; ++i ){
+		if( workers[i] > 0 ){
+			kill( workers[i], SIGTERM );
+		}
+	}
+	for( i = 0; i < n; ++i ){
+		if( workers[i] > 0 ){
+			waitpid( workers[i], &status, 0 );
+		}
+	}
+
+	sigprocmask( SIG_SETMASK, &prev, NULL );
+}
+
+void hyb_fcgi_main( vm_t *vm, const char *socket_path ){
+	vector<Node *>		 roots;
+	vector<node_arena_t *> arenas;
+	node_ast_t			 ast;
+	struct sockaddr_un	 address;
+	FILE				*fp;
+	int					 server;
+	size_t				 i;
+
+	/*
+	 * Errors are sent to the web server, without colors.
+	 */
+	vm->args.cgi_mode = true;
+	/*
+	 * Parse the script once, modules are imported while parsing.
+	 */
+	fp = vm_fopen( vm );
+
+	vm_set_state( vm, vmParsing );
+
+	while( !feof(fp) ){
+		hyb_parse_tree( vm, fp, &ast );
+
+		if( ast.arena != NULL ){
+			roots.push_back( ast.root );
+			arenas.push_back( ast.arena );
+		}
+	}
+
+	vm_fclose( vm );
+
+	vm_set_state( vm, vmExecuting );
+	/*
+	 * Functions and types are defined once for every request.
+	 */
+	for( i = 0; i < roots.size(); ++i ){
+		fcgi_exec( vm, roots[i], true );
+	}
+
+	memset( &address, 0x00, sizeof(address) );
+	address.sun_family = AF_UNIX;
+	strncpy( address.sun_path, socket_path, sizeof(address.sun_path) - 1 );
+
+	unlink( socket_path );
+	if( (server = socket( AF_UNIX, SOCK_STREAM, 0 )) < 0 ||
+		bind( server, (struct sockaddr *)&address, sizeof(address) ) != 0 ||
+		listen( server, SOMAXCONN ) != 0 ){
+		hyb_error( H_ET_GENERIC, "could not listen on FastCGI socket '%s'", socket_path );
+	}
+	/*
+	 * A web server closing the connection must not kill us.
+	 */
+	signal( SIGPIPE, SIG_IGN );
+
+	if( vm->args.prefork > 0 ){
+		fcgi_supervise( vm, roots, server, vm->args.prefork );
+	}
+	else{
+		fcgi_accept( vm, roots, server );
+	}
+
+	close(server);
+	unlink( socket_path );
+
+	for( i = 0; i < roots.size(); ++i ){
+		delete roots[i];
+		node_arena_release( arenas[i] );
+	}
+}
@@ -26,54 +26,53 @@
 #include <string.h>
 #include <string>
 #include <vector>
+#include <set>
 #include <pcre.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 
 using std::vector;
 using std::string;
+using std::set;
 
 typedef vector<string> matches_t;
 
 #define IS_WHITESPACE(c) strchr( " \r\n\t", (c) )
 
-#define LEX_NEXT()	   yyinput()
+/*
+ * The scanner is reentrant, helpers reading input need its handle, while
+ * the vm whose source is being parsed is kept in its extra data (see
+ * node_parser_t), so every thread parses with its own scanner.
+ */
+#define LEX_NEXT()	   yyinput(yyscanner)
 #define LEX_FETCH(c)   (c = LEX_NEXT())
-#define LEX_UNFETCH(c) unput(c)
+#define LEX_UNFETCH(c) yyunput( c, yyget_text(yyscanner), yyscanner )
+#define LEX_VM()	   (yyget_extra(yyscanner)->vm)
 
 void             yyerror(char *);
 // check if a give name is a directory or a file
 bool  			 hyb_is_dir( const char *filename );
 // handle one line comments
-void             hyb_lex_skip_comment();
+void             hyb_lex_skip_comment( yyscan_t yyscanner );
 // handle multi line comments
-void             hyb_lex_skip_line();
+void             hyb_lex_skip_line( yyscan_t yyscanner );
 // handle string escaping
 char 			*hyb_lex_parse_string( char *str );
 // handle string constants
-char *           hyb_lex_string( char delimiter, char *buffer );
+char *           hyb_lex_string( char delimiter, char *buffer, yyscan_t yyscanner );
 // handle char constants
-char             hyb_lex_char( char delimiter );
+char             hyb_lex_char( char delimiter, yyscan_t yyscanner );
 // extract tokens from a string give a regular expression
-matches_t 		 hyb_pcre_matches( string pattern, char *subject );
+matches_t 		 hyb_pcre_matches( vm_t *vm, string pattern, char *subject );
 // handle function prototypes declarations
-function_decl_t *hyb_lex_function( char * text );
+function_decl_t *hyb_lex_function( vm_t *vm, char * text );
 // handle method prototypes declarations
-method_decl_t   *hyb_lex_method( char * text );
+method_decl_t   *hyb_lex_method( vm_t *vm, char * text );
 // handle operator overloading declaration
-method_decl_t   *hyb_lex_operator( char *text );
-/*
- * A stack container for files being parsed.
- */
-vector<string> __hyb_file_stack;
-/*
- * A stack container for correct line numbering upon inclusion.
- */
-vector<int>	   __hyb_line_stack;
-/*
- * Extern VM reference.
- */
-extern vm_t   *__hyb_vm;
+method_decl_t   *hyb_lex_operator( vm_t *vm, char *text );
 
-int yyparse(void);
+int yyparse( yyscan_t scanner );
 
 union hyb_token_value {
 	/* base types */
@@ -111,14 +110,10 @@ typedef struct YYLTYPE
 # define YYLTYPE_IS_TRIVIAL 1
 #endif
 /*
- * We got a pure parser here, so we have to define our
- * yylex prototype with correct yylval and yyloc types.
+ * Make sure every rule yylloc is correctly updated, yylval and yylloc
+ * are the pointers given by the pure parser (see bison-bridge).
  */
-#define YY_DECL int yylex( hyb_token_value* yylval, YYLTYPE *yylloc )
-/*
- * Make sure every rule yylloc is correctly updated.
- */
-#define YY_USER_ACTION yylloc->first_line = vm_get_lineno(__hyb_vm);
+#define YY_USER_ACTION yylloc->first_line = vm_get_lineno(yyextra->vm);
 
 %}
 
@@ -127,6 +122,10 @@ typedef struct YYLTYPE
 %option noyywrap
 %option batch
 %option stack
+%option reentrant
+%option bison-bridge
+%option bison-locations
+%option extra-type="node_parser_t *"
 
 exponent   [eE][-+]?[0-9]+
 spaces     [ \n\t]+
@@ -136,7 +135,7 @@ operators  "[]"|"[]="|"[]<"|".."|"+"|"+="|"-"|"-="|"/"|"/="|"*"|"*="|"%"|"%="|"+
 %%
 
 [ \t]+ ;
-[\n]             { vm_inc_lineno(__hyb_vm); }
+[\n]             { vm_inc_lineno(yyextra->vm); }
 
 include          BEGIN(T_INCLUSION);
 
@@ -153,6 +152,8 @@ include          BEGIN(T_INCLUSION);
 		   lcl_file = file,
 		   ext_file = file + ".hy",
 		   std_file;
+    FILE  *prev_yyin = yyin;
+    char   canonical[PATH_MAX] = {0};
 
     string_replace( file, ".", "/" );
     std_file = INC_PATH + file + ".hy";
@@ -162,13 +163,13 @@ include          BEGIN(T_INCLUSION);
 	 * of the script.
 	 */
     if( !hyb_is_dir(lcl_file.c_str()) && (yyin = fopen( lcl_file.c_str(), "r" )) != NULL ){
-    	__hyb_file_stack.push_back(lcl_file);
+    	yyextra->vm->files.push_back(lcl_file);
     }
     /*
 	 * Secondly, try adding the .hy extension.
 	 */
     else if( !hyb_is_dir(ext_file.c_str()) && (yyin = fopen( ext_file.c_str(), "r" )) != NULL ){
-    	__hyb_file_stack.push_back(ext_file);
+    	yyextra->vm->files.push_back(ext_file);
     }
     /*
 	 * Try to load from default include path.
@@ -181,7 +182,7 @@ include          BEGIN(T_INCLUSION);
 	 * /usr/lib/hybris/include/std/io/network/Socket.hy
 	 */
     else if( !hyb_is_dir(std_file.c_str()) && (yyin = fopen( std_file.c_str(), "r" )) != NULL ){
-    	__hyb_file_stack.push_back(std_file);
+    	yyextra->vm->files.push_back(std_file);
     }
     /*
      * Nothing found :(
@@ -189,38 +190,47 @@ include          BEGIN(T_INCLUSION);
     else {
     	hyb_error( H_ET_GENERIC, "Could not open '%s' for inclusion", yytext );
     }
+    /*
+     * Already included, go on with the current file.
+     */
+    if( realpath( yyextra->vm->files.back().c_str(), canonical ) && yyextra->vm->included.insert(canonical).second == false ){
+    	fclose(yyin);
+    	yyin = prev_yyin;
+    	yyextra->vm->files.pop_back();
+    }
+    else{
+		yyextra->vm->lines.push_back( vm_get_lineno(yyextra->vm) );
 
-    __hyb_line_stack.push_back( vm_get_lineno(__hyb_vm) );
-
-	const char *filename = __hyb_file_stack.back().c_str(),
-			   *sep		 = strrchr( filename, '/' );
-	if( sep ){
-		filename = sep + 1;
-	}
+		const char *filename = yyextra->vm->files.back().c_str(),
+				   *sep		 = strrchr( filename, '/' );
+		if( sep ){
+			filename = sep + 1;
+		}
 
-    vm_set_source( __hyb_vm, filename );
-    vm_set_lineno( __hyb_vm, 1 );
+		vm_set_source( yyextra->vm, filename );
+		vm_set_lineno( yyextra->vm, 1 );
 
-    yypush_buffer_state( yy_create_buffer( yyin, YY_BUF_SIZE ) );
+		yypush_buffer_state( yy_create_buffer( yyin, YY_BUF_SIZE, yyscanner ), yyscanner );
+    }
 
     BEGIN(INITIAL);
 }
 <<EOF>> {
-	if( __hyb_file_stack.size() >= 1 ){
-		__hyb_file_stack.pop_back();
-		if( __hyb_file_stack.size() ){
-			vm_set_source( __hyb_vm, __hyb_file_stack.back() );
+	if( yyextra->vm->files.size() >= 1 ){
+		yyextra->vm->files.pop_back();
+		if( yyextra->vm->files.size() ){
+			vm_set_source( yyextra->vm, yyextra->vm->files.back() );
 		}
 		else{
-			vm_set_source( __hyb_vm, __hyb_vm->args.source );
+			vm_set_source( yyextra->vm, yyextra->vm->args.source );
 		}
 	}
-	if( __hyb_line_stack.size() ){
-		__hyb_line_stack.pop_back();
-		vm_set_lineno( __hyb_vm, __hyb_line_stack.back() );
+	if( yyextra->vm->lines.size() ){
+		yyextra->vm->lines.pop_back();
+		vm_set_lineno( yyextra->vm, yyextra->vm->lines.back() );
 	}
 
-    yypop_buffer_state();
+    yypop_buffer_state( yyscanner );
 
     if( !YY_CURRENT_BUFFER ){
         yyterminate();
@@ -246,12 +256,12 @@ include          BEGIN(T_INCLUSION);
 
     yytext = sptr;
 
-    vm_load_module( __hyb_vm, (char *)module.c_str() );
+    vm_load_module( yyextra->vm, (char *)module.c_str() );
 }
 
-"#"             { hyb_lex_skip_line();    }
-"/*"		    { hyb_lex_skip_comment(); }
-"//"            { hyb_lex_skip_line();    }
+"#"             { hyb_lex_skip_line(yyscanner);    }
+"/*"		    { hyb_lex_skip_comment(yyscanner); }
+"//"            { hyb_lex_skip_line(yyscanner);    }
 
 ";" 		    return T_EOSTMT;
 
@@ -336,23 +346,23 @@ include          BEGIN(T_INCLUSION);
 "return"        return T_RETURN;
 
 "function"[ \n\t]+{identifier}[ \n\t]*"("([ \n\t]*{identifier}[ \n\t]*,?)*([ \n\t]*\.\.\.)?[ \n\t]*")" {
-	yylval->function   = hyb_lex_function(yytext);
+	yylval->function   = hyb_lex_function( yyextra->vm, yytext );
 	return T_FUNCTION_PROTOTYPE;
 }
 
 "method"[ \n\t]+{identifier}[ \n\t]*"("([ \n\t]*{identifier}[ \n\t]*,?)*([ \n\t]*\.\.\.)?[ \n\t]*")" {
-	yylval->method = hyb_lex_method(yytext);
+	yylval->method = hyb_lex_method( yyextra->vm, yytext );
 	return T_METHOD_PROTOTYPE;
 }
 
 "operator"[ \n\t]+{operators}[ \n\t]*"("([ \n\t]*{identifier}[ \n\t]*,?)*")" {
-	yylval->method = hyb_lex_operator(yytext);
+	yylval->method = hyb_lex_operator( yyextra->vm, yytext );
 	return T_METHOD_PROTOTYPE;
 }
 
 "__FILE__" {
-	if( __hyb_file_stack.size() ){
-		strncpy( yylval->string, __hyb_file_stack.back().c_str(), MAX_STRING_SIZE );
+	if( yyextra->vm->files.size() ){
+		strncpy( yylval->string, yyextra->vm->files.back().c_str(), MAX_STRING_SIZE );
 	}
 	else{
 		strncpy( yylval->string,  "<unknown>", MAX_STRING_SIZE );
@@ -361,7 +371,7 @@ include          BEGIN(T_INCLUSION);
 }
 
 "__LINE__" {
-	yylval->integer = vm_get_lineno(__hyb_vm);
+	yylval->integer = vm_get_lineno(yyextra->vm);
 
 	return T_INTEGER;
 }
@@ -370,8 +380,8 @@ include          BEGIN(T_INCLUSION);
 [0-9]+                               { yylval->integer = atol(yytext);             return T_INTEGER; }
 0x[A-Fa-f0-9]+                       { yylval->integer = strtol(yytext,0,16);      return T_INTEGER; }
 ([0-9]+|([0-9]*\.[0-9]+){exponent}?) { yylval->real    = atof(yytext);             return T_REAL; }
-"'"                                  { yylval->byte    = hyb_lex_char('\'');    	return T_CHAR; }
-"\""                                 { hyb_lex_string( '"', yylval->string ); 		return T_STRING; }
+"'"                                  { yylval->byte    = hyb_lex_char( '\'', yyscanner );         return T_CHAR; }
+"\""                                 { hyb_lex_string( '"', yylval->string, yyscanner ); return T_STRING; }
 
 {identifier} {
 	if( strlen(yytext) > MAX_IDENT_SIZE ){
@@ -402,19 +412,19 @@ bool hyb_is_dir( const char *filename ){
 }
 
 
-void hyb_lex_skip_comment(){
+void hyb_lex_skip_comment( yyscan_t yyscanner ){
     char c, c1;
 
 loop:
     while( LEX_FETCH(c) != '*' && c != 0 ){
         if( c == '\n' ){
-        	vm_inc_lineno(__hyb_vm);
+        	vm_inc_lineno(LEX_VM());
         }
     }
 
     if( LEX_FETCH(c1) != '/' && c != 0){
         if( c1 == '\n' ){
-        	vm_inc_lineno(__hyb_vm);
+        	vm_inc_lineno(LEX_VM());
         }
 
         LEX_UNFETCH(c1);
@@ -423,15 +433,15 @@ loop:
     }
 }
 
-void hyb_lex_skip_line(){
+void hyb_lex_skip_line( yyscan_t yyscanner ){
     char c;
 
     while( LEX_FETCH(c) != '\n' && c != EOF );
 
-    vm_inc_lineno(__hyb_vm);
+    vm_inc_lineno(LEX_VM());
 }
 
-char hyb_lex_char( char delimiter ){
+char hyb_lex_char( char delimiter, yyscan_t yyscanner ){
     char ch;
 
     LEX_FETCH(ch);
@@ -563,7 +573,7 @@ char *hyb_lex_parse_string( char *str ){
 	return str;
 }
 
-char *hyb_lex_string( char delimiter, char *buffer ){
+char *hyb_lex_string( char delimiter, char *buffer, yyscan_t yyscanner ){
     char *ptr  = NULL;
     int offset = 0, c, prev = 0x00;
 
@@ -592,7 +602,7 @@ char *hyb_lex_string( char delimiter, char *buffer ){
     return (buffer = hyb_lex_parse_string(buffer));
 }
 
-matches_t hyb_pcre_matches( string pattern, char *subject ){
+matches_t hyb_pcre_matches( vm_t *vm, string pattern, char *subject ){
 	int    		 i, ccount, rc,
 				*offsets, offset = 0,
 				 eoffset;
@@ -600,7 +610,7 @@ matches_t hyb_pcre_matches( string pattern, char *subject ){
 	pcre 		*compiled;
 	matches_t    matches;
 
-	compiled = vm_pcre_compile( __hyb_vm, pattern, PCRE_CASELESS|PCRE_MULTILINE, &error, &eoffset );
+	compiled = vm_pcre_compile( vm, pattern, PCRE_CASELESS|PCRE_MULTILINE, &error, &eoffset );
 	rc 		 = pcre_fullinfo( compiled, 0, PCRE_INFO_CAPTURECOUNT, &ccount );
 
 	offsets = new int[ 3 * (ccount + 1) ];
@@ -619,159 +629,277 @@ matches_t hyb_pcre_matches( string pattern, char *subject ){
 	return matches;
 }
 
-function_decl_t *hyb_lex_function( char * text ){
+function_decl_t *hyb_lex_function( vm_t *vm, char * text ){
     function_decl_t *declaration = new function_decl_t;
     string			 identifier  = "[a-zA-Z_][a-zA-Z0-9_]*",
 					 pattern     = "function[\\s]+("+identifier+")[\\s]*\\(([^\\)]*)\\)";
 	matches_t 		 tokens;
 	int 			 i, argc;
 
-	tokens = hyb_pcre_matches( pattern, text );
+	tokens = hyb_pcre_matches( vm, pattern, text );
 
-	strcpy( declaration->function, tokens[0].c_str() );
+	declaration->function = tokens[0];
 
 	pattern = "(" + identifier + "|\\.\\.\\.)";
 
-	tokens = hyb_pcre_matches( pattern, (char *)tokens[1].c_str() );
+	tokens = hyb_pcre_matches( vm, pattern, (char *)tokens[1].c_str() );
 
-	declaration->argc  = tokens.size();
 	declaration->vargs = false;
-	argc			   = declaration->argc;
+	argc			   = tokens.size();
 	for( i = 0; i < argc; ++i ){
 		if( tokens[i] != "..." ){
-			strcpy( declaration->argv[i], tokens[i].c_str() );
+			declaration->argv.push_back( tokens[i] );
 		}
 		else{
 			declaration->vargs = true;
-			declaration->argc--;
 		}
 	}
+	declaration->argc = declaration->argv.size();
 
 	return declaration;
 }
 
-method_decl_t *hyb_lex_method( char * text ){
+method_decl_t *hyb_lex_method( vm_t *vm, char * text ){
 	method_decl_t   *declaration = new method_decl_t;
 	string			 identifier  = "[a-zA-Z_][a-zA-Z0-9_]*",
 					 pattern     = "method[\\s]+("+identifier+")[\\s]*\\(([^\\)]*)\\)";
 	matches_t 		 tokens;
 	int 			 i, argc;
 
-	tokens = hyb_pcre_matches( pattern, text );
+	tokens = hyb_pcre_matches( vm, pattern, text );
 
-	strcpy( declaration->method, tokens[0].c_str() );
+	declaration->method = tokens[0];
 
 	pattern = "(" + identifier + "|\\.\\.\\.)";
 
-	tokens = hyb_pcre_matches( pattern, (char *)tokens[1].c_str() );
+	tokens = hyb_pcre_matches( vm, pattern, (char *)tokens[1].c_str() );
 
-	declaration->argc  = tokens.size();
 	declaration->vargs = false;
-	argc			   = declaration->argc;
-	for( i = 0; i < declaration->argc; ++i ){
+	argc			   = tokens.size();
+	for( i = 0; i < argc; ++i ){
 		if( tokens[i] != "..." ){
-			strcpy( declaration->argv[i], tokens[i].c_str() );
+			declaration->argv.push_back( tokens[i] );
 		}
 		else{
 			declaration->vargs = true;
-			declaration->argc--;
 		}
 	}
+	declaration->argc = declaration->argv.size();
 
 	return declaration;
 }
 
-method_decl_t *hyb_lex_operator( char * text ){
+method_decl_t *hyb_lex_operator( vm_t *vm, char * text ){
 	method_decl_t   *declaration = new method_decl_t;
 	string			 identifier  = "[a-zA-Z_][a-zA-Z0-9_]*",
 					 operators   = "[\\[\\]=\\<\\.\\+\\-\\/\\*\\%\\^\\~\\&\\|\\>\\!]+",
 					 pattern     = "operator[\\s]+("+operators+")[\\s]*\\(([^\\)]*)\\)";
 	matches_t 		 tokens;
-	int 			 i;
 
-	tokens = hyb_pcre_matches( pattern, text );
+	tokens = hyb_pcre_matches( vm, pattern, text );
 
 	/*
 	 * Mangle operator name.
 	 */
-	strcpy( declaration->method, tokens[0].c_str() );
+	declaration->method = tokens[0];
 
 	pattern = "("+identifier+")";
 
-	tokens = hyb_pcre_matches( pattern, (char *)tokens[1].c_str() );
+	tokens = hyb_pcre_matches( vm, pattern, (char *)tokens[1].c_str() );
 
-	declaration->argc = tokens.size();
-	for( i = 0; i < declaration->argc; ++i ){
-		strcpy( declaration->argv[i], tokens[i].c_str() );
-	}
+	declaration->argv  = tokens;
+	declaration->argc  = tokens.size();
+	declaration->vargs = false;
 
     return declaration;
 }
 
 
-void hyb_parse_string( vm_t *vm, const char *str ){
-	YY_BUFFER_STATE prev, current;
-	int				state;
-	int				lineno;
-	FILE		   *prev_yyin;
-	/*
-	 * Save buffer value, lex state, input file pointer
-	 * and line number.
-	 */
-	prev      = YY_CURRENT_BUFFER_LVALUE;
-	state     = YYSTATE;
-	prev_yyin = yyin;
-	lineno    = vm_get_lineno(vm);
-	/*
-	 * yy_scan_string will call yy_switch_to_buffer with
-	 * the newly created buffer from str.
-	 */
-	yy_scan_string(str);
+/*
+ * Parse the next tree from the scanner input into 'ast', its arena
+ * is NULL if the parser didn't get to the end of the tree, then
+ * destroy the scanner.
+ */
+static void hyb_parse( yyscan_t scanner, node_ast_t *ast ){
+	ast->root  = NULL;
+	ast->arena = NULL;
+
+	yyget_extra(scanner)->ast = ast;
+
+	yyparse( scanner );
+
+	yylex_destroy( scanner );
+}
+/*
+ * Execute a tree just parsed.
+ */
+static void hyb_exec_tree( vm_t *vm, node_ast_t *ast ){
+	int lineno = vm_get_lineno(vm);
+
+	vm_timer( vm, VM_TIMER_START );
+
+	vm_set_state( vm, vmExecuting );
+
+	vm_exec( vm, &vm->vmem, ast->root );
+
+	vm_timer( vm, VM_TIMER_STOP );
+
+	vm_set_lineno( vm, lineno );
+}
+static void hyb_parse_buffer( vm_t *vm, const char *str, node_ast_t *ast ){
+	node_parser_t parser = { vm, NULL };
+	yyscan_t	  scanner;
+	int			  lineno = vm_get_lineno(vm);
 	/*
-	 * Reset lex state to initial.
+	 * Every parse has its own scanner, so there's no buffer
+	 * or lex state of an outer parse to save and restore.
 	 */
-	BEGIN(INITIAL);
+	yylex_init_extra( &parser, &scanner );
+	yy_scan_string( str, scanner );
 
 	vm_set_lineno( vm, 1 );
 	/*
-	 * Parse the str, yyparse will call yylex.
+	 * Parse the str, yyparse will call yylex, and keep the tree
+	 * in 'ast'.
 	 */
-	yyparse();
+	hyb_parse( scanner, ast );
+
+	vm_set_lineno( vm, lineno );
+}
+/*
+ * Parse and execute 'str' without keeping its tree.
+ */
+static void hyb_parse_once( vm_t *vm, const char *str ){
+	node_ast_t ast;
+
+	hyb_parse_buffer( vm, str, &ast );
+
+	if( ast.arena != NULL ){
+		hyb_exec_tree( vm, &ast );
+
+		node_ast_release( &ast );
+	}
+}
+/*
+ * Return the tree cached as 'label' taking a reference to it, so it's
+ * not freed while executing even if another thread replaces it.
+ */
+static node_ast_t *hyb_ast_get( vm_t *vm, vm_ast_cache_t *cache, char *label ){
+	node_ast_t *ast;
+
+	vm_ast_lock( vm );
+	if( (ast = cache->find(label)) != H_UNDEFINED ){
+		ast->refs++;
+	}
+	vm_ast_unlock( vm );
+
+	return ast;
+}
+/*
+ * Drop a reference to a cached tree, freeing it if it was the last one.
+ */
+static void hyb_ast_put( vm_t *vm, node_ast_t *ast ){
+	bool last;
+
+	vm_ast_lock( vm );
+	last = (--ast->refs == 0);
+	vm_ast_unlock( vm );
+
+	if( last ){
+		node_ast_release( ast );
+
+		delete ast;
+	}
+}
+/*
+ * Execute again a tree taken with hyb_ast_get and drop its reference.
+ */
+static void hyb_exec_ast( vm_t *vm, node_ast_t *ast ){
+	int lineno = vm_get_lineno(vm);
+
+	vm_exec( vm, &vm->vmem, ast->root );
+
+	vm_set_lineno( vm, lineno );
+
+	hyb_ast_put( vm, ast );
+}
+/*
+ * Parse and execute 'str' keeping its tree in 'cache' as 'label'.
+ */
+static void hyb_parse_cached( vm_t *vm, vm_ast_cache_t *cache, char *label, const char *str, time_t mtime ){
+	node_ast_t *ast = new node_ast_t,
+			   *old;
+
+	hyb_parse_buffer( vm, str, ast );
+
 	/*
-	 * Get current buffer, and switch to the previous
-	 * one.
+	 * The parser didn't get to the end of the tree.
 	 */
-	current = YY_CURRENT_BUFFER;
-	if( prev ){
-		yy_switch_to_buffer( prev );
+	if( ast->arena == NULL ){
+		delete ast;
+		return;
 	}
+
+	ast->mtime = mtime;
+	ast->refs  = 1;
+
+	hyb_exec_tree( vm, ast );
 	/*
-	 * We don't need this buffer anymore, delete it.
+	 * The reference taken for the execution is now the cache one.
 	 */
-	yy_delete_buffer(current);
+	vm_ast_lock( vm );
+	if( (old = cache->find(label)) != H_UNDEFINED ){
+		cache->replace( label, old, ast );
+	}
+	else{
+		cache->insert( label, ast );
+	}
+	vm_ast_unlock( vm );
 	/*
-	 * Restore lex state, line number and input file pointer.
+	 * Stale tree of a modified file, or a tree cached by another
+	 * thread in the meanwhile, it could still be executing.
 	 */
-	BEGIN(state);
+	if( old != H_UNDEFINED ){
+		hyb_ast_put( vm, old );
+	}
+}
 
-	vm_set_lineno( vm, lineno );
+void hyb_parse_string( vm_t *vm, const char *str ){
+	node_ast_t *ast;
 
-	yyin = prev_yyin;
+	if( vm->args.ast_cache == false ){
+		return hyb_parse_once( vm, str );
+	}
+
+	if( (ast = hyb_ast_get( vm, &vm->ast_strings, (char *)str )) != H_UNDEFINED ){
+		hyb_exec_ast( vm, ast );
+	}
+	else{
+		hyb_parse_cached( vm, &vm->ast_strings, (char *)str, str, 0 );
+	}
 }
 
 void hyb_parse_file( vm_t *vm, const char *filename ){
-	FILE  *fp = fopen( filename, "rt" );
-	string source, buffer;
-	char   line[1024] = {0};
-
-	if( fp ){
-		source = vm_get_source(vm);
-
-		while( fgets( line, 1024, fp ) != NULL ){
-			buffer += line;
+	FILE  	   *fp;
+	string 		source, buffer;
+	char   		line[1024] = {0},
+				canonical[PATH_MAX] = {0};
+	struct stat st;
+	node_ast_t *ast   = H_UNDEFINED;
+	bool		cache = vm->args.ast_cache && realpath( filename, canonical ) && stat( canonical, &st ) == 0;
+
+	if( cache && (ast = hyb_ast_get( vm, &vm->ast_files, canonical )) != H_UNDEFINED ){
+		/*
+		 * The file was modified since it was parsed.
+		 */
+		if( ast->mtime != st.st_mtime ){
+			hyb_ast_put( vm, ast );
+			ast = H_UNDEFINED;
 		}
+	}
 
-		fclose(fp);
+	if( ast || (fp = fopen( filename, "rt" )) ){
+		source = vm_get_source(vm);
 
 		const char *sep = strrchr( filename, '/' );
 		if( sep ){
@@ -779,9 +907,48 @@ void hyb_parse_file( vm_t *vm, const char *filename ){
 		}
 		vm_set_source( vm, filename );
 
-		hyb_parse_string( vm, buffer.c_str() );
+		if( ast ){
+			hyb_exec_ast( vm, ast );
+		}
+		else{
+			while( fgets( line, 1024, fp ) != NULL ){
+				buffer += line;
+			}
+
+			fclose(fp);
+
+			if( cache ){
+				hyb_parse_cached( vm, &vm->ast_files, canonical, buffer.c_str(), st.st_mtime );
+			}
+			else{
+				hyb_parse_once( vm, buffer.c_str() );
+			}
+		}
 
 		vm_set_source( vm, source );
 	}
 }
 
+void hyb_parse_tree( vm_t *vm, FILE *fp, node_ast_t *ast ){
+	node_parser_t parser = { vm, NULL };
+	yyscan_t	  scanner;
+
+	yylex_init_extra( &parser, &scanner );
+	yyset_in( fp, scanner );
+
+	hyb_parse( scanner, ast );
+}
+
+void hyb_parse_stream( vm_t *vm, FILE *fp ){
+	node_ast_t ast;
+
+	while( !feof(fp) ){
+		hyb_parse_tree( vm, fp, &ast );
+
+		if( ast.arena != NULL ){
+			hyb_exec_tree( vm, &ast );
+
+			node_ast_release( &ast );
+		}
+	}
+}
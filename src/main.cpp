@@ -19,6 +19,13 @@
 #include "hybris.h"
 #include <getopt.h>
 
+#ifdef HYBRIS_STATIC_STDLIB
+/*
+ * Generated by cmake, the table of the modules linked into the executable.
+ */
+extern vm_static_module_t hybris_static_modules[];
+#endif
+
 int hyb_banner(){
     fprintf( stdout, "Hybris %s (built: %s %s)\n"
             "Released under GPL v3.0 by %s\n"
@@ -43,8 +50,17 @@ int hyb_usage( char *argvz ){
     		"\t                 kilobytes (with K postfix) or megabytes (with M postfix).\n"
     		"\t                 i.e. -g 10K or -g 1024 or --gc=100M\n"
     		"\t-c (--cgi)     : Run in CGI mode (stderr will be redirected to stdout).\n"
+    		"\t-f (--fcgi)    : Serve FastCGI requests on the given unix socket, parsing the script once.\n"
+    		"\t-p (--prefork) : Serve FastCGI requests with the given number of worker processes.\n"
             "\t-t (--time)    : Compute execution time and print it to stdout.\n"
-            "\t-s (--trace)   : Enable stack trace report on errors .\n\n", argvz );
+            "\t-s (--trace)   : Enable stack trace report on errors .\n"
+            "\t-e (--eager)   : Load every module of an imported namespace, ignoring its manifest.\n"
+            "\t-l (--lazy)    : Open modules with lazy symbol binding (RTLD_LAZY).\n"
+            "\t-M (--manifest): Write the modules manifests of the given library path and exit.\n"
+            "\t-a (--ast-cache): Parse files loaded and strings evaluated at runtime only once.\n"
+            "\t-O (--snapshot-out): Save functions, types and global variables to the given file\n"
+            "\t                 once the script has been executed.\n"
+            "\t-I (--snapshot-in) : Restore the given snapshot before executing the script.\n\n", argvz );
     return 0;
 }
 
@@ -53,8 +69,16 @@ int main( int argc, char *argv[], char* envp[] ){
     		{ "mem",     1, 0, 'm' },
             { "gc",      1, 0, 'g' },
             { "cgi",	 0, 0, 'c' },
+            { "fcgi",	 1, 0, 'f' },
+            { "prefork", 1, 0, 'p' },
             { "time",    0, 0, 't' },
             { "trace",   0, 0, 's' },
+            { "eager",   0, 0, 'e' },
+            { "lazy",    0, 0, 'l' },
+            { "manifest",1, 0, 'M' },
+            { "ast-cache",0, 0, 'a' },
+            { "snapshot-out",1, 0, 'O' },
+            { "snapshot-in", 1, 0, 'I' },
             /*
              * TODO
              *
@@ -64,17 +88,18 @@ int main( int argc, char *argv[], char* envp[] ){
             { 0, 0, 0, 0 }
     };
 
-    extern vm_t *__hyb_vm;
-    extern int yyparse(void);
+    vm_t *vm = vm_create();
 
-    __hyb_vm = vm_create();
+#ifdef HYBRIS_STATIC_STDLIB
+    vm->statics = hybris_static_modules;
+#endif
 
     int index = 0;
     char c, multiplier, *p;
     long gc_threshold,
 		 mm_threshold;
 
-    while( (c = getopt_long( argc, argv, /* "m:g:ctsdh" */ "m:g:ctsh", options, &index)) != -1 ){
+    while( (c = getopt_long( argc, argv, /* "m:g:ctsdh" */ "m:g:cf:p:tselM:aO:I:h", options, &index)) != -1 ){
         switch (c) {
 			/*
 			 * Handle garbage collection threshold argument.
@@ -137,7 +162,7 @@ int main( int argc, char *argv[], char* envp[] ){
 				/*
 				 * Done, let's pass it to the virtual machine arguments structure.
 				 */
-				__hyb_vm->args.gc_threshold = gc_threshold;
+				vm->args.gc_threshold = gc_threshold;
 			break;
 
 			/*
@@ -201,28 +226,86 @@ int main( int argc, char *argv[], char* envp[] ){
 				/*
 				 * Done, let's pass it to the virtual machine arguments structure.
 				 */
-				__hyb_vm->args.mm_threshold = mm_threshold;
+				vm->args.mm_threshold = mm_threshold;
 			break;
 
         	case 't':
         		/*
         		 * Enable execution time measurement.
         		 */
-        		__hyb_vm->args.tm_timer = 1;
+        		vm->args.tm_timer = 1;
         	break;
 
         	case 'c':
         		/*
         		 * Redirect stderr to stdout in CGI mode.
         		 */
-        		__hyb_vm->args.cgi_mode = true;
+        		vm->args.cgi_mode = true;
+        	break;
+
+        	case 'f':
+        		/*
+        		 * Keep the script resident and serve FastCGI requests.
+        		 */
+        		strncpy( vm->args.fcgi_socket, optarg, sizeof(vm->args.fcgi_socket) - 1 );
+        	break;
+
+        	case 'p':
+        		/*
+        		 * Fork FastCGI workers once the script is parsed.
+        		 */
+        		if( (vm->args.prefork = atoi(optarg)) <= 0 ){
+        			hyb_error( H_ET_GENERIC, "Invalid number of workers %s given.", optarg );
+        		}
         	break;
 
         	case 's':
         		/*
         		 * Enable stack trace printing upon error.
         		 */
-        		__hyb_vm->args.stacktrace = 1;
+        		vm->args.stacktrace = 1;
+        	break;
+
+        	case 'e':
+        		/*
+        		 * Load whole namespaces on import.
+        		 */
+        		vm->args.eager_load = true;
+        	break;
+
+        	case 'l':
+        		/*
+        		 * Resolve modules symbols on first call.
+        		 */
+        		vm->args.rtld_lazy = true;
+        	break;
+
+        	case 'a':
+        		/*
+        		 * Reuse the trees of files and strings parsed at runtime.
+        		 */
+        		vm->args.ast_cache = true;
+        	break;
+
+        	case 'M':
+        		/*
+        		 * Generate the modules manifests instead of running a script.
+        		 */
+        		strncpy( vm->args.manifest, optarg, sizeof(vm->args.manifest) - 1 );
+        	break;
+
+        	case 'O':
+        		/*
+        		 * Save the vm state once the script is executed.
+        		 */
+        		strncpy( vm->args.snapshot_out, optarg, sizeof(vm->args.snapshot_out) - 1 );
+        	break;
+
+        	case 'I':
+        		/*
+        		 * Start from a saved vm state.
+        		 */
+        		strncpy( vm->args.snapshot_in, optarg, sizeof(vm->args.snapshot_in) - 1 );
         	break;
         	/*
         	 * TODO
@@ -230,7 +313,7 @@ int main( int argc, char *argv[], char* envp[] ){
 			 * Enable debug mode.
         	 * case 'd':
         	 *
-        	 *	__hyb_vm->args.debug = true;
+        	 *	vm->args.debug = true;
         	 * break;
 			 */
         	case 'h':
@@ -240,42 +323,69 @@ int main( int argc, char *argv[], char* envp[] ){
     }
 
     if( optind < argc ){
-        strncpy( __hyb_vm->args.source, argv[optind], sizeof(__hyb_vm->args.source) );
-		if( hyb_file_exists(__hyb_vm->args.source) == 0 ){
-			hyb_error( H_ET_GENERIC, "'%s' no such file or directory", __hyb_vm->args.source );
+        strncpy( vm->args.source, argv[optind], sizeof(vm->args.source) );
+		if( hyb_file_exists(vm->args.source) == 0 ){
+			hyb_error( H_ET_GENERIC, "'%s' no such file or directory", vm->args.source );
 		}
     }
     /*
      * vm_t will receive every argument starting from the script
      * name to build the script virtual argv.
      */
-    vm_init( __hyb_vm, optind, &argc, &argv, envp );
+    vm_init( vm, optind, &argc, &argv, envp );
+
+    if( *vm->args.manifest ){
+    	vm_write_manifest( vm, vm->args.manifest );
+    	vm_release( vm );
+    	vm_free( vm );
+    	return 0;
+    }
+    /*
+     * Restore modules, functions, types and globals of a previous run.
+     */
+    if( *vm->args.snapshot_in ){
+    	vm_snapshot_load( vm, vm->args.snapshot_in );
+    }
+
+    if( vm->args.prefork && *vm->args.fcgi_socket == 0x00 ){
+    	hyb_error( H_ET_GENERIC, "--prefork needs a FastCGI socket (see --fcgi)" );
+    }
+    else if( *vm->args.fcgi_socket ){
+    	if( *vm->args.source == 0x00 ){
+    		hyb_error( H_ET_GENERIC, "FastCGI mode needs a script to execute" );
+    	}
+    	hyb_fcgi_main( vm, vm->args.fcgi_socket );
+    	vm_release( vm );
+    	vm_free( vm );
+    	return 0;
+    }
 
     /*
      * TODO
      *
-     * if( __hyb_vm->args.debug ){
-     *     dbg_main( &__hyb_vm->debugger );
+     * if( vm->args.debug ){
+     *     dbg_main( &vm->debugger );
      * }
      */
 
-    extern FILE *yyin;
     /*
-     * At this point, yyin could be a file handle if a source was specified
+     * At this point, the input could be a file handle if a source was specified
      * or the stdin handle if not, in this case the interpreter will execute
      * user input.
      */
-    yyin = vm_fopen( __hyb_vm );
+    FILE *fp = vm_fopen( vm );
+
+	vm_set_state( vm, vmParsing );
 
-	vm_set_state( __hyb_vm, vmParsing );
+    hyb_parse_stream( vm, fp );
 
-    while( !feof(yyin) ){
-        yyparse();
+    if( *vm->args.snapshot_out ){
+    	vm_snapshot_save( vm, vm->args.snapshot_out );
     }
 
-    vm_fclose( __hyb_vm );
-    vm_release( __hyb_vm );
-    vm_free( __hyb_vm );
+    vm_fclose( vm );
+    vm_release( vm );
+    vm_free( vm );
 
     return 0;
 }
@@ -69,14 +69,24 @@ typedef struct YYLTYPE
 # define YYLTYPE_IS_TRIVIAL 1
 #endif
 
-extern int yyparse(void);
-extern int yylex( hyb_token_value* yylval, YYLTYPE *yyloc );
+/*
+ * The parser is pure and the scanner reentrant, the vm being parsed
+ * for and the tree to fill are in the scanner extra data.
+ */
+extern int 			  yyparse( yyscan_t scanner );
+extern int 			  yylex( hyb_token_value* yylval, YYLTYPE *yyloc, yyscan_t scanner );
+extern node_parser_t *yyget_extra( yyscan_t scanner );
+extern void 		  yyerror( char *error );
+
+void yyerror( YYLTYPE *yyloc, yyscan_t scanner, const char *error );
 
 /** macros to define parse tree **/
 /* get the node evaluation */
 #define REDUCE_NODE(a)                			 a
 /* delete the node */
 #define RM_NODE(a)                      		 delete (a)
+/* delete a function or method declaration descriptor */
+#define RM_DECL(a)                      		 delete (a)
 /* identifiers, attributes and constants */
 #define MK_IDENT_NODE( lineno, a)                new IdentifierNode( lineno, a)
 #define MK_ATTR_NODE( lineno, a,b)		         new IdentifierNode( lineno, a,b)
@@ -157,15 +167,18 @@ extern int yylex( hyb_token_value* yylval, YYLTYPE *yyloc );
 #define MK_METHOD_CALL_NODE( lineno, a,b)        new MethodCallNode( lineno, a, b )
 #define MK_QUESTION_NODE( lineno, a, b, c)       new StatementNode( lineno, T_QUESTION, 3, a, b, c )
 
-/*
- * The global virtual machine holder.
- */
-vm_t *__hyb_vm;
-
 %}
 
 %locations
-%pure_parser
+%define api.pure full
+%parse-param { yyscan_t scanner }
+%lex-param   { yyscan_t scanner }
+/*
+ * Nodes of the parse tree are allocated from an arena.
+ */
+%initial-action {
+	node_arena_begin();
+}
 
 %token <boolean>    T_BOOLEAN;
 %token <integer>    T_INTEGER;
@@ -259,16 +272,26 @@ vm_t *__hyb_vm;
 %%
 
 main : statements {
-
-	vm_timer( __hyb_vm, VM_TIMER_START );
-
-	vm_set_state( __hyb_vm, vmExecuting );
-
-	vm_exec( __hyb_vm, &__hyb_vm->vmem, $1 );
-
-	vm_timer( __hyb_vm, VM_TIMER_STOP );
-
-	RM_NODE($1);
+	/*
+	 * The tree is complete, nodes created from now on (while executing
+	 * it) must survive it, so they're not allocated from its arena.
+	 */
+	node_arena_t *arena = node_arena_end();
+	/*
+	 * The tree is executed by the caller once the parser is done
+	 * with it (see hyb_parse_stream).
+	 */
+	node_ast_t   *ast	= yyget_extra(scanner)->ast;
+
+	if( ast ){
+		ast->root  = $1;
+		ast->arena = arena;
+	}
+	else{
+		RM_NODE($1);
+
+		node_arena_release( arena );
+	}
 }
 
 mapList : expression ':' expression ',' mapList { $$ = REDUCE_NODE($5); ll_prepend_pair( $$, $1, $3 ); }
@@ -372,18 +395,22 @@ attrList  : accessSpecifier identList T_EOSTMT attrList {
 methodList : accessSpecifier T_METHOD_PROTOTYPE '{' statements '}' methodList {
 				 $$ = REDUCE_NODE($6);
 				 ll_prepend( $$, MK_METHOD_DECL_NODE( @1.first_line, $1, $2, $4 ) );
+				 RM_DECL($2);
 		   }
 		   | accessSpecifier T_METHOD_PROTOTYPE '{' statements '}' {
 				 $$ = ll_create();
 				 ll_prepend( $$, MK_METHOD_DECL_NODE( @1.first_line, $1, $2, $4 ) );
+				 RM_DECL($2);
 		   }
 		   | T_STATIC T_METHOD_PROTOTYPE '{' statements '}' methodList {
 				 $$ = REDUCE_NODE($6);
 				 ll_prepend( $$, MK_STATIC_METHOD_DECL_NODE( @2.first_line, $2, $4 ) );
+				 RM_DECL($2);
 		   }
 		   | T_STATIC T_METHOD_PROTOTYPE '{' statements '}' {
 				 $$ = ll_create();
 				 ll_prepend( $$, MK_STATIC_METHOD_DECL_NODE( @2.first_line, $2, $4 ) );
+				 RM_DECL($2);
 		   };
 
 classMembers : attrList methodList classMembers {
@@ -443,6 +470,7 @@ statement  : T_EOSTMT                                                   { $$ = M
            /* function declaration */
            | T_FUNCTION_PROTOTYPE '{' statements '}' {
         	   $$ = MK_FUNCTION_NODE( @1.first_line, $1, $3 );
+        	   RM_DECL($1);
            }
            /* structure declaration */
            | T_STRUCT T_IDENT '{' attrList '}' {
@@ -551,3 +579,11 @@ expression : T_BOOLEAN										  { $$ = MK_CONST_NODE(@1.first_line, $1); }
            | '(' expression ')'                               { $$ = REDUCE_NODE($2); };
 
 %%
+
+/*
+ * The pure parser reports errors with their location and the scanner,
+ * the line is already the one kept by the vm.
+ */
+void yyerror( YYLTYPE *yyloc, yyscan_t scanner, const char *error ){
+	yyerror( (char *)error );
+}
@@ -19,11 +19,6 @@
 #include "common.h"
 #include "gc.h"
 #include "vm.h"
-/*
- * The main garbage collector global structure.
- */
-static gc_t __gc;
-
 /*
  * Define to print GC debug messages.
  */
@@ -35,25 +30,35 @@ static gc_t __gc;
 #	define DEBUG //
 #endif
 
+/*
+ * Return the heap of the vm running on this thread.
+ */
+INLINE gc_t *gc_current(){
+	vm_t *vm = vm_current();
+
+	assert( vm != NULL );
+
+	return &vm->gc;
+}
 /*
  * Lock the gc mutex.
  */
-INLINE void gc_lock(){
-	pthread_mutex_lock( &__gc.mutex );
+INLINE void gc_lock( gc_t *gc ){
+	pthread_mutex_lock( &gc->mutex );
 }
 /*
  * Unlock the gc mutex.
  */
-INLINE void gc_unlock(){
-	pthread_mutex_unlock( &__gc.mutex );
+INLINE void gc_unlock( gc_t *gc ){
+	pthread_mutex_unlock( &gc->mutex );
 }
 /*
  * Free 'item' and remove it from 'list'.
  */
-void gc_free( llist_t *list, ll_item_t *item ){
+void gc_free( gc_t *gc, llist_t *list, ll_item_t *item ){
 	Object *obj = ll_data( Object *, item );
 
-    __gc.usage -= obj->gc_size;
+    gc->usage -= obj->gc_size;
     /*
      * If the object is a collection, ob_free is needed to free its elements,
      * because gc_free isn't applied recursively on each object as gc_mark, so
@@ -74,11 +79,12 @@ void gc_free( llist_t *list, ll_item_t *item ){
  * Set collection threshold.
  */
 size_t gc_set_collect_threshold( size_t threshold ){
-	size_t old = __gc.gc_threshold;
+	gc_t  *gc  = gc_current();
+	size_t old = gc->gc_threshold;
 
-	gc_lock();
-	__gc.gc_threshold = threshold;
-	gc_unlock();
+	gc_lock(gc);
+	gc->gc_threshold = threshold;
+	gc_unlock(gc);
 
 	return old;
 }
@@ -86,11 +92,12 @@ size_t gc_set_collect_threshold( size_t threshold ){
  * Set allowed memory threshold.
  */
 size_t gc_set_mm_threshold( size_t threshold ){
-	size_t old = __gc.mm_threshold;
+	gc_t  *gc  = gc_current();
+	size_t old = gc->mm_threshold;
 
-	gc_lock();
-	__gc.mm_threshold = threshold;
-	gc_unlock();
+	gc_lock(gc);
+	gc->mm_threshold = threshold;
+	gc_unlock(gc);
 
 	return old;
 }
@@ -101,6 +108,7 @@ size_t gc_set_mm_threshold( size_t threshold ){
  * possibility.
  */
 Object *gc_track( Object *o, size_t size ){
+	gc_t *gc = gc_current();
 	/*
 	 * We assume that 'o' was previously allocated with one of the gc_new_*
 	 * macros, therefore, if its pointer is null, most of it there was a memory
@@ -112,44 +120,46 @@ Object *gc_track( Object *o, size_t size ){
     /*
      * Check if maximum memory usage is reached.
      */
-    else if( __gc.usage >= __gc.mm_threshold ){
-    	hyb_error( H_ET_GENERIC, "Reached max allowed memory usage (%d bytes)", __gc.mm_threshold );
+    else if( gc->usage >= gc->mm_threshold ){
+    	hyb_error( H_ET_GENERIC, "Reached max allowed memory usage (%d bytes)", gc->mm_threshold );
     }
 
-    gc_lock();
+    gc_lock(gc);
 
     DEBUG( "[GC DEBUG] Tracking new object at %p [%d bytes].\n", o, size );
 
     /*
      * Increment memory usage counter.
      */
-    __gc.usage += size;
+    gc->usage += size;
     /*
      * Update the gc_size inner descriptor.
      */
     o->gc_size = size;
 
-	ll_append( &__gc.heap, o );
+	ll_append( &gc->heap, o );
 
-    gc_unlock();
+    gc_unlock(gc);
 
     return o;
 }
 
 size_t gc_mm_items(){
-	return __gc.heap.items + __gc.lag.items + __gc.constants.items;
+	gc_t *gc = gc_current();
+
+	return gc->heap.items + gc->lag.items + gc->constants.items;
 }
 
 size_t gc_mm_usage(){
-	return __gc.usage;
+	return gc_current()->usage;
 }
 
 size_t gc_collect_threshold(){
-	return __gc.gc_threshold;
+	return gc_current()->gc_threshold;
 }
 
 size_t gc_mm_threshold(){
-	return __gc.mm_threshold;
+	return gc_current()->mm_threshold;
 }
 /*
  * Recursively mark an object (and its inner items).
@@ -179,7 +189,7 @@ void gc_mark( Object *o, bool mark /*= true*/ ){
 /*
  * Sweep dead objects from a given generation list.
  */
-void gc_sweep_generation( llist_t *generation ){
+void gc_sweep_generation( gc_t *gc, llist_t *generation ){
 	ll_item_t *ll_item = generation->head,
 			  *ll_next;
 	Object    *o;
@@ -204,7 +214,7 @@ void gc_sweep_generation( llist_t *generation ){
 		if( (o->attributes & H_OA_CONSTANT) == H_OA_CONSTANT ){
 			DEBUG( "[GC DEBUG] Migrating %p [%s] to constants list.\n", o, ob_typename(o) );
 
-			ll_move( generation, &__gc.constants, ll_item );
+			ll_move( generation, &gc->constants, ll_item );
 		}
 		else{
 			/*
@@ -217,12 +227,12 @@ void gc_sweep_generation( llist_t *generation ){
 				 * If this generation is not the lag space, check if the object
 				 * has to be moved to the lag space.
 				 */
-				if( generation != &__gc.lag && GC_IS_LAGGING(++o->gc_count) ){
+				if( generation != &gc->lag && GC_IS_LAGGING( gc, ++o->gc_count ) ){
 					DEBUG( "[GC DEBUG] Migrating %p (collected %d times) to the lag space.\n", o, o->gc_count );
 					/*
 					 * Migrate the object.
 					 */
-					ll_move( generation, &__gc.lag, ll_item );
+					ll_move( generation, &gc->lag, ll_item );
 				}
 			}
 			/*
@@ -233,7 +243,7 @@ void gc_sweep_generation( llist_t *generation ){
 			else{
 				DEBUG( "[GC DEBUG] Releasing %p [%s] .\n", o, ob_typename(o) );
 
-				gc_free( generation, ll_item );
+				gc_free( gc, generation, ll_item );
 			}
 		}
 
@@ -245,11 +255,12 @@ void gc_sweep_generation( llist_t *generation ){
  * The main collection routine.
  */
 void gc_collect( vm_t *vm ){
+	gc_t *gc = &vm->gc;
     /**
      * Execute garbage collection loop only if used memory has reaced the
      * threshold.
      */
-    if( __gc.usage >= __gc.gc_threshold ){
+    if( gc->usage >= gc->gc_threshold ){
 		ll_item_t *item;
     	vframe_t  *frame;
     	size_t j, size;
@@ -263,7 +274,7 @@ void gc_collect( vm_t *vm ){
     	 */
     	vm_scope_t *scope = vm_find_scope(vm);
 
-    	DEBUG( "[GC DEBUG] GC quota (%d bytes) reached with %d bytes, collecting thread %p scope ...\n", __gc.gc_threshold, __gc.usage, pthread_self() );
+    	DEBUG( "[GC DEBUG] GC quota (%d bytes) reached with %d bytes, collecting thread %p scope ...\n", gc->gc_threshold, gc->usage, pthread_self() );
 
 		/*
 		 * Loop each active main memory frame and mark alive objects.
@@ -280,25 +291,38 @@ void gc_collect( vm_t *vm ){
 				 */
 				gc_set_alive( frame->at(j) );
 			}
+			/*
+			 * Same for anonymous values, temporary roots and pending
+			 * tail call arguments.
+			 */
+			for( j = 0, size = frame->argc(); j < size; ++j ){
+				gc_set_alive( frame->argv(j) );
+			}
+			for( j = 0, size = frame->roots.size(); j < size; ++j ){
+				gc_set_alive( frame->roots[j] );
+			}
+			for( j = 0, size = frame->tail_args.size(); j < size; ++j ){
+				gc_set_alive( frame->tail_args[j] );
+			}
 		}
 		/*
 		 * New collection, increment global collections counter.
 		 */
-		__gc.collections++;
+		gc->collections++;
 		/*
 		 * The lag space is bigger than the heap, let's sweep it first.
 		 */
-		if( __gc.lag.items > __gc.heap.items ){
-			DEBUG( "[GC DEBUG] Lag space (%d items) is bigger than heap space (%d items), collecting it.\n", __gc.lag.items, __gc.heap.items );
+		if( gc->lag.items > gc->heap.items ){
+			DEBUG( "[GC DEBUG] Lag space (%d items) is bigger than heap space (%d items), collecting it.\n", gc->lag.items, gc->heap.items );
 
-			gc_sweep_generation( &__gc.lag );
+			gc_sweep_generation( gc, &gc->lag );
 		}
 		/*
 		 * Sweep younger objects in the heap space.
 		 */
-		gc_sweep_generation( &__gc.heap );
+		gc_sweep_generation( gc, &gc->heap );
 
-		DEBUG( "[GC DEBUG] Garbage collection cycle done, %d collections done.\n", __gc.collections );
+		DEBUG( "[GC DEBUG] Garbage collection cycle done, %d collections done.\n", gc->collections );
 
 		/*
 		 * Unlock the virtual machine frames vector.
@@ -307,7 +331,7 @@ void gc_collect( vm_t *vm ){
     }
 }
 
-INLINE void gc_free_generation( llist_t *generation ){
+INLINE void gc_free_generation( gc_t *gc, llist_t *generation ){
 	ll_item_t *ll_item = generation->head,
 			  *ll_next;
 
@@ -319,7 +343,7 @@ INLINE void gc_free_generation( llist_t *generation ){
 		 */
 		ll_next = ll_item->next;
 
-		gc_free( generation, ll_item );
+		gc_free( gc, generation, ll_item );
 
 		ll_item = ll_next;
 	}
@@ -329,10 +353,8 @@ INLINE void gc_free_generation( llist_t *generation ){
  * Release every object (heap objects and constants), called
  * when program ends.
  */
-void gc_release(){
-	ll_item_t *item;
-
-	gc_free_generation( &__gc.heap );
-	gc_free_generation( &__gc.lag );
-	gc_free_generation( &__gc.constants );
+void gc_release( vm_t *vm ){
+	gc_free_generation( &vm->gc, &vm->gc.heap );
+	gc_free_generation( &vm->gc, &vm->gc.lag );
+	gc_free_generation( &vm->gc, &vm->gc.constants );
 }
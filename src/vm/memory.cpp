@@ -19,8 +19,13 @@
 #include "memory.h"
 #include "common.h"
 
-MemorySegment::MemorySegment() : ITree<Object>() {
-	pthread_mutex_init( &mutex, NULL );
+MemorySegment::MemorySegment() :
+	ITree<Object>(),
+	shared(false),
+	tail_calls(false),
+	tail_function(NULL),
+	elided(0) {
+
 }
 
 Object *MemorySegment::add( char *identifier, Object *object ){
@@ -42,7 +47,7 @@ Object *MemorySegment::add( char *identifier, Object *object ){
     	next->referenced = true;
     }
 
-    pthread_mutex_lock( &mutex );
+    lock();
 
     /* if object does not exist yet, insert as a new one */
     if( (prev = get( identifier )) == H_UNDEFINED ){
@@ -69,7 +74,7 @@ Object *MemorySegment::add( char *identifier, Object *object ){
 			 retn = next;
 		 }
     }
-    pthread_mutex_unlock( &mutex );
+    unlock();
 
     return retn;
 }
@@ -83,6 +88,7 @@ MemorySegment *MemorySegment::clone(){
     for( i = 0; i < m_elements; ++i ){
         clone->add( (char *)label(i), at(i) );
     }
+    clone->args = args;
 
 	clone->state.assign(state);
 
@@ -0,0 +1,950 @@
+/*
+ * This file is part of the Hybris programming language interpreter.
+ *
+ * Copyleft of Simone Margaritelli aka evilsocket <evilsocket@gmail.com>
+ *
+ * Hybris is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Hybris is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hybris.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm.h"
+#include "parser.h"
+#include "hybris.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <set>
+
+using std::set;
+
+/*
+ * A snapshot is a sequence of native longs, doubles and length prefixed
+ * strings, so it can only be restored by the same build that wrote it :
+ *
+ * 	header  : magic, format version, interpreter version
+ * 	modules : name and path of every loaded module
+ * 	lazy    : modules listed in the imported manifests and their symbols
+ * 	vcode   : user functions syntax trees
+ * 	vtypes  : user structures and classes prototypes
+ * 	vmem    : global variables
+ *
+ * Objects are written once, further occurrences of the same object are
+ * written as its index, so shared and cyclic values are restored as such.
+ */
+#define VM_SNAPSHOT_MAGIC   "HYBSNAP"
+#define VM_SNAPSHOT_VERSION 2
+
+enum snapshot_tag_t {
+	stNull = 0,
+	stVoid,
+	stShared,
+	stObject,
+	/* handles and externs, restored as null */
+	stUnsupported
+};
+
+typedef struct _snapshot_writer {
+	vm_t				 *vm;
+	string				  buffer;
+	/* index of every object written so far */
+	map<Object *, long>	  objects;
+	/* user types prototypes and their names */
+	map<Object *, string> prototypes;
+	/* user functions by address, to write aliases */
+	map<ulong, string>	  functions;
+	/* copy on write counters of the collections written so far, by group */
+	map<size_t *, long>	  shares;
+}
+snapshot_writer_t;
+
+typedef struct _snapshot_reader {
+	vm_t			 *vm;
+	const char		 *filename;
+	byte			 *ptr;
+	byte			 *end;
+	/* objects restored so far, by index */
+	vector<Object *>  objects;
+	/* copy on write counters rebuilt so far, by group */
+	vector<size_t *>  shares;
+}
+snapshot_reader_t;
+
+INLINE void sn_put_long( snapshot_writer_t *w, long v ){
+	w->buffer.append( (char *)&v, sizeof(long) );
+}
+
+INLINE void sn_put_double( snapshot_writer_t *w, double v ){
+	w->buffer.append( (char *)&v, sizeof(double) );
+}
+
+INLINE void sn_put_string( snapshot_writer_t *w, const string& s ){
+	sn_put_long( w, s.size() );
+	w->buffer.append( s );
+}
+
+static void sn_corrupted( snapshot_reader_t *r ){
+	hyb_error( H_ET_GENERIC, "'%s' is not a valid snapshot", r->filename );
+}
+
+INLINE void sn_get_bytes( snapshot_reader_t *r, void *dst, size_t size ){
+	if( r->ptr + size > r->end ){
+		sn_corrupted(r);
+	}
+	memcpy( dst, r->ptr, size );
+	r->ptr += size;
+}
+
+INLINE long sn_get_long( snapshot_reader_t *r ){
+	long v;
+	sn_get_bytes( r, &v, sizeof(long) );
+	return v;
+}
+
+INLINE double sn_get_double( snapshot_reader_t *r ){
+	double v;
+	sn_get_bytes( r, &v, sizeof(double) );
+	return v;
+}
+
+INLINE string sn_get_string( snapshot_reader_t *r ){
+	long size = sn_get_long(r);
+
+	if( size < 0 || r->ptr + size > r->end ){
+		sn_corrupted(r);
+	}
+
+	string s( (char *)r->ptr, size );
+	r->ptr += size;
+
+	return s;
+}
+
+static void sn_write_node( snapshot_writer_t *w, Node *node ){
+	Object *constant;
+	size_t  i;
+	long    body = -1;
+
+	if( node == NULL ){
+		sn_put_long( w, -1 );
+		return;
+	}
+
+	for( i = 0; i < node->children.items; ++i ){
+		if( node->body != NULL && node->children.nodes[i] == node->body ){
+			body = i;
+		}
+	}
+
+	sn_put_long( w, node->type );
+	sn_put_long( w, node->opcode );
+	sn_put_long( w, node->lineno );
+	sn_put_string( w, node->value.identifier );
+	sn_put_long( w, node->value.argc );
+	sn_put_long( w, node->value.access );
+	sn_put_long( w, node->value.vargs );
+	sn_put_long( w, node->value.is_static );
+	sn_put_long( w, body );
+
+	switch( node->type ){
+		case H_NT_CONSTANT :
+			constant = node->value.constant;
+
+			sn_put_long( w, constant->type->code );
+			switch( constant->type->code ){
+				case otInteger : sn_put_long( w, (ob_int_ucast(constant))->value );     break;
+				case otFloat   : sn_put_double( w, ob_float_ucast(constant)->value ); break;
+				case otChar    : sn_put_long( w, ob_char_ucast(constant)->value );    break;
+				case otString  : sn_put_string( w, ob_string_ucast(constant)->value ); break;
+				case otBoolean : sn_put_long( w, ob_bool_ucast(constant)->value );    break;
+			}
+		break;
+
+		case H_NT_STATEMENT :
+			if( node->opcode == T_TRY ){
+				sn_write_node( w, node->value.try_block );
+				sn_write_node( w, node->value.catch_block );
+				sn_write_node( w, node->value.finally_block );
+			}
+			else{
+				sn_write_node( w, node->value.switch_block );
+				sn_write_node( w, node->value.default_block );
+			}
+		break;
+
+		case H_NT_CALL :
+			sn_write_node( w, node->value.alias );
+		break;
+
+		case H_NT_ATTRIBUTE   :
+		case H_NT_METHOD_CALL :
+			sn_write_node( w, node->value.owner );
+			sn_write_node( w, node->value.member );
+		break;
+
+		case H_NT_CLASS :
+			sn_put_long( w, ll_size( &node->value.extends ) );
+			ll_foreach( &node->value.extends, llnode ){
+				sn_write_node( w, ll_node(llnode) );
+			}
+		break;
+	}
+
+	sn_put_long( w, node->children.items );
+	for( i = 0; i < node->children.items; ++i ){
+		sn_write_node( w, node->children.nodes[i] );
+	}
+}
+
+static Node *sn_read_node( snapshot_reader_t *r ){
+	long   type = sn_get_long(r),
+		   opcode, lineno, argc, access, vargs, is_static, body, i, n;
+	string identifier;
+	Node  *node = NULL,
+		  *a, *b, *c;
+
+	if( type == -1 ){
+		return NULL;
+	}
+
+	opcode     = sn_get_long(r);
+	lineno     = sn_get_long(r);
+	identifier = sn_get_string(r);
+	argc	   = sn_get_long(r);
+	access	   = sn_get_long(r);
+	vargs	   = sn_get_long(r);
+	is_static  = sn_get_long(r);
+	body	   = sn_get_long(r);
+
+	switch( type ){
+		case H_NT_CONSTANT :
+			switch( sn_get_long(r) ){
+				case otInteger : node = new ConstantNode( lineno, (long)sn_get_long(r) );   break;
+				case otFloat   : node = new ConstantNode( lineno, (double)sn_get_double(r) ); break;
+				case otChar    : node = new ConstantNode( lineno, (char)sn_get_long(r) );   break;
+				case otString  : node = new ConstantNode( lineno, (char *)sn_get_string(r).c_str() ); break;
+				case otBoolean : node = new ConstantNode( lineno, (bool)sn_get_long(r) );   break;
+				default :
+					sn_corrupted(r);
+			}
+		break;
+
+		case H_NT_IDENTIFIER :
+			node = new IdentifierNode( lineno, (char *)identifier.c_str() );
+		break;
+
+		case H_NT_EXPRESSION :
+			node = new ExpressionNode( lineno, opcode );
+		break;
+
+		case H_NT_STATEMENT :
+			if( opcode == T_TRY ){
+				a = sn_read_node(r);
+				b = sn_read_node(r);
+				c = sn_read_node(r);
+
+				node = new TryCatchNode( lineno, opcode, a, (char *)identifier.c_str(), b, c );
+			}
+			else{
+				node = new StatementNode( lineno, opcode );
+				node->value.switch_block  = sn_read_node(r);
+				node->value.default_block = sn_read_node(r);
+			}
+		break;
+
+		case H_NT_FUNCTION :
+			node = new FunctionNode( lineno, identifier.c_str() );
+		break;
+
+		case H_NT_CALL :
+			if( (a = sn_read_node(r)) != NULL ){
+				node = new CallNode( lineno, a, NULL );
+			}
+			else{
+				node = new CallNode( lineno, (char *)identifier.c_str(), NULL );
+			}
+		break;
+
+		case H_NT_STRUCT :
+			node = new StructureNode( lineno, (char *)identifier.c_str(), NULL );
+		break;
+
+		case H_NT_ATTRIBUTE :
+			a = sn_read_node(r);
+			b = sn_read_node(r);
+
+			node = new AttributeRequestNode( lineno, a, b );
+		break;
+
+		case H_NT_METHOD_CALL :
+			a = sn_read_node(r);
+			b = sn_read_node(r);
+
+			node = new MethodCallNode( lineno, a, b );
+		break;
+
+		case H_NT_METHOD_DECL :
+			node = new MethodDeclarationNode( lineno, identifier.c_str(), (access_t)access );
+		break;
+
+		case H_NT_CLASS :
+			node = new ClassNode( lineno, (char *)identifier.c_str(), NULL, NULL );
+			for( i = 0, n = sn_get_long(r); i < n; ++i ){
+				ll_append( &node->value.extends, sn_read_node(r) );
+			}
+		break;
+
+		case H_NT_NEW :
+			node = new NewNode( lineno, (char *)identifier.c_str(), NULL );
+		break;
+
+		default :
+			sn_corrupted(r);
+	}
+
+	node->opcode 		  = opcode;
+	node->value.identifier = identifier;
+	node->value.argc	  = argc;
+	node->value.access	  = (access_t)access;
+	node->value.vargs	  = vargs;
+	node->value.is_static = is_static;
+
+	for( i = 0, n = sn_get_long(r); i < n; ++i ){
+		a = sn_read_node(r);
+		if( i == body ){
+			node->body = a;
+		}
+		node->addChild(a);
+	}
+
+	if( type == H_NT_FUNCTION ){
+		((FunctionNode *)node)->prepare();
+	}
+
+	return node;
+}
+
+/*
+ * Return the prototype of a class instance, or NULL if its class is
+ * not a user defined one.
+ */
+INLINE Object *sn_class_prototype( snapshot_writer_t *w, Object *o ){
+	Object *proto = w->vm->vtypes.find( (char *)ob_class_ucast(o)->name.c_str() );
+
+	return ( proto != NULL && w->prototypes.find(proto) != w->prototypes.end() ? proto : NULL );
+}
+
+/*
+ * Vectors and maps sharing their items after a copy on write clone are
+ * written with the same group index (-1 if they don't share them), so
+ * the reader can rebuild their counter (see sn_share_counter).
+ */
+static long sn_share_group( snapshot_writer_t *w, size_t *shares ){
+	map<size_t *, long>::iterator gi;
+	long						  n;
+
+	if( shares == NULL ){
+		return -1;
+	}
+	else if( (gi = w->shares.find(shares)) != w->shares.end() ){
+		return gi->second;
+	}
+
+	n = w->shares.size();
+	w->shares[shares] = n;
+
+	return n;
+}
+
+static void sn_write_object( snapshot_writer_t *w, Object *o ){
+	map<Object *, long>::iterator   si;
+	map<Object *, string>::iterator pi;
+	ClassAttributeIterator 		    ai;
+	ClassMethodIterator				mi;
+	StructureAttributeIterator		sai;
+	Object						   *proto = NULL;
+	bool							prototype;
+	size_t							i, n;
+
+	if( o == NULL ){
+		sn_put_long( w, stNull );
+		return;
+	}
+	else if( o == H_VOID_VALUE ){
+		sn_put_long( w, stVoid );
+		return;
+	}
+	else if( (si = w->objects.find(o)) != w->objects.end() ){
+		sn_put_long( w, stShared );
+		sn_put_long( w, si->second );
+		return;
+	}
+
+	pi 		  = w->prototypes.find(o);
+	prototype = ( pi != w->prototypes.end() );
+
+	if( ob_is_handle(o) ||
+		ob_is_extern(o) ||
+		( ob_is_alias(o) && w->functions.find( (ob_alias_ucast(o))->value ) == w->functions.end() ) ||
+		( ob_is_class(o) && !prototype && (proto = sn_class_prototype( w, o )) == NULL ) ){
+		hyb_error( H_ET_WARNING, "%s values can not be saved, restoring them as null", ob_typename(o) );
+		sn_put_long( w, stUnsupported );
+		return;
+	}
+
+	n = w->objects.size();
+	w->objects[o] = n;
+
+	sn_put_long( w, stObject );
+	sn_put_long( w, o->type->code );
+	sn_put_long( w, o->referenced );
+	sn_put_long( w, o->attributes & H_OA_CONSTANT );
+
+	switch( o->type->code ){
+		case otBoolean : sn_put_long( w, ob_bool_ucast(o)->value );     break;
+		case otInteger : sn_put_long( w, (ob_int_ucast(o))->value );    break;
+		case otFloat   : sn_put_double( w, ob_float_ucast(o)->value );  break;
+		case otChar    : sn_put_long( w, ob_char_ucast(o)->value );     break;
+		case otString  : sn_put_string( w, ob_string_ucast(o)->value ); break;
+
+		case otBinary :
+			sn_put_long( w, ob_binary_ucast(o)->value.size() );
+			for( i = 0; i < ob_binary_ucast(o)->value.size(); ++i ){
+				sn_put_long( w, ob_ivalue( ob_binary_ucast(o)->value[i] ) );
+			}
+		break;
+
+		case otVector :
+			sn_put_long( w, sn_share_group( w, ob_vector_ucast(o)->shares ) );
+			sn_put_long( w, ob_vector_ucast(o)->items );
+			for( i = 0; i < ob_vector_ucast(o)->items; ++i ){
+				sn_write_object( w, ob_vector_ucast(o)->value[i] );
+			}
+		break;
+
+		case otMap :
+			sn_put_long( w, sn_share_group( w, ob_map_ucast(o)->shares ) );
+			sn_put_long( w, ob_map_ucast(o)->items );
+			for( i = 0; i < ob_map_ucast(o)->items; ++i ){
+				sn_write_object( w, ob_map_ucast(o)->keys[i] );
+				sn_write_object( w, ob_map_ucast(o)->values[i] );
+			}
+		break;
+
+		case otIntArray :
+			sn_put_long( w, ob_intarray_ucast(o)->items );
+			sn_put_long( w, ob_intarray_ucast(o)->value.size() );
+			for( i = 0; i < ob_intarray_ucast(o)->value.size(); ++i ){
+				sn_put_long( w, ob_intarray_ucast(o)->value[i] );
+			}
+		break;
+
+		case otFloatArray :
+			sn_put_long( w, ob_floatarray_ucast(o)->items );
+			sn_put_long( w, ob_floatarray_ucast(o)->value.size() );
+			for( i = 0; i < ob_floatarray_ucast(o)->value.size(); ++i ){
+				sn_put_double( w, ob_floatarray_ucast(o)->value[i] );
+			}
+		break;
+
+		case otStructure : {
+			sn_put_long( w, prototype );
+			if( prototype ){
+				sn_put_string( w, pi->second );
+			}
+			sn_put_long( w, ob_struct_ucast(o)->s_attributes.size() );
+			itree_foreach( Object, sai, ob_struct_ucast(o)->s_attributes ){
+				sn_put_string( w, (*sai)->label );
+				sn_write_object( w, (*sai)->value );
+			}
+		}
+		break;
+
+		case otClass : {
+			ClassAttributeIterator ci;
+
+			sn_put_long( w, prototype );
+			if( prototype ){
+				Class *c = ob_class_ucast(o);
+
+				sn_put_string( w, pi->second );
+				sn_put_string( w, c->name );
+				sn_put_long( w, c->c_attributes.size() );
+				itree_foreach( class_attribute_t, ai, c->c_attributes ){
+					sn_put_string( w, (*ai)->label );
+					sn_put_long( w, (*ai)->value->access );
+					sn_put_long( w, (*ai)->value->is_static );
+					sn_write_object( w, (*ai)->value->value );
+				}
+				sn_put_long( w, c->c_methods ? c->c_methods->size() : 0 );
+				if( c->c_methods != NULL ){
+					itree_foreach( class_method_t, mi, *c->c_methods ){
+						sn_put_string( w, (*mi)->label );
+						sn_put_long( w, (*mi)->value->prototypes.size() );
+						for( i = 0; i < (*mi)->value->prototypes.size(); ++i ){
+							sn_write_node( w, (*mi)->value->prototypes[i] );
+						}
+					}
+				}
+			}
+			/*
+			 * Instances are created from their prototype, only non static
+			 * attributes values are saved.
+			 */
+			else{
+				sn_write_object( w, proto );
+				n = 0;
+				itree_foreach( class_attribute_t, ai, ob_class_ucast(o)->c_attributes ){
+					n += ( (*ai)->value->is_static == false );
+				}
+				sn_put_long( w, n );
+				itree_foreach( class_attribute_t, ci, ob_class_ucast(o)->c_attributes ){
+					if( (*ci)->value->is_static == false ){
+						sn_put_string( w, (*ci)->label );
+						sn_write_object( w, (*ci)->value->value );
+					}
+				}
+			}
+		}
+		break;
+
+		case otReference :
+			sn_write_object( w, ob_ref_ucast(o)->value );
+		break;
+
+		case otAlias :
+			sn_put_string( w, w->functions[ (ob_alias_ucast(o))->value ] );
+		break;
+	}
+}
+
+/*
+ * Count one more collection of the share 'group', return its counter
+ * or NULL if the collection doesn't share its items.
+ * Groups are numbered in the order they're written, so a new group is
+ * always the next one as long as it's read before the collection items.
+ */
+static size_t *sn_share_counter( snapshot_reader_t *r, long group ){
+	if( group < 0 ){
+		return NULL;
+	}
+	else if( group > (long)r->shares.size() ){
+		sn_corrupted(r);
+	}
+	else if( group == (long)r->shares.size() ){
+		r->shares.push_back( new size_t(0) );
+	}
+
+	(*r->shares[group])++;
+
+	return r->shares[group];
+}
+
+static Object *sn_read_object( snapshot_reader_t *r ){
+	long 	tag = sn_get_long(r),
+			code, referenced, constant, i, n, index;
+	Object *o = NULL,
+		   *key,
+		   *value;
+	string  name;
+	size_t *shares;
+
+	switch( tag ){
+		case stNull :
+			return NULL;
+
+		case stVoid :
+			return H_VOID_VALUE;
+
+		case stUnsupported :
+			return (Object *)gc_new_reference(NULL);
+
+		case stShared :
+			index = sn_get_long(r);
+			if( index < 0 || index >= (long)r->objects.size() ){
+				sn_corrupted(r);
+			}
+			return r->objects[index];
+
+		case stObject :
+		break;
+
+		default :
+			sn_corrupted(r);
+	}
+
+	code 	   = sn_get_long(r);
+	referenced = sn_get_long(r);
+	constant   = sn_get_long(r);
+	/*
+	 * Reserve the index before reading inner values, an object is
+	 * available to them once it's created.
+	 */
+	index = r->objects.size();
+	r->objects.push_back(NULL);
+
+	switch( code ){
+		case otBoolean : o = (Object *)gc_new_boolean( sn_get_long(r) ); break;
+		case otInteger : o = (Object *)gc_new_integer( sn_get_long(r) ); break;
+		case otFloat   : o = (Object *)gc_new_float( sn_get_double(r) ); break;
+		case otChar    : o = (Object *)gc_new_char( sn_get_long(r) );    break;
+		case otString  : o = (Object *)gc_new_string( sn_get_string(r).c_str() ); break;
+
+		case otBinary : {
+			vector<unsigned char> data;
+
+			for( i = 0, n = sn_get_long(r); i < n; ++i ){
+				data.push_back( (unsigned char)sn_get_long(r) );
+			}
+			o = (Object *)gc_new_binary(data);
+		}
+		break;
+
+		case otVector :
+			r->objects[index] = o = (Object *)gc_new_vector();
+			shares = sn_share_counter( r, sn_get_long(r) );
+			for( i = 0, n = sn_get_long(r); i < n; ++i ){
+				ob_cl_push_reference( o, sn_read_object(r) );
+			}
+			/*
+			 * Set once the items are in place, so pushing them
+			 * does not unshare the vector.
+			 */
+			ob_vector_ucast(o)->shares = shares;
+		break;
+
+		case otMap :
+			r->objects[index] = o = (Object *)gc_new_map();
+			shares = sn_share_counter( r, sn_get_long(r) );
+			for( i = 0, n = sn_get_long(r); i < n; ++i ){
+				key   = sn_read_object(r);
+				value = sn_read_object(r);
+
+				ob_cl_set_reference( o, key, value );
+			}
+			ob_map_ucast(o)->shares = shares;
+		break;
+
+		case otIntArray :
+			o = (Object *)gc_new_intarray();
+			ob_intarray_ucast(o)->items = sn_get_long(r);
+			for( i = 0, n = sn_get_long(r); i < n; ++i ){
+				ob_intarray_ucast(o)->value.push_back( sn_get_long(r) );
+			}
+		break;
+
+		case otFloatArray :
+			o = (Object *)gc_new_floatarray();
+			ob_floatarray_ucast(o)->items = sn_get_long(r);
+			for( i = 0, n = sn_get_long(r); i < n; ++i ){
+				ob_floatarray_ucast(o)->value.push_back( sn_get_double(r) );
+			}
+		break;
+
+		case otStructure :
+			/* structure prototypes are not garbage collected */
+			if( sn_get_long(r) ){
+				name = sn_get_string(r);
+				o 	 = (Object *)(new Structure());
+			}
+			else{
+				o = (Object *)gc_new_struct();
+			}
+			r->objects[index] = o;
+
+			for( i = 0, n = sn_get_long(r); i < n; ++i ){
+				string attrname = sn_get_string(r);
+
+				value = sn_read_object(r);
+				ob_struct_ucast(o)->s_attributes.insert( (char *)attrname.c_str(), value );
+			}
+			ob_struct_ucast(o)->items = ob_struct_ucast(o)->s_attributes.size();
+		break;
+
+		case otClass :
+			/*
+			 * Prototypes are built the same way vm_exec_class_declaration
+			 * does, inherited attributes and methods included.
+			 */
+			if( sn_get_long(r) ){
+				Class *c = new Class();
+
+				r->objects[index] = o = (Object *)c;
+
+				name 	= sn_get_string(r);
+				c->name = sn_get_string(r);
+
+				for( i = 0, n = sn_get_long(r); i < n; ++i ){
+					string   attrname  = sn_get_string(r);
+					access_t access    = (access_t)sn_get_long(r);
+					bool	 is_static = sn_get_long(r);
+
+					value = sn_read_object(r);
+					if( is_static ){
+						value->referenced = true;
+						gc_set_alive(value);
+					}
+					c->c_attributes.insert( (char *)attrname.c_str(), new class_attribute_t( attrname, access, value, is_static ) );
+				}
+
+				for( i = 0, n = sn_get_long(r); i < n; ++i ){
+					string methodname = sn_get_string(r);
+					long   j, prototypes = sn_get_long(r);
+
+					for( j = 0; j < prototypes; ++j ){
+						Node *method = sn_read_node(r);
+						/*
+						 * ob_define_method stores a clone of the node.
+						 */
+						ob_define_method( o, (char *)methodname.c_str(), method );
+						delete method;
+					}
+				}
+
+				class_build_recipe(o);
+			}
+			else{
+				value = sn_read_object(r);
+				if( value == NULL || ob_is_class(value) == false ){
+					sn_corrupted(r);
+				}
+
+				r->objects[index] = o = class_new_instance(value);
+
+				for( i = 0, n = sn_get_long(r); i < n; ++i ){
+					string 			   attrname  = sn_get_string(r);
+					class_attribute_t *attribute = ob_class_ucast(o)->c_attributes.find( (char *)attrname.c_str() );
+
+					value = sn_read_object(r);
+					if( attribute != NULL && attribute->is_static == false ){
+						value->referenced = true;
+						attribute->value  = value;
+					}
+				}
+			}
+		break;
+
+		case otReference :
+			r->objects[index] = o = (Object *)gc_new_reference(NULL);
+			ob_ref_ucast(o)->value = sn_read_object(r);
+		break;
+
+		case otAlias : {
+			Node *function;
+
+			name = sn_get_string(r);
+			if( (function = r->vm->vcode.find( (char *)name.c_str() )) == H_UNDEFINED ){
+				sn_corrupted(r);
+			}
+			o = (Object *)gc_new_alias( H_ADDRESS_OF(function) );
+		}
+		break;
+
+		default :
+			sn_corrupted(r);
+	}
+
+	r->objects[index] = o;
+
+	o->referenced = referenced;
+	if( constant ){
+		o->attributes |= H_OA_CONSTANT;
+	}
+	/*
+	 * Prototypes are defined as soon as they're restored, instances
+	 * written later could need them.
+	 */
+	if( name.size() ){
+		if( r->vm->vtypes.find( (char *)name.c_str() ) != H_UNDEFINED ){
+			hyb_error( H_ET_GENERIC, "type '%s' restored from '%s' is already defined", name.c_str(), r->filename );
+		}
+		vm_define_type( r->vm, (char *)name.c_str(), o );
+	}
+
+	return o;
+}
+
+void vm_snapshot_save( vm_t *vm, const char *filename ){
+	snapshot_writer_t w;
+	ll_item_t		 *item;
+	vm_module_t		 *module;
+	set<string>		  constants;
+	vector<Object *>  types;
+	FILE			 *fp;
+	size_t			  i, j;
+
+	w.vm = vm;
+
+	sn_put_string( &w, VM_SNAPSHOT_MAGIC );
+	sn_put_long( &w, VM_SNAPSHOT_VERSION );
+	sn_put_string( &w, VERSION );
+	/*
+	 * Modules are loaded again by the restoring process, they will
+	 * define their functions and constants once more.
+	 */
+	sn_put_long( &w, ll_size( &vm->modules ) );
+	for( item = vm->modules.head; item; item = item->next ){
+		module = ll_data( vm_module_t *, item );
+
+		sn_put_string( &w, module->name );
+		sn_put_string( &w, module->path );
+
+		for( j = 0; j < module->constants.size(); ++j ){
+			constants.insert( module->constants[j] );
+		}
+	}
+
+	sn_put_long( &w, vm->deferred.size() );
+	for( i = 0; i < vm->deferred.size(); ++i ){
+		sn_put_string( &w, vm->deferred[i]->path );
+		sn_put_string( &w, vm->deferred[i]->name );
+		sn_put_long( &w, vm->deferred[i]->usecs );
+	}
+	sn_put_long( &w, vm->lazy.size() );
+	for( i = 0; i < vm->lazy.size(); ++i ){
+		for( j = 0; j < vm->deferred.size() && vm->deferred[j] != vm->lazy.at(i); ++j );
+
+		sn_put_string( &w, vm->lazy.label(i) );
+		sn_put_long( &w, j );
+	}
+
+	sn_put_long( &w, vm->vcode.size() );
+	for( i = 0; i < vm->vcode.size(); ++i ){
+		w.functions[ H_ADDRESS_OF( vm->vcode.at(i) ) ] = vm->vcode.label(i);
+
+		sn_put_string( &w, vm->vcode.label(i) );
+		sn_write_node( &w, vm->vcode.at(i) );
+	}
+	/*
+	 * Only structures and classes declared by the scripts, vm_init and
+	 * the modules define the other types.
+	 */
+	for( i = 0; i < vm->vtypes.size(); ++i ){
+		Object *type = vm->vtypes.at(i);
+
+		if( (ob_is_struct(type) || ob_is_class(type)) && constants.find( vm->vtypes.label(i) ) == constants.end() ){
+			w.prototypes[type] = vm->vtypes.label(i);
+			types.push_back(type);
+		}
+	}
+	sn_put_long( &w, types.size() );
+	for( i = 0; i < types.size(); ++i ){
+		sn_write_object( &w, types[i] );
+	}
+
+	sn_put_long( &w, vm->vmem.size() );
+	for( i = 0; i < vm->vmem.size(); ++i ){
+		sn_put_string( &w, vm->vmem.label(i) );
+		sn_write_object( &w, vm->vmem.at(i) );
+	}
+
+	if( (fp = fopen( filename, "w+b" )) == NULL ){
+		hyb_error( H_ET_WARNING, "could not write snapshot '%s'", filename );
+		return;
+	}
+
+	if( fwrite( w.buffer.data(), 1, w.buffer.size(), fp ) != w.buffer.size() ){
+		hyb_error( H_ET_WARNING, "could not write snapshot '%s'", filename );
+	}
+
+	fclose(fp);
+}
+
+void vm_snapshot_load( vm_t *vm, const char *filename ){
+	snapshot_reader_t  r;
+	struct stat		   st;
+	vm_lazy_module_t  *lazy;
+	ll_item_t		  *item;
+	Node			  *function;
+	Object			  *value;
+	void			  *base;
+	int				   fd;
+	long			   i, n, index;
+
+	if( (fd = open( filename, O_RDONLY )) < 0 || fstat( fd, &st ) != 0 ){
+		hyb_error( H_ET_GENERIC, "could not open snapshot '%s'", filename );
+	}
+
+	if( (base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 )) == MAP_FAILED ){
+		hyb_error( H_ET_GENERIC, "could not map snapshot '%s'", filename );
+	}
+
+	r.vm	   = vm;
+	r.filename = filename;
+	r.ptr	   = (byte *)base;
+	r.end	   = r.ptr + st.st_size;
+
+	if( sn_get_string(&r) != VM_SNAPSHOT_MAGIC || sn_get_long(&r) != VM_SNAPSHOT_VERSION ){
+		sn_corrupted(&r);
+	}
+	else if( sn_get_string(&r) != VERSION ){
+		hyb_error( H_ET_GENERIC, "snapshot '%s' was written by another Hybris version", filename );
+	}
+
+	for( i = 0, n = sn_get_long(&r); i < n; ++i ){
+		string name = sn_get_string(&r),
+			   path = sn_get_string(&r);
+
+		vm_load_module( vm, path, name );
+	}
+
+	vm_lazy_lock( vm );
+	for( i = 0, n = sn_get_long(&r); i < n; ++i ){
+		lazy = new vm_lazy_module_t;
+
+		lazy->path   = sn_get_string(&r);
+		lazy->name   = sn_get_string(&r);
+		lazy->usecs  = sn_get_long(&r);
+		lazy->loaded = false;
+
+		for( item = vm->modules.head; item; item = item->next ){
+			if( ll_data( vm_module_t *, item )->name == lazy->name ){
+				lazy->loaded = true;
+				break;
+			}
+		}
+
+		vm->deferred.push_back(lazy);
+	}
+	for( i = 0, n = sn_get_long(&r); i < n; ++i ){
+		string symbol = sn_get_string(&r);
+
+		if( (index = sn_get_long(&r)) < (long)vm->deferred.size() && vm->lazy.find( (char *)symbol.c_str() ) == H_UNDEFINED ){
+			vm->lazy.insert( (char *)symbol.c_str(), vm->deferred[index] );
+		}
+	}
+	vm_lazy_unlock( vm );
+
+	for( i = 0, n = sn_get_long(&r); i < n; ++i ){
+		string name = sn_get_string(&r);
+
+		function = sn_read_node(&r);
+		if( vm->vcode.find( (char *)name.c_str() ) != H_UNDEFINED ){
+			hyb_error( H_ET_GENERIC, "function '%s' restored from '%s' is already defined", name.c_str(), filename );
+		}
+		vm->vcode.insert( (char *)name.c_str(), function );
+	}
+
+	for( i = 0, n = sn_get_long(&r); i < n; ++i ){
+		sn_read_object(&r);
+	}
+
+	for( i = 0, n = sn_get_long(&r); i < n; ++i ){
+		string name = sn_get_string(&r);
+
+		if( (value = sn_read_object(&r)) != NULL ){
+			vm->vmem.insert( (char *)name.c_str(), value );
+		}
+	}
+
+	munmap( base, st.st_size );
+	close(fd);
+}
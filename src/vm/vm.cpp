@@ -47,9 +47,33 @@ void vm_str_split( string& str, string delimiters, vector<string>& tokens ){
     }
 }
 
+/*
+ * The vm each thread is running.
+ */
+static pthread_key_t  __vm_current_key;
+static pthread_once_t __vm_current_once = PTHREAD_ONCE_INIT;
+
+static void vm_current_init(){
+	pthread_key_create( &__vm_current_key, NULL );
+}
+
+vm_t *vm_current(){
+	pthread_once( &__vm_current_once, vm_current_init );
+
+	return (vm_t *)pthread_getspecific( __vm_current_key );
+}
+
+void vm_set_current( vm_t *vm ){
+	pthread_once( &__vm_current_once, vm_current_init );
+
+	pthread_setspecific( __vm_current_key, vm );
+}
+
 vm_t *vm_create(){
 	vm_t *vm = new vm_t;
 
+	vm_set_current( vm );
+
     memset( &vm->args, 0x00, sizeof(vm_args_t) );
     /*
      * Input file handle.
@@ -59,6 +83,14 @@ vm_t *vm_create(){
      * Releasing flag.
      */
     vm->releasing = false;
+    /*
+     * No module initializer running.
+     */
+    vm->loading   = NULL;
+    /*
+     * No modules linked into the executable until the main sets them.
+     */
+    vm->statics   = NULL;
     /*
 	* Set the initial vm state.
 	*/
@@ -68,9 +100,6 @@ vm_t *vm_create(){
 }
 
 FILE *vm_fopen( vm_t *vm ){
-	extern vector<string> __hyb_file_stack;
-	extern vector<int>	  __hyb_line_stack;
-
     if( *vm->args.source ){
     	const char *filename = vm->args.source,
 				   *sep 	 = strrchr( filename, '/' );
@@ -79,8 +108,8 @@ FILE *vm_fopen( vm_t *vm ){
     	}
     	vm_set_source( vm, filename );
 
-    	__hyb_file_stack.push_back( filename );
-    	__hyb_line_stack.push_back( 1 );
+    	vm->files.push_back( filename );
+    	vm->lines.push_back( 1 );
 
         vm->fp = fopen( vm->args.source, "r" );
         vm_chdir( vm );
@@ -88,7 +117,7 @@ FILE *vm_fopen( vm_t *vm ){
     else{
     	vm_set_source( vm, "<stdin>" );
 
-    	__hyb_file_stack.push_back("<stdin>");
+    	vm->files.push_back("<stdin>");
 
     	vm->fp = stdin;
     }
@@ -120,6 +149,10 @@ void vm_init( vm_t *vm, int optind, int *argc, char **argv[], char *envp[] ){
     int i;
     char name[0xFF] = {0};
 
+    /*
+     * Constants below are allocated on this vm heap.
+     */
+    vm_set_current( vm );
     /*
      * Initialize argc and argv references.
      */
@@ -162,6 +195,17 @@ void vm_init( vm_t *vm, int optind, int *argc, char **argv[], char *envp[] ){
 		gc_set_mm_threshold(vm->args.mm_threshold);
 	}
 
+    /*
+     * Initialize the binary operators dispatch matrix.
+     */
+    ob_dispatch_init();
+    /*
+     * Global segments are the only ones shared among threads.
+     */
+    vm->vconst.share();
+    vm->vmem.share();
+    vm->vtypes.share();
+
     vm->vmem.owner = "<main>";
     /*
      * The first frame is always the main one.
@@ -195,8 +239,33 @@ void vm_init( vm_t *vm, int optind, int *argc, char **argv[], char *envp[] ){
     vm->env = envp;
 }
 
+/*
+ * Free the trees kept by an ast cache, nothing is executing them
+ * anymore at this point.
+ */
+static void vm_release_trees( vm_ast_cache_t *cache ){
+	node_ast_t  *ast;
+	unsigned int i;
+
+	for( i = 0; i < cache->size(); ++i ){
+		ast = cache->at(i);
+
+		node_ast_release( ast );
+
+		delete ast;
+	}
+
+	cache->clear();
+}
+
 void vm_release( vm_t *vm ){
+	vm_t *current = vm_current();
+
 	vm->releasing = true;
+	/*
+	 * Destructors called while releasing the heap run on this vm.
+	 */
+	vm_set_current( vm );
 
     vm_mm_lock( vm );
         if( vm->th_frames.size() ){
@@ -228,11 +297,15 @@ void vm_release( vm_t *vm ){
      * gc_release must be called before anything else because it will
      * need vmem, vconst, vtypes and so on to call classes destructors.
      */
-    gc_release();
+    gc_release( vm );
+
+    vm_release_trees( &vm->ast_files );
+    vm_release_trees( &vm->ast_strings );
 
 	ll_item_t	  *m_item,
 				  *f_item;
 	vm_module_t   *module;
+	size_t		   i;
 
 	for( m_item = vm->modules.head; m_item; m_item = m_item->next ){
 		module = ll_data( vm_module_t *, m_item );
@@ -244,19 +317,104 @@ void vm_release( vm_t *vm ){
 
 	ll_clear(&vm->modules);
 
+	for( i = 0; i < vm->deferred.size(); ++i ){
+		delete vm->deferred[i];
+	}
+	vm->deferred.clear();
+	vm->lazy.clear();
+
     vm->mcache.clear();
     vm->vconst.release();
     vm->vmem.release();
     vm->vcode.release();
     vm->vtypes.release();
 
+    vm->files.clear();
+    vm->lines.clear();
+    vm->included.clear();
+
     vm->releasing = false;
+
+    vm_set_current( current == vm ? NULL : current );
+}
+
+/*
+ * Return the name of 'path' relative to LIB_PATH and without extension,
+ * as used by the static modules table.
+ */
+static string vm_static_module_path( string path ){
+	size_t pos;
+
+	if( path.find(LIB_PATH) == 0 ){
+		path = path.substr( strlen(LIB_PATH) );
+	}
+	if( (pos = path.rfind(DYN_EXT)) != string::npos && pos + strlen(DYN_EXT) == path.size() ){
+		path.erase(pos);
+	}
+	/* a namespace path has a trailing slash */
+	while( path.size() && path[path.size() - 1] == '/' ){
+		path.erase( path.size() - 1 );
+	}
+
+	return path;
+}
+
+static vm_static_module_t *vm_find_static_module( vm_t *vm, string& path ){
+	vm_static_module_t *module;
+	string				name;
+
+	if( vm->statics == NULL ){
+		return NULL;
+	}
+
+	name = vm_static_module_path(path);
+	for( module = vm->statics; module->path; ++module ){
+		if( name == module->path ){
+			return module;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Load every static module inside the namespace 'path', return false
+ * if there's none.
+ */
+static bool vm_load_static_namespace( vm_t *vm, string& path ){
+	vm_static_module_t *module;
+	string				ns,
+						name;
+	bool				found = false;
+
+	if( vm->statics == NULL ){
+		return false;
+	}
+
+	ns = vm_static_module_path(path) + '/';
+	for( module = vm->statics; module->path; ++module ){
+		name = module->path;
+		if( name.find(ns) == 0 ){
+			vm_load_module( vm, string(LIB_PATH) + name + DYN_EXT, name.substr( name.rfind('/') + 1 ) );
+			found = true;
+		}
+	}
+
+	return found;
 }
 
 void vm_load_namespace( vm_t *vm, string path ){
     DIR           *dir;
     struct dirent *ent;
 
+    /* modules linked into the executable don't need the filesystem */
+    if( vm_load_static_namespace( vm, path ) ){
+    	return;
+    }
+    /* modules listed in the manifest will be loaded on first use */
+    else if( vm->args.eager_load == false && vm_load_manifest( vm, path ) ){
+    	return;
+    }
+
     if( (dir = opendir(path.c_str())) == NULL ) {
         hyb_error( H_ET_GENERIC, "could not open directory '%s' for reading", path.c_str() );
     }
@@ -278,48 +436,72 @@ void vm_load_namespace( vm_t *vm, string path ){
     closedir(dir);
 }
 
+static vm_module_t *vm_find_module( vm_t *vm, string& name ){
+	ll_item_t   *item;
+	vm_module_t *module;
+
+	for( item = vm->modules.head; item; item = item->next ){
+		module = ll_data( vm_module_t *, item );
+		if( module->name == name ){
+			return module;
+		}
+	}
+	return NULL;
+}
+
 void vm_load_module( vm_t *vm, string path, string name ){
     int i(0), a, j, k, max_argc = 0;
-    ll_item_t 	*item;
-    vm_module_t *module;
+    vm_module_t 		*module;
+    vm_static_module_t  *smodule;
+    vm_function_decl_t  *functions;
+    initializer_t		 initializer;
+    void				*hmodule = NULL;
 
     /* check that the module isn't already loaded */
-    for( item = vm->modules.head; item; item = item->next ){
-    	module = ll_data( vm_module_t *, item );
-        if( module->name == name ){
-            return;
-        }
+    if( vm_find_module( vm, name ) != NULL ){
+    	return;
     }
 
-    /* load the module */
-    void *hmodule = dlopen( path.c_str(), RTLD_NOW );
-    if( !hmodule ){
-        char *error = dlerror();
-        if( error == NULL ){
-            hyb_error( H_ET_WARNING, "module '%s' could not be loaded", path.c_str() );
-        }
-        else{
-            hyb_error( H_ET_WARNING, "%s", error );
-        }
-        return;
+    /* is the module linked into the executable ? */
+    if( (smodule = vm_find_static_module( vm, path )) != NULL ){
+    	functions   = smodule->functions;
+    	initializer = smodule->initializer;
     }
+    else{
+		/* load the module */
+		hmodule = dlopen( path.c_str(), vm->args.rtld_lazy ? RTLD_LAZY : RTLD_NOW );
+		if( !hmodule ){
+			char *error = dlerror();
+			if( error == NULL ){
+				hyb_error( H_ET_WARNING, "module '%s' could not be loaded", path.c_str() );
+			}
+			else{
+				hyb_error( H_ET_WARNING, "%s", error );
+			}
+			return;
+		}
 
-    /* load initialization routine, usually used for constants definition, etc */
-    initializer_t initializer = (initializer_t)dlsym( hmodule, "hybris_module_init" );
-    if(initializer){
-        initializer( vm );
-    }
+		/* exported functions vector */
+		functions = (vm_function_decl_t *)dlsym( hmodule, "hybris_module_functions" );
+		if(!functions){
+			dlclose(hmodule);
+			hyb_error( H_ET_WARNING, "could not find module '%s' functions pointer", path.c_str() );
+			return;
+		}
 
-    /* exported functions vector */
-    vm_function_t *functions = (vm_function_t *)dlsym( hmodule, "hybris_module_functions" );
-    if(!functions){
-        dlclose(hmodule);
-        hyb_error( H_ET_WARNING, "could not find module '%s' functions pointer", path.c_str() );
-        return;
+		/* load initialization routine, usually used for constants definition, etc */
+		initializer = (initializer_t)dlsym( hmodule, "hybris_module_init" );
     }
 
     module = new vm_module_t( name, path, hmodule, initializer );
 
+    if(initializer){
+    	/* let vm_define_constant record the names the module defines */
+    	vm->loading = module;
+        initializer( vm );
+        vm->loading = NULL;
+    }
+
     while( functions[i].function != NULL ){
         vm_function_t *function = new vm_function_t();
 
@@ -327,40 +509,41 @@ void vm_load_module( vm_t *vm, string path, string name ){
         function->function   = functions[i].function;
 
         max_argc = 0;
-        for( a = 0;; ++a ){
+        for( a = 0; a < H_MAX_ARGC_VARIANTS && functions[i].argc[a] >= 0; ++a ){
         	int argc = functions[i].argc[a];
-        	function->argc[a] = argc;
-        	if( argc >= 0 ){
-        		if( argc > max_argc ){
-        			max_argc = argc;
-        		}
-        	}
-        	else{
-        		break;
+        	function->argc.push_back(argc);
+        	if( argc > max_argc ){
+        		max_argc = argc;
         	}
         }
-
-        if( max_argc > 0 ){
-			/*
-			 * For each argument.
-			 */
-			for( j = 0; j < max_argc; ++j ){
-				/*
-				 * For each type.
-				 */
-				for( k = 0;; ++k ){
-					H_OBJECT_TYPE type = functions[i].types[j][k];
-					if( type != otEndMarker ){
-						function->types[j][k] = type;
-					}
-					else{
-						break;
-					}
+        function->argc.push_back(-1);
+        /*
+         * Compile the allowed types of each argument into a mask.
+         */
+        if( max_argc > H_MAX_TYPED_ARGS ){
+        	max_argc = H_MAX_TYPED_ARGS;
+        }
+        function->types.resize( max_argc, 0 );
+		for( j = 0; j < max_argc; ++j ){
+			for( k = 0; k <= H_OBJECT_TYPES; ++k ){
+				H_OBJECT_TYPE type = functions[i].types[j][k];
+				if( type <= otVoid ){
+					break;
 				}
+				function->types[j] |= H_TYPE_BIT(type);
 			}
 		}
 
         ll_append( &module->functions, function );
+        /*
+         * Index the function, if more modules export the same name,
+         * the first loaded one is used.
+         */
+        vm_mcache_lock( vm );
+        if( vm->mcache.find( (char *)function->identifier.c_str() ) == H_UNDEFINED ){
+        	vm->mcache.insert( (char *)function->identifier.c_str(), function );
+        }
+        vm_mcache_unlock( vm );
 
         ++i;
     }
@@ -405,12 +588,185 @@ void vm_load_module( vm_t *vm, char *module ){
     vm_load_module( vm, path, name );
 }
 
+bool vm_load_manifest( vm_t *vm, string path ){
+	FILE			 *fp;
+	char			  line[0xFF]    = {0},
+					  modpath[0xFF] = {0},
+					  name[0xFF]    = {0},
+					  symbol[0xFF]  = {0},
+					  kind;
+	ulong			  usecs;
+	size_t			  i;
+	vm_lazy_module_t *lazy = NULL;
+
+	path = (path[path.size() - 1] == '/' ? path : path + '/');
+	if( (fp = fopen( (path + VM_MANIFEST_NAME).c_str(), "rt" )) == NULL ){
+		return false;
+	}
+
+	vm_lazy_lock( vm );
+	while( fgets( line, sizeof(line), fp ) != NULL ){
+		/* module entry : M <relative path> <name> <load time> */
+		if( sscanf( line, "M %254s %254s %lu", modpath, name, &usecs ) == 3 ){
+			lazy = new vm_lazy_module_t;
+
+			lazy->path   = path + modpath;
+			lazy->name   = name;
+			lazy->usecs  = usecs;
+			lazy->loaded = ( vm_find_module( vm, lazy->name ) != NULL );
+
+			/* the same namespace could be imported more than once */
+			for( i = 0; i < vm->deferred.size(); ++i ){
+				if( vm->deferred[i]->path == lazy->path ){
+					break;
+				}
+			}
+			if( i < vm->deferred.size() ){
+				delete lazy;
+				lazy = NULL;
+			}
+			else{
+				vm->deferred.push_back(lazy);
+			}
+		}
+		/* function or constant entry of the last module : F|C <name> */
+		else if( lazy && sscanf( line, "%c %254s", &kind, symbol ) == 2 && (kind == 'F' || kind == 'C') ){
+			/* if more modules export the same name, the first one is used */
+			if( vm->lazy.find(symbol) == H_UNDEFINED ){
+				vm->lazy.insert( symbol, lazy );
+			}
+		}
+	}
+	vm_lazy_unlock( vm );
+
+	fclose(fp);
+
+	return true;
+}
+
+typedef struct {
+	string		 path;
+	vm_module_t *module;
+	ulong		 usecs;
+}
+vm_manifest_entry_t;
+
+static void vm_scan_manifest( vm_t *vm, string path, vector<vm_manifest_entry_t>& entries ){
+    DIR           	   *dir;
+    struct dirent 	   *ent;
+    FILE			   *fp;
+    size_t			    first = entries.size(),
+    					i, j;
+    ulong				start;
+    ll_item_t		   *item;
+    vm_manifest_entry_t entry;
+
+    path = (path[path.size() - 1] == '/' ? path : path + '/');
+    if( (dir = opendir(path.c_str())) == NULL ) {
+        hyb_error( H_ET_GENERIC, "could not open directory '%s' for reading", path.c_str() );
+    }
+
+    while( (ent = readdir(dir)) != NULL ){
+    	/* recurse into directories, their entries are relative to this one */
+        if( ent->d_type == DT_DIR && strcmp( ent->d_name, ".." ) && strcmp( ent->d_name, "." ) ){
+        	j = entries.size();
+        	vm_scan_manifest( vm, path + ent->d_name, entries );
+        	for( i = j; i < entries.size(); ++i ){
+        		entries[i].path = string(ent->d_name) + '/' + entries[i].path;
+        	}
+        }
+        /* load the module and measure how long it takes */
+        else if( strstr( ent->d_name, DYN_EXT ) ){
+            string modname = string(ent->d_name);
+            modname.replace( modname.find(DYN_EXT), strlen(DYN_EXT), "" );
+
+            j     = ll_size( &vm->modules );
+            start = hyb_uticks();
+            vm_load_module( vm, path + ent->d_name, modname );
+
+            if( ll_size( &vm->modules ) > j ){
+            	entry.usecs  = hyb_uticks() - start;
+            	entry.path   = ent->d_name;
+            	entry.module = (vm_module_t *)ll_back( &vm->modules );
+            	entries.push_back(entry);
+            }
+        }
+    }
+
+    closedir(dir);
+
+    if( (fp = fopen( (path + VM_MANIFEST_NAME).c_str(), "w+t" )) == NULL ){
+    	hyb_error( H_ET_WARNING, "could not write '%s%s'", path.c_str(), VM_MANIFEST_NAME );
+    	return;
+    }
+
+    for( i = first; i < entries.size(); ++i ){
+    	fprintf( fp, "M %s %s %lu\n", entries[i].path.c_str(), entries[i].module->name.c_str(), entries[i].usecs );
+    	for( item = entries[i].module->functions.head; item; item = item->next ){
+    		fprintf( fp, "F %s\n", ll_data( vm_function_t *, item )->identifier.c_str() );
+    	}
+    	for( j = 0; j < entries[i].module->constants.size(); ++j ){
+    		fprintf( fp, "C %s\n", entries[i].module->constants[j].c_str() );
+    	}
+    }
+
+    fclose(fp);
+}
+
+void vm_write_manifest( vm_t *vm, string path ){
+	vector<vm_manifest_entry_t> entries;
+
+	vm_scan_manifest( vm, path, entries );
+}
+
+bool vm_lazy_load( vm_t *vm, char *identifier ){
+	vm_lazy_module_t *lazy;
+
+	if( vm->deferred.empty() || (lazy = vm->lazy.find(identifier)) == H_UNDEFINED ){
+		return false;
+	}
+	/*
+	 * Check again once locked, another thread could have loaded
+	 * the module in the meanwhile.
+	 */
+	if( lazy->loaded == false ){
+		vm_lazy_lock( vm );
+		if( lazy->loaded == false ){
+			vm_load_module( vm, lazy->path, lazy->name );
+			lazy->loaded = true;
+		}
+		vm_lazy_unlock( vm );
+	}
+
+	return true;
+}
+
+void vm_lazy_report( vm_t *vm ){
+	size_t i, skipped = 0;
+	ulong  saved      = 0;
+	char   buffer[0xFF] = {0};
+
+	if( vm->deferred.empty() ){
+		return;
+	}
+
+	for( i = 0; i < vm->deferred.size(); ++i ){
+		if( vm->deferred[i]->loaded == false ){
+			++skipped;
+			saved += vm->deferred[i]->usecs;
+		}
+	}
+
+	hyb_timediff( saved, buffer );
+	fprintf( stdout, "\033[01;33m[TIME] %lu of %lu modules never loaded, %s of startup saved .\n\033[00m", skipped, vm->deferred.size(), buffer );
+}
+
 Object *vm_raise_exception( const char *fmt, ... ){
-	extern vm_t *__hyb_vm;
+	vm_t   *vm = vm_current();
     char message[MAX_MESSAGE_SIZE] = {0};
 	va_list ap;
 
-	vm_mm_lock( __hyb_vm );
+	vm_mm_lock( vm );
 
 	va_start( ap, fmt );
 		vsnprintf( message, MAX_MESSAGE_SIZE, fmt, ap );
@@ -424,9 +780,9 @@ Object *vm_raise_exception( const char *fmt, ... ){
 	 */
 	gc_set_alive(exception);
 
-	vm_frame(__hyb_vm)->state.set( Exception, exception );
+	vm_frame(vm)->state.set( Exception, exception );
 
-	vm_mm_unlock( __hyb_vm );
+	vm_mm_unlock( vm );
 
 	return H_DEFAULT_ERROR;
 }
@@ -456,6 +812,9 @@ void vm_print_stack_trace( vm_t *vm, bool force /*= false*/ ){
 			if( frame->owner == "<main>" ){
 				fprintf( stderr, "<main>\n" );
 			}
+			else if( frame->elided ){
+				fprintf( stderr, "%s() (%d tail calls elided)\n", frame->owner.c_str(), frame->elided );
+			}
 			else{
 				fprintf( stderr, "%s()\n", frame->owner.c_str() );
 			}
@@ -475,7 +834,7 @@ void vm_print_stack_trace( vm_t *vm, bool force /*= false*/ ){
 }
 
 void vm_parse_frame_argv( vframe_t *argv, char *format, ... ){
-	size_t argc( argv->size() ),
+	size_t argc( argv->argc() ),
 		   i;
 	char   *ptr;
 	va_list va;
@@ -507,7 +866,7 @@ void vm_parse_frame_argv( vframe_t *argv, char *format, ... ){
 	 * will be fetched from the frame and formatted.
 	 */
 	for( i = 0, ptr = format; i < argc && *ptr; ++i, ++ptr ){
-		Object *o = argv->at(i);
+		Object *o = argv->argv(i);
 
 		switch( *ptr ){
 			/*
@@ -547,12 +906,83 @@ void vm_parse_frame_argv( vframe_t *argv, char *format, ... ){
 #undef HANDLE_H_TYPE
 }
 
+/*
+ * Each thread keeps its own pool of released frames, so user function
+ * calls do not allocate and free the frame and its hash index every time.
+ */
+typedef vector<vframe_t *> vm_frame_pool_t;
+
+static pthread_key_t  __frame_pool_key;
+static pthread_once_t __frame_pool_once = PTHREAD_ONCE_INIT;
+
+static void vm_frame_pool_free( void *p ){
+	vm_frame_pool_t *pool = (vm_frame_pool_t *)p;
+	size_t 			 i, size( pool->size() );
+
+	for( i = 0; i < size; ++i ){
+		delete pool->at(i);
+	}
+	delete pool;
+}
+
+static void vm_frame_pool_init(){
+	pthread_key_create( &__frame_pool_key, vm_frame_pool_free );
+}
+
+INLINE vm_frame_pool_t *vm_frame_pool(){
+	vm_frame_pool_t *pool;
+
+	pthread_once( &__frame_pool_once, vm_frame_pool_init );
+
+	if( (pool = (vm_frame_pool_t *)pthread_getspecific( __frame_pool_key )) == NULL ){
+		pool = new vm_frame_pool_t;
+		pool->reserve( VM_FRAME_POOL_SIZE );
+		pthread_setspecific( __frame_pool_key, pool );
+	}
+
+	return pool;
+}
+
+vframe_t *vm_frame_acquire( size_t size ){
+	vm_frame_pool_t *pool  = vm_frame_pool();
+	vframe_t		*frame;
+
+	if( pool->empty() ){
+		frame = new vframe_t;
+	}
+	else{
+		frame = pool->back();
+		pool->pop_back();
+	}
+
+	frame->reserve( size > VM_FRAME_MAX_SIZE ? VM_FRAME_MAX_SIZE : size );
+
+	return frame;
+}
+
+void vm_frame_release( vframe_t *frame ){
+	vm_frame_pool_t *pool = vm_frame_pool();
+
+	frame->release();
+	frame->state.reset();
+	frame->tail_calls    = false;
+	frame->tail_function = H_UNDEFINED;
+	frame->elided		 = 0;
+	frame->tail_args.clear();
+
+	if( pool->size() < VM_FRAME_POOL_SIZE ){
+		pool->push_back(frame);
+	}
+	else{
+		delete frame;
+	}
+}
+
 /*
  * Here starts the vm execution functions definition.
  */
 INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner,  Object *cobj, int argc, Node *prototype, Node *argv ){
 	int 	   i, n_ids(prototype->children.items);
-	ll_item_t *iitem, *aitem;
 	Object 	  *value;
 
 	/*
@@ -578,8 +1008,8 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 	/*
 	 * Evaluate each object and insert it into the stack
 	 */
-	for( i = 0, iitem = prototype->children.head, aitem = argv->children.head; i < argc; ++i, aitem = aitem->next ){
-		value = vm_exec( vm, root, ll_node( aitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, root, argv->child(i) );
 		value->referenced = true;
 
 		if( root->state.is(Exception) ){
@@ -590,8 +1020,7 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 			stack.push( value );
 		}
 		else{
-			stack.insert( ll_node( iitem )->id(), value );
-			iitem = iitem->next;
+			stack.insert( prototype->child(i)->id(), value );
 		}
 	}
 }
@@ -599,7 +1028,6 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 INLINE void vm_prepare_stack( vm_t *vm, vframe_t &stack, string owner, Object *cobj, Node *ids, int argc, ... ){
 	va_list    ap;
 	int 	   i, n_ids(ids->children.items);
-	ll_item_t *iitem;
 	Object 	  *value;
 
 	/*
@@ -615,7 +1043,7 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t &stack, string owner, Object *c
 	 * Evaluate each object and insert it into the stack
 	 */
 	va_start( ap, argc );
-	for( i = 0, iitem = ids->children.head; i < argc; ++i ){
+	for( i = 0; i < argc; ++i ){
 		value = va_arg( ap, Object * );
 		value->referenced = true;
 
@@ -623,9 +1051,7 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t &stack, string owner, Object *c
 			stack.push( value );
 		}
 		else{
-			stack.insert( ll_node( iitem )->id(), value );
-
-			iitem = iitem->next;
+			stack.insert( ids->child(i)->id(), value );
 		}
 	}
 	va_end(ap);
@@ -648,9 +1074,9 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t &stack, string owner, vector<st
 	 */
 	stack.owner = owner;
 
-	argc = argv->size();
+	argc = argv->argc();
 	for( i = 0; i < argc; ++i ){
-		value = argv->at(i);
+		value = argv->argv(i);
 		value->referenced = true;
 
 		if( i >= n_ids ){
@@ -667,9 +1093,8 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t &stack, string owner, vector<st
 	vm_add_frame( vm, &stack );
 }
 
-INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner, vector<string> ids, Node *argv ){
-	int 	   i, n_ids( ids.size() ), argc;
-	ll_item_t *iitem;
+INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, FunctionNode *function, Node *argv ){
+	size_t 	   i, n_ids( function->params.size() ), argc;
 	Object 	  *value;
 
 	/*
@@ -681,15 +1106,15 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 	/*
 	 * Set the stack owner
 	 */
-	stack.owner = owner;
+	stack.owner = function->value.identifier;
 	/*
 	 * Add this frame as the active stack
 	 */
 	vm_add_frame( vm, &stack );
 
 	argc = argv->children.items;
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, root, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, root, argv->child(i) );
 		value->referenced = true;
 
 		if( root->state.is(Exception) ){
@@ -701,15 +1126,43 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 			stack.push( value );
 		}
 		else{
-			stack.insert( (char *)ids[i].c_str(), value );
+			stack.insert( function->params[i], value );
 		}
 	}
 }
 
+/*
+ * Reuse 'stack' for the pending tail call, replacing the old
+ * arguments and locals with the tail call ones.
+ */
+INLINE void vm_prepare_tail_stack( vframe_t *stack ){
+	FunctionNode *function = (FunctionNode *)stack->tail_function;
+	size_t 		  i, n_ids( function->params.size() ), argc( stack->tail_args.size() );
+	Object 		 *value;
+
+	stack->release();
+	stack->state.reset();
+	stack->reserve( function->frame_size > VM_FRAME_MAX_SIZE ? VM_FRAME_MAX_SIZE : function->frame_size );
+
+	stack->owner 		 = function->value.identifier;
+	stack->tail_function = H_UNDEFINED;
+	stack->elided++;
+
+	for( i = 0; i < argc; ++i ){
+		value = stack->tail_args[i];
+		if( i >= n_ids ){
+			stack->push( value );
+		}
+		else{
+			stack->insert( function->params[i], value );
+		}
+	}
+	stack->tail_args.clear();
+}
+
 INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner, Extern *fn_pointer, Node *argv ){
 	int 	  i, argc;
 	Object 	  *value;
-	ll_item_t *iitem;
 
 	/*
 	 * Check for heavy recursions and/or nested calss.
@@ -727,8 +1180,8 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 	vm_add_frame( vm, &stack );
 	stack.push( (Object *)fn_pointer );
 	argc = argv->children.items;
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, root, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, root, argv->child(i) );
 		value->referenced = true;
 
 		if( root->state.is(Exception) ){
@@ -742,7 +1195,6 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string owner, Node *argv ){
 	int 	  i, argc;
 	Object 	  *value;
-	ll_item_t *iitem;
 
 	/*
 	 * Check for heavy recursions and/or nested calls.
@@ -759,8 +1211,8 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 	 */
 	vm_add_frame( vm, &stack );
 	argc = argv->children.items;
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, root, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, root, argv->child(i) );
 		value->referenced = true;
 
 		if( root->state.is(Exception) ){
@@ -771,22 +1223,10 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vframe_t &stack, string
 	}
 }
 
-INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vm_function_t *function, vframe_t &stack, string owner, Node *argv ){
-	int 	i, argc, f_argc, t;
-	ll_item_t *iitem;
-	Object *value;
-	H_OBJECT_TYPE type;
-	/*
-	 * Check for heavy recursions and/or nested calls.
-	 */
-	if( vm_scope_size(vm) >= VM_MAX_RECURSION ){
-		hyb_error( H_ET_GENERIC, "Reached max number of nested calls" );
-	}
+bool vm_check_argc( vm_function_t *function, int argc, int& f_argc, string& error ){
+	int  i;
+	char message[0xFF] = {0};
 
-	/*
-	 * First of all, check that the arguments number is the right one.
-	 */
-	argc = argv->children.items;
 	for( i = 0 ;; ++i ){
 		f_argc = function->argc[i];
 		if( f_argc < 0 ){
@@ -803,12 +1243,78 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vm_function_t *function,
 	 * is wrong.
 	 */
 	if( f_argc == -1 && i != 0 ){
-		hyb_error( H_ET_SYNTAX, "Function '%s' requires %s%d argument%s, %d given",
-							    function->identifier.c_str(),
-							    function->argc[1] >= 0 ? "at least " : "",
-							    function->argc[0],
-							    function->argc[0] > 1  ? "s" : "",
-							    argc );
+		snprintf( message, sizeof(message), "Function '%s' requires %s%d argument%s, %d given",
+										    function->identifier.c_str(),
+										    function->argc[1] >= 0 ? "at least " : "",
+										    function->argc[0],
+										    function->argc[0] > 1  ? "s" : "",
+										    argc );
+		error = message;
+
+		return false;
+	}
+
+	return true;
+}
+
+bool vm_check_argv( vm_function_t *function, int f_argc, int i, Object *value, string& error ){
+	ulong mask;
+	int   t;
+
+	if( f_argc != -1 && i < f_argc && (size_t)i < function->types.size() ){
+		mask = function->types[i];
+		/*
+		 * A zero mask means H_ANY_TYPE, otherwise report an error
+		 * if the type of the value is not in it.
+		 */
+		if( mask != 0 && (mask & H_TYPE_BIT(value->type->code)) == 0 ){
+			std::stringstream message;
+			size_t 			  n_types(0), n;
+
+			for( t = otBoolean; t < H_OBJECT_TYPES; ++t ){
+				n_types += ((mask & H_TYPE_BIT(t)) != 0);
+			}
+
+			message << "Invalid " << ob_typename(value)
+					<< " type for argument " << i + 1
+					<< " of '"
+					<< function->identifier.c_str()
+					<< "' function, required type"
+					<< (n_types > 1 ? "s are " : " is ");
+
+			for( t = otBoolean, n = 0; t < H_OBJECT_TYPES; ++t ){
+				if( mask & H_TYPE_BIT(t) ){
+					++n;
+					message << ob_type_to_string( (H_OBJECT_TYPE)t ) << ( n == n_types ? "" : (n == n_types - 1 ? " or " : ", ") );
+				}
+			}
+
+			error = message.str();
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vm_function_t *function, vframe_t &stack, string owner, Node *argv ){
+	int 	i, argc, f_argc;
+	Object *value;
+	string  error;
+	/*
+	 * Check for heavy recursions and/or nested calls.
+	 */
+	if( vm_scope_size(vm) >= VM_MAX_RECURSION ){
+		hyb_error( H_ET_GENERIC, "Reached max number of nested calls" );
+	}
+
+	/*
+	 * First of all, check that the arguments number is the right one.
+	 */
+	argc = argv->children.items;
+	if( vm_check_argc( function, argc, f_argc, error ) == false ){
+		hyb_error( H_ET_SYNTAX, "%s", error.c_str() );
 	}
 
 	stack.owner = owner;
@@ -820,8 +1326,8 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vm_function_t *function,
 	 * Ok, argc is the right one (or one of the right ones), now evaluate each
 	 * object and check the type.
 	 */
-	ll_foreach_to( &argv->children, iitem, i, argc ){
-		value = vm_exec( vm, root, ll_node( iitem ) );
+	for( i = 0; i < argc; ++i ){
+		value = vm_exec( vm, root, argv->child(i) );
 		value->referenced = true;
 
 		if( root->state.is(Exception) ){
@@ -829,41 +1335,8 @@ INLINE void vm_prepare_stack( vm_t *vm, vframe_t *root, vm_function_t *function,
 			return;
 	    }
 
-		if( f_argc != -1 && i < f_argc ){
-			for( t = 0 ;; ++t ){
-				type = function->types[i][t];
-				if( type <= otVoid ){
-					break;
-				}
-				else if( value->type->code == type ){
-					break;
-				}
-			}
-			/*
-			 * Same as before, check if H_ANY_TYPE given or report error.
-			 */
-			if( type <= otVoid && t != 0 ){
-				std::stringstream error;
-
-				error << "Invalid " << ob_typename(value)
-					  << " type for argument " << i + 1
-					  << " of '"
-					  << function->identifier.c_str()
-					  << "' function, required type"
-					  << (function->types[i][1] > 0 ? "s are " : " is ");
-
-				for( t = 0 ;; ++t ){
-					type = function->types[i][t];
-					if( type <= otVoid ){
-						break;
-					}
-					bool prev_last = ( function->types[i][t + 2] <= otVoid );
-					bool last      = ( function->types[i][t + 1] <= otVoid );
-					error << ob_type_to_string(type) << ( last ? "" : (prev_last ? " or " : ", ") );
-				}
-
-				hyb_error( H_ET_SYNTAX, error.str().c_str() );
-			}
+		if( vm_check_argv( function, f_argc, i, value, error ) == false ){
+			hyb_error( H_ET_SYNTAX, "%s", error.c_str() );
 		}
 
 		stack.push( value );
@@ -875,7 +1348,7 @@ INLINE void vm_dismiss_stack( vm_t *vm ){
 }
 
 INLINE Node * vm_find_function( vm_t *vm, vframe_t *frame, Node *call ){
-    char *callname = (char *)call->value.call.c_str();
+    char *callname = (char *)call->value.identifier.c_str();
 
     /* search first in the code segment */
 	Node *function = H_UNDEFINED;
@@ -1187,18 +1660,23 @@ INLINE Object *vm_exec_identifier( vm_t *vm, vframe_t *frame, Node *node ){
     Object *o = H_UNDEFINED;
     Node   *function   = H_UNDEFINED;
     char   *identifier = node->id();
+    /*
+     * The identifier could be looked up in up to five segments,
+     * hash it just once.
+     */
+    unsigned int hash  = vmem_t::hash(identifier);
 
     /*
    	 * First thing first, check for a constant object name.
    	 */
-   	if( (o = vm->vconst.get(identifier)) != H_UNDEFINED ){
+   	if( (o = vm->vconst.get( identifier, hash )) != H_UNDEFINED ){
    		return o;
    	}
    	/*
 	 * Search for the identifier definition on
 	 * the function local stack frame.
 	 */
-   	else if( (o = frame->get(identifier)) != H_UNDEFINED ){
+   	else if( (o = frame->get( identifier, hash )) != H_UNDEFINED ){
 		return o;
 	}
 	/*
@@ -1206,20 +1684,26 @@ INLINE Object *vm_exec_identifier( vm_t *vm, vframe_t *frame, Node *node ){
 	 * global frame one, in that case try to search the definition
 	 * on the global frame too.
 	 */
-	else if( H_ADDRESS_OF(frame) != H_ADDRESS_OF(&vm->vmem) && (o = vm->vmem.get( identifier )) != H_UNDEFINED ){
+	else if( H_ADDRESS_OF(frame) != H_ADDRESS_OF(&vm->vmem) && (o = vm->vmem.get( identifier, hash )) != H_UNDEFINED ){
 		return o;
 	}
 	/*
 	 * Check for an user defined object (structure or class) name.
 	 */
-	else if( (o = vm->vtypes.get(identifier)) != H_UNDEFINED ){
+	else if( (o = vm->vtypes.get( identifier, hash )) != H_UNDEFINED ){
+		return o;
+	}
+	/*
+	 * Or a constant of a module that is not loaded yet.
+	 */
+	else if( vm_lazy_load( vm, identifier ) && (o = vm->vtypes.get( identifier, hash )) != H_UNDEFINED ){
 		return o;
 	}
 	/*
 	 * So, it's neither defined on local frame nor in the global one,
 	 * let's search for it in the vm->vcode frame.
 	 */
-	else if( (function = vm->vcode.find( identifier )) != H_UNDEFINED ){
+	else if( (function = vm->vcode.find( identifier, hash )) != H_UNDEFINED ){
 		/*
 		 * Create an alias to that vm->vcode region (basically its index).
 		 */
@@ -1243,15 +1727,13 @@ INLINE Object *vm_exec_identifier( vm_t *vm, vframe_t *frame, Node *node ){
 	}
 }
 
-INLINE Object *vm_exec_attribute_request( vm_t *vm, vframe_t *frame, Node *node ){
-	Object  *cobj      = H_UNDEFINED,
-		    *attribute = H_UNDEFINED;
+INLINE Object *vm_get_attribute( Object *cobj, Node *node ){
+	Object  *attribute = H_UNDEFINED;
 	char    *name,
 			*owner_id;
 	access_t access;
 	Node    *member = node->value.member;
 
-	cobj      = vm_exec( vm, frame, node->value.owner );
 	owner_id  = (char *)node->value.owner->id();
 	name      = (char *)member->id();
 	attribute = ob_get_attribute( cobj, name, true );
@@ -1288,15 +1770,51 @@ INLINE Object *vm_exec_attribute_request( vm_t *vm, vframe_t *frame, Node *node
 	return attribute;
 }
 
+INLINE Object *vm_exec_attribute_request( vm_t *vm, vframe_t *frame, Node *node ){
+	return vm_get_attribute( vm_exec( vm, frame, node->value.owner ), node );
+}
+
+Object *vm_exec_lvalue( vm_t *vm, vframe_t *frame, Node *node ){
+	/*
+	 * array[index], the array could share its items with a copy on
+	 * write clone, so it has to own them before handing one out.
+	 */
+	if( node->type == H_NT_EXPRESSION && node->opcode == T_SUBSCRIPTGET && node->children.items == 2 ){
+		Object *array = H_UNDEFINED,
+			   *index = H_UNDEFINED;
+
+		array = vm_exec_lvalue( vm, frame, node->child(0) );
+		index = vm_exec( vm, frame, node->child(1) );
+
+		vm_check_frame_exit(frame)
+
+		ob_unshare(array);
+
+		return ob_cl_at( array, index );
+	}
+	/*
+	 * owner.attribute, the owner itself could be an array item.
+	 */
+	else if( node->type == H_NT_ATTRIBUTE ){
+		Object *cobj = vm_exec_lvalue( vm, frame, node->value.owner );
+
+		vm_check_frame_exit(frame)
+
+		return vm_get_attribute( cobj, node );
+	}
+
+	return vm_exec( vm, frame, node );
+}
+
 INLINE Object *vm_exec_method_call( vm_t *vm, vframe_t *frame, Node *node ){
 	Object  *cobj   = H_UNDEFINED;
 	char    *name,
 			*owner_id;
 	Node    *member = node->value.member;
 
-	cobj 	 = vm_exec( vm, frame, node->value.owner );
+	cobj 	 = vm_exec_lvalue( vm, frame, node->value.owner );
 	owner_id = node->value.owner->id();
-	name 	 = (char *)member->value.call.c_str();
+	name 	 = (char *)member->value.identifier.c_str();
 
 	return ob_call_method( vm, frame, cobj, owner_id, name, member );
 }
@@ -1316,7 +1834,7 @@ INLINE Object *vm_exec_constant( vm_t *vm, vframe_t *frame, Node *node ){
 }
 
 INLINE Object *vm_exec_function_declaration( vm_t *vm, vframe_t *frame, Node *node ){
-    char *function_name = (char *)node->value.function.c_str();
+    char *function_name = (char *)node->value.identifier.c_str();
 
     /* check for double definition */
     if( vm->vcode.get(function_name) != H_UNDEFINED ){
@@ -1341,8 +1859,8 @@ INLINE Object *vm_exec_structure_declaration( vm_t *vm, vframe_t *frame, Node *
 
 	/* structure prototypes are not garbage collected */
     Object *s = (Object *)(new Structure());
-    ll_foreach( &node->children, llitem ){
-    	attribute = ll_node(llitem);
+    for( size_t ci = 0; ci < node->children.items; ++ci ){
+    	attribute = node->child(ci);
     	ob_define_attribute( s, attribute->id(), asPublic, false );
     }
 
@@ -1374,8 +1892,8 @@ INLINE Object *vm_exec_class_declaration( vm_t *vm, vframe_t *frame, Node *node
 	 */
 	((Class *)c)->name = classname;
 
-	ll_foreach( &node->children, llitem ){
-		declchild = ll_node( llitem );
+	for( size_t ci = 0; ci < node->children.items; ++ci ){
+		declchild = node->child(ci);
 		/*
 		 * Define an attribute
 		 */
@@ -1413,7 +1931,7 @@ INLINE Object *vm_exec_class_declaration( vm_t *vm, vframe_t *frame, Node *node
 		 * Define a method
 		 */
 		else if( declchild->type == H_NT_METHOD_DECL ){
-			ob_define_method( c, (char *)declchild->value.method.c_str(), declchild );
+			ob_define_method( c, (char *)declchild->value.identifier.c_str(), declchild );
 		}
 		/*
 		 * WTF this should not happen!
@@ -1460,14 +1978,21 @@ INLINE Object *vm_exec_class_declaration( vm_t *vm, vframe_t *frame, Node *node
 				}
 			}
 
-			itree_foreach( class_method_t, mi, cobj->c_methods ){
-				vv_foreach( vector<Node *>, pi, (*mi)->value->prototypes ){
-					ob_define_method( c, (char *)(*mi)->label.c_str(), *pi );
+			if( cobj->c_methods != NULL ){
+				itree_foreach( class_method_t, mi, *cobj->c_methods ){
+					vv_foreach( vector<Node *>, pi, (*mi)->value->prototypes ){
+						ob_define_method( c, (char *)(*mi)->label.c_str(), *pi );
+					}
 				}
 			}
 		}
 	}
 
+	/*
+	 * Now that every attribute and method (inherited ones too) is
+	 * defined, build the recipe the new operator will use.
+	 */
+	class_build_recipe( c );
 	/*
 	 * ::defineType will take care of the class attributes
 	 * to prevent it to be garbage collected (see ::onConstant).
@@ -1476,7 +2001,7 @@ INLINE Object *vm_exec_class_declaration( vm_t *vm, vframe_t *frame, Node *node
 }
 
 INLINE Object *vm_exec_builtin_function_call( vm_t *vm, vframe_t *frame, Node * call ){
-    char        *callname = (char *)call->value.call.c_str();
+    char        *callname = (char *)call->value.identifier.c_str();
     vm_function_t* function;
     vframe_t     stack;
     Object      *result = H_UNDEFINED;
@@ -1518,8 +2043,8 @@ Object *vm_exec_threaded_call( vm_t *vm, string function_name, vmem_t *argv ){
 		hyb_error( H_ET_SYNTAX, "'%s' undeclared user function identifier", function_name.c_str() );
 	}
 
-	ll_foreach( &function->children, llitem ){
-		body = ll_node( llitem );
+	for( size_t ci = 0; ci < function->children.items; ++ci ){
+		body = function->child(ci);
     	if( body->type == H_NT_IDENTIFIER ){
     		identifiers.push_back( body->value.identifier );
     	}
@@ -1530,19 +2055,19 @@ Object *vm_exec_threaded_call( vm_t *vm, string function_name, vmem_t *argv ){
 
 
     if( function->value.vargs ){
-    	if( argv->size() < identifiers.size() ){
+    	if( argv->argc() < identifiers.size() ){
 			hyb_error( H_ET_SYNTAX, "function '%s' requires at least %d parameters (called with %d)",
 									function_name.c_str(),
 									identifiers.size(),
-									argv->size() );
+									argv->argc() );
     	}
     }
     else{
-    	if( identifiers.size() != argv->size() ){
+    	if( identifiers.size() != argv->argc() ){
 			hyb_error( H_ET_SYNTAX, "function '%s' requires %d parameters (called with %d)",
 								   function_name.c_str(),
 								   identifiers.size(),
-								   argv->size() );
+								   argv->argc() );
     	}
 	}
 
@@ -1563,8 +2088,8 @@ Object *vm_exec_threaded_call( vm_t *vm, Node *function, vframe_t *frame, vmem_t
 	Node    *body   = H_UNDEFINED;
 	vector<string> identifiers;
 
-	ll_foreach( &function->children, llitem ){
-		body = ll_node( llitem );
+	for( size_t ci = 0; ci < function->children.items; ++ci ){
+		body = function->child(ci);
     	if( body->type == H_NT_IDENTIFIER ){
     		identifiers.push_back( body->value.identifier );
     	}
@@ -1573,14 +2098,14 @@ Object *vm_exec_threaded_call( vm_t *vm, Node *function, vframe_t *frame, vmem_t
     	}
 	}
 
-	if( identifiers.size() != argv->size() ){
+	if( identifiers.size() != argv->argc() ){
 		hyb_error( H_ET_SYNTAX, "function '%s' requires %d parameters (called with %d)",
-							    function->value.function.c_str(),
+							    function->value.identifier.c_str(),
 							    identifiers.size(),
-							    argv->size() );
+							    argv->argc() );
 	}
 
-	vm_prepare_stack( vm, stack, function->value.function, identifiers, argv );
+	vm_prepare_stack( vm, stack, function->value.identifier, identifiers, argv );
 
 	vm_check_frame_exit(frame);
 
@@ -1601,68 +2126,135 @@ Object *vm_exec_threaded_call( vm_t *vm, Node *function, vframe_t *frame, vmem_t
 	return result;
 }
 
-INLINE Object *vm_exec_user_function_call( vm_t *vm, vframe_t *frame, Node *call ){
-    Node    *function = H_UNDEFINED;
-    vframe_t stack;
-    Object  *result   = H_UNDEFINED;
-    Node    *body     = H_UNDEFINED;
+Object *vm_exec_function( vm_t *vm, vframe_t *frame, FunctionNode *function, vmem_t *argv ){
+	vframe_t *stack  = H_UNDEFINED;
+	Object   *result = H_UNDEFINED,
+			 *value;
+	size_t    i, n_ids( function->params.size() ), argc( argv->argc() );
+
+	if( vm_scope_size(vm) >= VM_MAX_RECURSION ){
+		hyb_error( H_ET_GENERIC, "Reached max number of nested calls" );
+	}
 
-    vector<string> identifiers;
+	stack = vm_frame_acquire( function->frame_size );
 
-    if( (function = vm_find_function( vm, frame, call )) == H_UNDEFINED ){
-        return H_UNDEFINED;
-    }
+	stack->owner = function->value.identifier;
 
-    size_t 	   i(0),
-			   argc( function->value.argc );
-    ll_item_t *iitem;
-    Node	  *idnode;
+	vm_add_frame( vm, stack );
 
-    ll_foreach_to( &function->children, iitem, i, argc ){
-    	idnode = ll_node( iitem );
-    	identifiers.push_back( idnode->value.identifier );
-    }
+	for( i = 0; i < argc; ++i ){
+		value = argv->argv(i);
+		value->referenced = true;
+
+		if( i >= n_ids ){
+			stack->push( value );
+		}
+		else{
+			stack->insert( function->params[i], value );
+		}
+	}
+
+	stack->tail_calls = true;
+
+	for(;;){
+		result = vm_exec( vm, stack, function->body );
+
+		if( stack->tail_function == H_UNDEFINED || stack->state.is(Exception) ){
+			break;
+		}
+
+		function = (FunctionNode *)stack->tail_function;
+
+		vm_prepare_tail_stack( stack );
+	}
+
+	vm_dismiss_stack( vm );
+
+	if( stack->state.is(Exception) ){
+		frame->state.set( Exception, stack->state.e_value );
+	}
+
+	vm_frame_release( stack );
+
+	return (result == H_UNDEFINED ? H_DEFAULT_RETURN : result);
+}
+
+INLINE void vm_check_function_argc( FunctionNode *function, Node *call ){
+	size_t argc( function->params.size() );
 
     if( function->value.vargs ){
-    	if( call->children.items < identifiers.size() ){
+    	if( call->children.items < argc ){
    			hyb_error( H_ET_SYNTAX, "function '%s' requires at least %d parameters (called with %d)",
-									function->value.function.c_str(),
-   									identifiers.size(),
+									function->value.identifier.c_str(),
+   									argc,
    									call->children.items );
        }
    	}
     else{
-		if( identifiers.size() != call->children.items ){
+		if( argc != call->children.items ){
 			hyb_error( H_ET_SYNTAX, "function '%s' requires %d parameters (called with %d)",
-									function->value.function.c_str(),
-									identifiers.size(),
+									function->value.identifier.c_str(),
+									argc,
 									call->children.items );
 		}
     }
+}
 
-    vm_prepare_stack( vm, frame, stack, function->value.function, identifiers, call );
+INLINE Object *vm_exec_user_function_call( vm_t *vm, vframe_t *frame, Node *call ){
+    FunctionNode *function = H_UNDEFINED;
+    vframe_t     *stack    = H_UNDEFINED;
+    Object       *result   = H_UNDEFINED;
 
-    vm_check_frame_exit(frame);
+    if( (function = (FunctionNode *)vm_find_function( vm, frame, call )) == H_UNDEFINED ){
+        return H_UNDEFINED;
+    }
 
-    /* call the function */
-    result = vm_exec( vm, &stack, function->body );
+    vm_check_function_argc( function, call );
+
+    stack = vm_frame_acquire( function->frame_size );
+
+    vm_prepare_stack( vm, frame, *stack, function, call );
+
+    if( frame->state.is(Exception) || frame->state.is(Return) ){
+    	vm_frame_release( stack );
+    	vm_check_frame_exit(frame);
+    }
+
+    stack->tail_calls = true;
+
+    for(;;){
+		/* call the function */
+		result = vm_exec( vm, stack, function->body );
+		/*
+		 * The function ended with a 'return f(...)', run f on this same
+		 * frame instead of nesting its call (see vm_exec_return).
+		 */
+		if( stack->tail_function == H_UNDEFINED || stack->state.is(Exception) ){
+			break;
+		}
+
+		function = (FunctionNode *)stack->tail_function;
+
+		vm_prepare_tail_stack( stack );
+    }
 
     vm_dismiss_stack( vm );
 	/*
 	 * Check for unhandled exceptions and put them on the root
 	 * memory frame.
 	 */
-	if( stack.state.is(Exception) ){
-		frame->state.set( Exception, stack.state.e_value );
+	if( stack->state.is(Exception) ){
+		frame->state.set( Exception, stack->state.e_value );
 	}
 
+	vm_frame_release( stack );
+
     /* return function evaluation value */
     return (result == H_UNDEFINED ? H_DEFAULT_RETURN : result);
 }
 
 INLINE Object *vm_exec_new_operator( vm_t *vm, vframe_t *frame, Node *type ){
     char      *type_name = type->id();
-    ll_item_t *llitem;
     Object    *user_type = H_UNDEFINED,
               *newtype   = H_UNDEFINED,
               *object    = H_UNDEFINED;
@@ -1676,9 +2268,9 @@ INLINE Object *vm_exec_new_operator( vm_t *vm, vframe_t *frame, Node *type ){
     	hyb_error( H_ET_SYNTAX, "'%s' undeclared type", type_name );
     }
     /*
-     * Clone the object prototype.
+     * Instantiate the class or clone the structure prototype.
      */
-    newtype = ob_clone(user_type);
+    newtype = (ob_is_class(user_type) ? class_new_instance(user_type) : ob_clone(user_type));
 	/*
 	 * It's ok to initialize less attributes that the structure/class
 	 * has (non ini'ed attributes are set to 0 by default), but
@@ -1694,10 +2286,10 @@ INLINE Object *vm_exec_new_operator( vm_t *vm, vframe_t *frame, Node *type ){
 								 children );
 		}
 
-		frame->push_tmp(newtype);
+		size_t root = frame->push_tmp(newtype);
 
-		ll_foreach_to( &type->children, llitem, i, children ){
-			object = vm_exec( vm, frame, ll_node( llitem ) );
+		for( i = 0; i < children; ++i ){
+			object = vm_exec( vm, frame, type->child(i) );
 
 			if( object->referenced ){
 				ob_set_attribute( newtype, (char *)stype->s_attributes.label(i), object );
@@ -1708,7 +2300,7 @@ INLINE Object *vm_exec_new_operator( vm_t *vm, vframe_t *frame, Node *type ){
 			}
 		}
 
-		frame->remove_tmp(newtype);
+		frame->pop_tmp(root);
 	}
 	else if( ob_is_class(newtype) ){
 		/*
@@ -1741,7 +2333,7 @@ INLINE Object *vm_exec_new_operator( vm_t *vm, vframe_t *frame, Node *type ){
 
 			vframe_t stack;
 
-			frame->push_tmp(newtype);
+			size_t root = frame->push_tmp(newtype);
 
 			vm_prepare_stack( vm,
 							  frame,
@@ -1752,9 +2344,9 @@ INLINE Object *vm_exec_new_operator( vm_t *vm, vframe_t *frame, Node *type ){
 							  ctor,
 							  type );
 
-			vm_check_frame_exit(frame);
+			frame->pop_tmp(root);
 
-			frame->remove_tmp(newtype);
+			vm_check_frame_exit(frame);
 
 			/* call the ctor */
 			vm_exec( vm, &stack, ctor->body );
@@ -1775,7 +2367,7 @@ INLINE Object *vm_exec_new_operator( vm_t *vm, vframe_t *frame, Node *type ){
 }
 
 INLINE Object *vm_exec_dll_function_call( vm_t *vm, vframe_t *frame, Node *call ){
-    char    *callname   = (char *)call->value.call.c_str();
+    char    *callname   = (char *)call->value.identifier.c_str();
     vframe_t stack;
     Object  *result     = H_UNDEFINED,
             *fn_pointer = H_UNDEFINED;
@@ -1822,7 +2414,7 @@ Object *vm_exec_function_call( vm_t *vm, vframe_t *frame, Node *call ){
     	return result;
     }
     else{
-    	hyb_error( H_ET_SYNTAX, "'%s' undeclared function identifier", call->value.call.c_str() );
+    	hyb_error( H_ET_SYNTAX, "'%s' undeclared function identifier", call->value.identifier.c_str() );
     }
 
     return result;
@@ -1831,7 +2423,7 @@ Object *vm_exec_function_call( vm_t *vm, vframe_t *frame, Node *call ){
 INLINE Object *vm_exec_reference( vm_t *vm, vframe_t *frame, Node *node ){
     Object *o = H_UNDEFINED;
 
-    o = vm_exec( vm, frame, node->child(0) );
+    o = vm_exec_lvalue( vm, frame, node->child(0) );
 
     o->referenced = true;
 
@@ -1872,7 +2464,7 @@ INLINE Object *vm_exec_dollar( vm_t *vm, vframe_t *frame, Node *node ){
 	/*
 	 * Check for an user defined object (structure or class) name.
 	 */
-	else if( (o = vm->vtypes.get(identifier)) != H_UNDEFINED ){
+	else if( (o = vm_get_type( vm, identifier )) != H_UNDEFINED ){
 		return o;
 	}
 	/*
@@ -1890,12 +2482,61 @@ INLINE Object *vm_exec_dollar( vm_t *vm, vframe_t *frame, Node *node ){
 	}
 }
 
+/*
+ * Evaluate the arguments of 'call' and store them as the pending tail
+ * call of 'frame' if the call is to an user defined function, return
+ * false if it's not so it has to be executed normally.
+ */
+INLINE bool vm_exec_tail_call( vm_t *vm, vframe_t *frame, Node *call ){
+	char 		 *callname = (char *)call->value.identifier.c_str();
+	FunctionNode *function;
+	Object 		 *value;
+
+	/*
+	 * Builtin functions have the precedence over user defined ones.
+	 */
+	if( vm_get_function( vm, callname ) != H_UNDEFINED ){
+		return false;
+	}
+	else if( (function = (FunctionNode *)vm->vcode.get(callname)) == H_UNDEFINED ){
+		return false;
+	}
+
+	vm_check_function_argc( function, call );
+
+	frame->tail_args.clear();
+	for( size_t ci = 0; ci < call->children.items; ++ci ){
+		value = vm_exec( vm, frame, call->child(ci) );
+		if( frame->state.is(Exception) ){
+			frame->tail_args.clear();
+			return true;
+		}
+		value->referenced = true;
+
+		frame->tail_args.push_back( value );
+	}
+
+	frame->tail_function = function;
+
+	return true;
+}
+
 INLINE Object *vm_exec_return( vm_t *vm, vframe_t *frame, Node *node ){
+	Node *value = node->child(0);
+	/*
+	 * A 'return f(...)' on a frame that allows tail calls, the
+	 * call will be executed by the caller reusing this frame.
+	 */
+	if( frame->tail_calls && value->type == H_NT_CALL && vm_exec_tail_call( vm, frame, value ) ){
+		frame->state.r_value = (frame->state.is(Exception) ? frame->state.e_value : H_DEFAULT_RETURN);
+	}
+	else{
+		frame->state.r_value = vm_exec( vm, frame, value );
+	}
 	/*
 	 * Set break and return state to make every loop and/or condition
 	 * statement to exit with this return value.
 	 */
-    frame->state.r_value = vm_exec( vm, frame, node->child(0) );
     frame->state.set( Break );
     frame->state.set( Return );
 
@@ -1933,6 +2574,14 @@ INLINE Object *vm_exec_vargs( vm_t *vm, vframe_t *frame, Node *node ){
 			ob_cl_push( vargs, frame->at(i) );
 		}
 	}
+	/*
+	 * Arguments exceeding the declared ones.
+	 */
+	argc = frame->argc();
+	for( i = 0; i < argc; ++i ){
+		frame->argv(i)->referenced = true;
+		ob_cl_push( vargs, frame->argv(i) );
+	}
 
 	return vargs;
 }
@@ -1957,7 +2606,7 @@ INLINE Object *vm_exec_subscript_push( vm_t *vm, vframe_t *frame, Node *node ){
            *object = H_UNDEFINED,
            *res    = H_UNDEFINED;
 
-    array  = vm_exec( vm, frame, node->child(0) );
+    array  = vm_exec_lvalue( vm, frame, node->child(0) );
 	object = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2009,7 +2658,7 @@ INLINE Object *vm_exec_subscript_set( vm_t *vm, vframe_t *frame, Node *node ){
            *index  = H_UNDEFINED,
            *object = H_UNDEFINED;
 
-    array  = vm_exec( vm, frame, node->child(0) );
+    array  = vm_exec_lvalue( vm, frame, node->child(0) );
    	index  = vm_exec( vm, frame, node->child(1) );
    	object = vm_exec( vm, frame, node->child(2) );
 
@@ -2105,18 +2754,308 @@ INLINE Object *vm_exec_for( vm_t *vm, vframe_t *frame, Node *node ){
     return result;
 }
 
+INLINE Object *vm_exec_foreach_range( vm_t *vm, vframe_t *frame, Node *node, Object *from, Object *to ){
+	long    i, start, end;
+	bool    is_char = ob_is_char(from);
+	Node   *body;
+	Object *result = H_UNDEFINED;
+	char   *identifier;
+
+	identifier = node->child(0)->id();
+	body       = node->child(2);
+	/*
+	 * Same bounds ob_range would use, ranges are always ascending.
+	 */
+	if( ob_cmp( from, to ) == -1 ){
+		start = ob_ivalue(from);
+		end   = ob_ivalue(to);
+	}
+	else{
+		start = ob_ivalue(to);
+		end   = ob_ivalue(from);
+	}
+
+	/*
+	 * The loop is left once 'end' is done instead of testing i <= end,
+	 * which would overflow i when 'end' is LONG_MAX.
+	 */
+	for( i = start ;; ++i ){
+		/*
+		 * A brand new object for each iteration, so the previous one can be
+		 * collected and any reference to it taken inside the body is still
+		 * valid, but no whole range vector is ever built.
+		 */
+		frame->add( identifier, is_char ? ob_dcast( gc_new_char(i) ) : ob_dcast( gc_new_integer(i) ) );
+
+		result = vm_exec( vm, frame, body );
+
+		if( frame->state.is(Exception) ){
+			result = frame->state.e_value;
+			break;
+		}
+		else if( frame->state.is(Return) ){
+			result = frame->state.r_value;
+			break;
+		}
+		else if( frame->state.is(Break) ){
+			frame->state.unset(Break);
+			break;
+		}
+		frame->state.unset(Next);
+
+		if( i == end ){
+			break;
+		}
+	}
+
+	return result;
+}
+
+/*
+ * Walk a foreach body and find out if the loop variables could be bound
+ * directly to the collection items instead of to clones of them.
+ *
+ * This is possible only if the body never writes the loop variables (assignments,
+ * in place operators, subscript or attribute setting, references, method calls,
+ * explode or catch statements, nested loops using the same identifiers) and
+ * it does not write anything else but plain identifiers or call user code,
+ * which could change or free the items of the collection while they're bound.
+ */
+static bool vm_foreach_writes( vm_t *vm, Node *node, char *key_identifier, char *value_identifier );
+
+INLINE bool vm_foreach_is_loop_var( Node *node, char *key_identifier, char *value_identifier ){
+	/*
+	 * Get the root identifier of expressions like a.b.c or a[0][1].
+	 */
+	while( node ){
+		if( node->type == H_NT_ATTRIBUTE || node->type == H_NT_METHOD_CALL ){
+			node = node->value.owner;
+		}
+		else if( node->type == H_NT_EXPRESSION && node->opcode == T_SUBSCRIPTGET ){
+			node = node->child(0);
+		}
+		else{
+			break;
+		}
+	}
+
+	return node &&
+		   node->type == H_NT_IDENTIFIER &&
+		   ( strcmp( node->id(), value_identifier ) == 0 ||
+		     (key_identifier && strcmp( node->id(), key_identifier ) == 0) );
+}
+
+static bool vm_foreach_writes( vm_t *vm, Node *node, char *key_identifier, char *value_identifier ){
+	if( node == NULL ){
+		return false;
+	}
+
+	switch( node->type ){
+		/*
+		 * Declarations have their own scope.
+		 */
+		case H_NT_FUNCTION :
+		case H_NT_STRUCT   :
+		case H_NT_CLASS    :
+		case H_NT_METHOD_DECL :
+			return false;
+		/*
+		 * new could execute a constructor and methods could do anything
+		 * with their owner.
+		 */
+		case H_NT_NEW :
+		case H_NT_METHOD_CALL :
+			return true;
+		/*
+		 * Builtin functions receive their arguments without clones anyway,
+		 * user functions could change globals.
+		 * Functions of modules not loaded yet are recognized by the lazy
+		 * index, the call could never be executed so don't load them here.
+		 */
+		case H_NT_CALL :
+			if( node->value.alias ){
+				return true;
+			}
+			else{
+				char *callname = (char *)node->value.identifier.c_str();
+
+				if( vm_find_function( vm, callname ) == H_UNDEFINED && vm->lazy.find(callname) == H_UNDEFINED ){
+					return true;
+				}
+			}
+		break;
+
+		case H_NT_ATTRIBUTE :
+			return vm_foreach_writes( vm, node->value.owner, key_identifier, value_identifier );
+
+		case H_NT_EXPRESSION :
+			switch( node->opcode ){
+				case T_DOLLAR :
+					return true;
+
+				case T_ASSIGN :
+					if( node->child(0)->type != H_NT_IDENTIFIER || vm_foreach_is_loop_var( node->child(0), key_identifier, value_identifier ) ){
+						return true;
+					}
+				break;
+
+				case T_PLUSE :
+				case T_MINUSE :
+				case T_MULE :
+				case T_DIVE :
+				case T_MODE :
+				case T_XORE :
+				case T_ANDE :
+				case T_ORE :
+				case T_SHIFTLE :
+				case T_SHIFTRE :
+				case T_INC :
+				case T_DEC :
+				case T_SUBSCRIPTADD :
+				case T_REF :
+					if( node->child(0)->type != H_NT_IDENTIFIER || vm_foreach_is_loop_var( node->child(0), key_identifier, value_identifier ) ){
+						return true;
+					}
+				break;
+
+				case T_SUBSCRIPTSET :
+					return true;
+			}
+		break;
+
+		case H_NT_STATEMENT :
+			switch( node->opcode ){
+				case T_EXPLODE :
+					return true;
+
+				case T_FOREACH :
+				case T_FOREACHM :
+					if( vm_foreach_is_loop_var( node->child(0), key_identifier, value_identifier ) ||
+						(node->opcode == T_FOREACHM && vm_foreach_is_loop_var( node->child(1), key_identifier, value_identifier )) ){
+						return true;
+					}
+				break;
+
+				case T_TRY :
+					if( strcmp( node->value.identifier.c_str(), value_identifier ) == 0 ||
+						(key_identifier && strcmp( node->value.identifier.c_str(), key_identifier ) == 0) ){
+						return true;
+					}
+					return vm_foreach_writes( vm, node->value.try_block, key_identifier, value_identifier ) ||
+						   vm_foreach_writes( vm, node->value.catch_block, key_identifier, value_identifier ) ||
+						   vm_foreach_writes( vm, node->value.finally_block, key_identifier, value_identifier );
+
+				case T_SWITCH :
+					if( vm_foreach_writes( vm, node->value.switch_block, key_identifier, value_identifier ) ||
+						vm_foreach_writes( vm, node->value.default_block, key_identifier, value_identifier ) ){
+						return true;
+					}
+				break;
+			}
+		break;
+	}
+
+	for( size_t ci = 0; ci < node->children.items; ++ci ){
+		if( vm_foreach_writes( vm, node->child(ci), key_identifier, value_identifier ) ){
+			return true;
+		}
+	}
+
+	return false;
+}
+
+INLINE bool vm_foreach_can_bind( vm_t *vm, vframe_t *frame, Node *body, char *key_identifier, char *value_identifier ){
+	Object *prev;
+	/*
+	 * If a loop variable is already defined as a reference, frame->add
+	 * will assign the items to the referenced object, so keep that behaviour.
+	 */
+	if( ( (prev = frame->get(value_identifier)) != H_UNDEFINED && ob_is_reference(prev) ) ||
+		( key_identifier && (prev = frame->get(key_identifier)) != H_UNDEFINED && ob_is_reference(prev) ) ){
+		return false;
+	}
+
+	return !vm_foreach_writes( vm, body, key_identifier, value_identifier );
+}
+/*
+ * Bind a loop variable to an item, return the item if it was bound
+ * without cloning it, otherwise NULL.
+ */
+INLINE Object *vm_foreach_bind( vframe_t *frame, char *identifier, Object *item, bool by_reference ){
+	if( by_reference == false ){
+		frame->add( identifier, item );
+		return H_UNDEFINED;
+	}
+	else if( item->referenced && (item->attributes & H_OA_CONSTANT) != H_OA_CONSTANT ){
+		frame->bind( identifier, item );
+		return item;
+	}
+	/*
+	 * The variable could still be an alias of the previous item, so
+	 * frame->add can't be used here because it would ob_free it while
+	 * it's inside the collection, bind a clone (or the item itself if
+	 * nothing else references it) instead.
+	 */
+	if( item->referenced || (item->attributes & H_OA_CONSTANT) == H_OA_CONSTANT ){
+		item = ob_clone(item);
+	}
+	item->referenced = true;
+
+	frame->bind( identifier, item );
+
+	return H_UNDEFINED;
+}
+/*
+ * Once the loop is over, the variable must not be an alias of the
+ * collection item anymore.
+ */
+INLINE void vm_foreach_unbind( vframe_t *frame, char *identifier, Object *item ){
+	if( item != H_UNDEFINED ){
+		Object *clone = ob_clone(item);
+
+		clone->referenced = true;
+		frame->bind( identifier, clone );
+	}
+}
+
 INLINE Object *vm_exec_foreach( vm_t *vm, vframe_t *frame, Node *node ){
-    int     size;
     Node   *body;
     Object *v      = H_UNDEFINED,
+           *item   = H_UNDEFINED,
+           *bound  = H_UNDEFINED,
            *result = H_UNDEFINED;
     char   *identifier;
-    Integer index(0);
+    bool    by_reference;
+    ob_iterator_t it;
 
     identifier = node->child(0)->id();
-    v          = vm_exec( vm, frame, node->child(1) );
     body       = node->child(2);
-    size       = ob_get_size(v);
+    /*
+     * foreach( i of a..b ) with integer or char bounds, iterate the range
+     * lazily instead of materializing it with ob_range.
+     */
+    if( node->child(1)->type == H_NT_EXPRESSION && node->child(1)->opcode == T_RANGE ){
+    	Object *from = H_UNDEFINED,
+    		   *to   = H_UNDEFINED;
+
+    	from = vm_exec( vm, frame, node->child(1)->child(0) );
+    	to   = vm_exec( vm, frame, node->child(1)->child(1) );
+
+    	vm_check_frame_exit(frame)
+
+    	if( (ob_is_int(from) && ob_is_int(to)) || (ob_is_char(from) && ob_is_char(to)) ){
+    		return vm_exec_foreach_range( vm, frame, node, from, to );
+    	}
+
+    	v = ob_range( from, to );
+    }
+    else{
+    	v = vm_exec( vm, frame, node->child(1) );
+    }
+
+    vm_check_frame_exit(frame)
+
+    by_reference = vm_foreach_can_bind( vm, frame, body, NULL, identifier );
 
     /*
      * Prevent the vector from being garbage collected, because may cause
@@ -2124,10 +3063,27 @@ INLINE Object *vm_exec_foreach( vm_t *vm, vframe_t *frame, Node *node ){
      *
      * 		foreach( i of 1..10 )
      */
-    frame->push_tmp(v);
+    size_t root = frame->push_tmp(v);
+
+    ob_iter_begin( v, &it );
+    /*
+     * The iterator could be a temporary object (references or classes
+     * with an __iter descriptor), protect it too.
+     */
+    if( it.collection != v ){
+    	frame->push_tmp(it.collection);
+    }
+
+    while( ob_iter_next( &it, NULL, &item ) ){
+    	/*
+    	 * Iterators could execute user code (class __next descriptors).
+    	 */
+    	if( frame->state.is(Exception) ){
+    		result = frame->state.e_value;
+    		break;
+    	}
 
-    for( ; index.value < size; ++index.value ){
-        frame->add( identifier, ob_cl_at( v, (Object *)&index ) );
+    	bound  = vm_foreach_bind( frame, identifier, item, by_reference );
 
         result = vm_exec( vm, frame, body );
 
@@ -2146,24 +3102,34 @@ INLINE Object *vm_exec_foreach( vm_t *vm, vframe_t *frame, Node *node ){
 		frame->state.unset(Next);
     }
 
-    frame->remove_tmp(v);
+    vm_foreach_unbind( frame, identifier, bound );
+
+    frame->pop_tmp(root);
 
     return result;
 }
 
 INLINE Object *vm_exec_foreach_mapping( vm_t *vm, vframe_t *frame, Node *node ){
-    int     i, size;
     Node   *body;
-    Object *map    = H_UNDEFINED,
-           *result = H_UNDEFINED;
+    Object *map     = H_UNDEFINED,
+           *key     = H_UNDEFINED,
+           *value   = H_UNDEFINED,
+           *k_bound = H_UNDEFINED,
+           *v_bound = H_UNDEFINED,
+           *result  = H_UNDEFINED;
     char   *key_identifier,
            *value_identifier;
+    bool    by_reference;
+    ob_iterator_t it;
 
     key_identifier   = node->child(0)->id();
     value_identifier = node->child(1)->id();
     map              = vm_exec( vm, frame, node->child(2) );
     body             = node->child(3);
-    size             = ob_get_size(map);
+
+    vm_check_frame_exit(frame)
+
+    by_reference = vm_foreach_can_bind( vm, frame, body, key_identifier, value_identifier );
 
     /*
      * Prevent the map from being garbage collected, because may cause
@@ -2171,11 +3137,25 @@ INLINE Object *vm_exec_foreach_mapping( vm_t *vm, vframe_t *frame, Node *node ){
      *
      * 		foreach( i of map( ... ) )
      */
-    frame->push_tmp(map);
+    size_t root = frame->push_tmp(map);
+
+    ob_iter_begin( map, &it );
+    /*
+     * The iterator could be a temporary object (references or classes
+     * with an __iter descriptor), protect it too.
+     */
+    if( it.collection != map ){
+    	frame->push_tmp(it.collection);
+    }
+
+    while( ob_iter_next( &it, &key, &value ) ){
+    	if( frame->state.is(Exception) ){
+			result = frame->state.e_value;
+			break;
+		}
 
-    for( i = 0; i < size; ++i ){
-        frame->add( key_identifier,   ob_map_ucast(map)->keys[i] );
-        frame->add( value_identifier, ob_map_ucast(map)->values[i] );
+    	k_bound = vm_foreach_bind( frame, key_identifier,   key,   by_reference );
+    	v_bound = vm_foreach_bind( frame, value_identifier, value, by_reference );
 
         result = vm_exec( vm, frame, body );
 
@@ -2194,7 +3174,10 @@ INLINE Object *vm_exec_foreach_mapping( vm_t *vm, vframe_t *frame, Node *node ){
 		frame->state.unset(Next);
     }
 
-    frame->remove_tmp(map);
+    vm_foreach_unbind( frame, key_identifier,   k_bound );
+    vm_foreach_unbind( frame, value_identifier, v_bound );
+
+    frame->pop_tmp(root);
 
     return result;
 }
@@ -2251,33 +3234,168 @@ INLINE Object *vm_exec_question( vm_t *vm, vframe_t *frame, Node *node ){
     return result;
 }
 
+/*
+ * Max number of unused entries per label a switch jump table can have,
+ * sparser integer labels are mapped with a tree.
+ */
+#define VM_SWITCH_MAX_HOLES 4
+/*
+ * Build the lookup table of a switch statement, if any of its labels
+ * is not a constant or labels are of different kinds, the table is
+ * marked as skLinear and labels will be evaluated as usual.
+ */
+INLINE switch_table_t *vm_compile_switch( Node *node ){
+	switch_table_t *table = new switch_table_t;
+	size_t			i;
+	Node    	   *case_node,
+				   *stmt_node;
+	Object		   *label;
+	size_t			n_ints(0),
+					n_strings(0);
+	long			value,
+					min(0),
+					max(0);
+
+	for( i = 0; i < node->children.items; i += 2 ){
+		case_node = node->child(i);
+		stmt_node = node->child(i + 1);
+
+		if( case_node == H_UNDEFINED || stmt_node == H_UNDEFINED ){
+			continue;
+		}
+		else if( case_node->type != H_NT_CONSTANT ){
+			return table;
+		}
+
+		label = case_node->value.constant;
+		if( ob_is_int(label) || ob_is_char(label) ){
+			value = ob_ivalue(label);
+			min   = (n_ints == 0 || value < min ? value : min);
+			max   = (n_ints == 0 || value > max ? value : max);
+			n_ints++;
+		}
+		else if( ob_is_string(label) ){
+			n_strings++;
+		}
+		else{
+			return table;
+		}
+	}
+
+	if( n_ints && n_strings ){
+		return table;
+	}
+	else if( n_ints ){
+		table->kind = skInteger;
+		/*
+		 * Dense labels, use a jump table.
+		 */
+		if( (unsigned long)(max - min) < n_ints * VM_SWITCH_MAX_HOLES ){
+			table->base = min;
+			table->jumps.resize( max - min + 1, H_UNDEFINED );
+		}
+	}
+	else if( n_strings ){
+		table->kind = skString;
+	}
+	/*
+	 * Map the labels, if a label is used more than once only its first
+	 * case is mapped, since that's the one a linear lookup would find.
+	 */
+	for( i = 0; i < node->children.items; i += 2 ){
+		case_node = node->child(i);
+		stmt_node = node->child(i + 1);
+
+		if( case_node == H_UNDEFINED || stmt_node == H_UNDEFINED ){
+			continue;
+		}
+
+		label = case_node->value.constant;
+		if( table->kind == skString ){
+			char *svalue = (char *)ob_string_ucast(label)->value.c_str();
+
+			if( table->svalues.find(svalue) == H_UNDEFINED ){
+				table->svalues.insert( svalue, stmt_node );
+			}
+		}
+		else if( table->jumps.size() ){
+			value = ob_ivalue(label) - table->base;
+			if( table->jumps[value] == H_UNDEFINED ){
+				table->jumps[value] = stmt_node;
+			}
+		}
+		else{
+			table->ivalues.insert( std::make_pair( ob_ivalue(label), stmt_node ) );
+		}
+	}
+
+	return table;
+}
+
 INLINE Object *vm_exec_switch( vm_t *vm, vframe_t *frame, Node *node){
-	ll_item_t *stmt_item,
-			  *case_item;
-    Node   *case_node = H_UNDEFINED,
-           *stmt_node = H_UNDEFINED;
-    Object *target    = H_UNDEFINED,
-           *compare   = H_UNDEFINED,
-           *result    = H_UNDEFINED;
+	size_t			i;
+    Node   		   *case_node = H_UNDEFINED,
+           		   *stmt_node = H_UNDEFINED;
+    Object 		   *target    = H_UNDEFINED,
+           		   *compare   = H_UNDEFINED,
+           		   *result    = H_UNDEFINED;
+    switch_table_t *table;
+    long			value;
 
     target = vm_exec( vm, frame, node->value.switch_block );
 
-    // exec case labels
-    for( case_item = node->children.head; case_item; case_item = case_item->next->next ){
-    	stmt_item = case_item->next;
+    /*
+     * Build the lookup table the first time this switch is executed.
+     */
+    if( (table = node->value.switch_table) == H_UNDEFINED ){
+    	vm_switch_lock( vm );
+    	if( (table = node->value.switch_table) == H_UNDEFINED ){
+    		table = node->value.switch_table = vm_compile_switch( node );
+    	}
+    	vm_switch_unlock( vm );
+    }
+
+    if( table->kind == skInteger && (ob_is_int(target) || ob_is_char(target)) ){
+    	value = ob_ivalue(target);
+
+    	if( table->jumps.size() ){
+    		value -= table->base;
+    		if( value >= 0 && (unsigned long)value < table->jumps.size() ){
+    			stmt_node = table->jumps[value];
+    		}
+    	}
+    	else{
+    		map<long, Node *>::iterator i = table->ivalues.find(value);
+    		if( i != table->ivalues.end() ){
+    			stmt_node = i->second;
+    		}
+    	}
 
-        stmt_node = ll_node( stmt_item );
-        case_node = ll_node( case_item );
+    	if( stmt_node != H_UNDEFINED ){
+    		return vm_exec( vm, frame, stmt_node );
+    	}
+    }
+    else if( table->kind == skString && ob_is_string(target) ){
+    	if( (stmt_node = table->svalues.find( (char *)ob_string_ucast(target)->value.c_str() )) != H_UNDEFINED ){
+    		return vm_exec( vm, frame, stmt_node );
+    	}
+    }
+    else{
+		// exec case labels
+		for( i = 0; i < node->children.items; i += 2 ){
+			case_node = node->child(i);
+			stmt_node = node->child(i + 1);
 
-        if( case_node != H_UNDEFINED && stmt_node != H_UNDEFINED ){
-            compare = vm_exec( vm, frame, case_node );
+			if( case_node != H_UNDEFINED && stmt_node != H_UNDEFINED ){
+				compare = vm_exec( vm, frame, case_node );
 
-            vm_check_frame_exit(frame)
+				vm_check_frame_exit(frame)
 
-            if( ob_cmp( target, compare ) == 0 ){
-                return vm_exec( vm, frame, stmt_node );
-            }
-        }
+				if( ob_cmp( target, compare ) == 0 ){
+					return vm_exec( vm, frame, stmt_node );
+				}
+			}
+		}
     }
 
     // exec default case
@@ -2291,7 +3409,6 @@ INLINE Object *vm_exec_switch( vm_t *vm, vframe_t *frame, Node *node){
 }
 
 INLINE Object *vm_exec_explode( vm_t *vm, vframe_t *frame, Node *node ){
-	ll_item_t *llitem;
 	Node   *expr  = H_UNDEFINED,
 		   *lexp  = H_UNDEFINED;
 	Object *value = H_UNDEFINED,
@@ -2308,8 +3425,8 @@ INLINE Object *vm_exec_explode( vm_t *vm, vframe_t *frame, Node *node ){
 	/*
 	 * Initialize all the items with a <false>.
 	 */
-	for( llitem = node->children.head->next; llitem; llitem = llitem->next ){
-		lexp = ll_node(llitem);
+	for( i = 1; i <= n_ids; ++i ){
+		lexp = node->child(i);
 
 		/*
 		 * If the first child is an identifier, we are just defining
@@ -2331,7 +3448,7 @@ INLINE Object *vm_exec_explode( vm_t *vm, vframe_t *frame, Node *node ){
 				 *owner     = member->value.owner,
 				 *attribute = member->value.member;
 
-			Object *obj = vm_exec( vm, frame, owner );
+			Object *obj = vm_exec_lvalue( vm, frame, owner );
 
 			vm_check_frame_exit(frame)
 
@@ -2344,9 +3461,9 @@ INLINE Object *vm_exec_explode( vm_t *vm, vframe_t *frame, Node *node ){
 	 * the rest of them to <false>.
 	 */
 	Integer index(0);
-	for( llitem = node->children.head->next; (unsigned)index.value < n_end; ++index.value, llitem = llitem->next ){
+	for( i = 1; (unsigned)index.value < n_end; ++index.value, ++i ){
 		item = ob_cl_at( value, (Object *)&index );
-		lexp = ll_node(llitem);
+		lexp = node->child(i);
 		/*
 		 * Same as before.
 		 */
@@ -2358,7 +3475,7 @@ INLINE Object *vm_exec_explode( vm_t *vm, vframe_t *frame, Node *node ){
 				 *owner     = member->value.owner,
 				 *attribute = member->value.member;
 
-			Object *obj = vm_exec( vm, frame, owner );
+			Object *obj = vm_exec_lvalue( vm, frame, owner );
 
 			vm_check_frame_exit(frame)
 
@@ -2396,6 +3513,12 @@ INLINE Object *vm_exec_try_catch( vm_t *vm, vframe_t *frame, Node *node ){
 		   *catch_body   = node->value.catch_block,
 		   *finally_body = node->value.finally_block;
 	Object *exception    = H_UNDEFINED;
+	bool	tail_calls   = frame->tail_calls;
+	/*
+	 * Calls inside a try statement are not tail calls, their exceptions
+	 * have to be caught here and the finally block executed after them.
+	 */
+	frame->tail_calls = false;
 
 	vm_exec( vm, frame, main_body );
 
@@ -2404,7 +3527,7 @@ INLINE Object *vm_exec_try_catch( vm_t *vm, vframe_t *frame, Node *node ){
 
 		assert( exception != H_UNDEFINED );
 
-		frame->add( (char *)node->value.exception_id.c_str(), exception );
+		frame->add( (char *)node->value.identifier.c_str(), exception );
 
 		frame->state.unset(Exception);
 
@@ -2415,6 +3538,8 @@ INLINE Object *vm_exec_try_catch( vm_t *vm, vframe_t *frame, Node *node ){
 		vm_exec( vm, frame, finally_body );
 	}
 
+	frame->tail_calls = tail_calls;
+
 	return H_DEFAULT_RETURN;
 }
 
@@ -2434,8 +3559,8 @@ INLINE Object *vm_exec_array( vm_t *vm, vframe_t *frame, Node *node ){
 	Object *v = (Object *)gc_new_vector(),
 		   *o;
 
-	ll_foreach( &node->children, llitem ){
-		o = vm_exec( vm, frame, ll_node( llitem ) );
+	for( size_t ci = 0; ci < node->children.items; ++ci ){
+		o = vm_exec( vm, frame, node->child(ci) );
 		if( o->referenced ){
 			ob_cl_push( v, o );
 		}
@@ -2449,17 +3574,15 @@ INLINE Object *vm_exec_array( vm_t *vm, vframe_t *frame, Node *node ){
 }
 
 INLINE Object *vm_exec_map( vm_t *vm, vframe_t *frame, Node *node ){
-	ll_item_t *key,
-			  *val;
+	size_t 	   i;
 	Object 	  *m = (Object *)gc_new_map(),
 			  *k,
 			  *v;
 
 
-	for( key = node->children.head; key; key= key->next ){
-		val = key->next;
-		k   = vm_exec( vm, frame, ll_node(key) );
-		v   = vm_exec( vm, frame, ll_node(val) );
+	for( i = 0; i < node->children.items; i += 2 ){
+		k   = vm_exec( vm, frame, node->child(i) );
+		v   = vm_exec( vm, frame, node->child(i + 1) );
 
 		if( v->referenced ){
 			ob_cl_set( m, k, v );
@@ -2468,11 +3591,6 @@ INLINE Object *vm_exec_map( vm_t *vm, vframe_t *frame, Node *node ){
 			v->referenced = true;
 			ob_cl_set_reference( m, k, v );
 		}
-
-		/*
-		 * key += 2
-		 */
-		key = key->next;
 	}
 
 	return m;
@@ -2518,18 +3636,18 @@ INLINE Object *vm_exec_assign( vm_t *vm, vframe_t *frame, Node *node ){
 			 *owner     = member->value.owner,
 			 *attribute = member->value.member;
 
-    	Object *obj = vm_exec( vm, frame, owner ),
+    	Object *obj = vm_exec_lvalue( vm, frame, owner ),
     		   *value;
 
     	vm_check_frame_exit(frame)
     	/*
     	 * Prevent obj from being garbage collected.
     	 */
-    	frame->push_tmp(obj);
+    	size_t root = frame->push_tmp(obj);
 
 		value = vm_exec( vm, frame, node->child(1) );
 
-		frame->remove_tmp(obj);
+		frame->pop_tmp(root);
 
     	vm_check_frame_exit(frame)
 
@@ -2576,6 +3694,20 @@ INLINE Object *vm_exec_regex( vm_t *vm, vframe_t *frame, Node *node ){
 	return result;
 }
 
+/*
+ * Inline fast paths for binary operators when both operands are integers
+ * or floats, they give the same results of the int_* and float_* operators
+ * without any function call, other operands go through ob_dispatch.
+ */
+#define vm_int_fast_path( a, op, b ) \
+	if( a->type == &Integer_Type && b->type == &Integer_Type ){ \
+		return (Object *)gc_new_integer( (ob_int_ucast(a))->value op (ob_int_ucast(b))->value ); \
+	}
+#define vm_float_fast_path( a, op, b ) \
+	if( a->type == &Float_Type && b->type == &Float_Type ){ \
+		return (Object *)gc_new_float( ob_float_ucast(a)->value op ob_float_ucast(b)->value ); \
+	}
+
 INLINE Object *vm_exec_add( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED,
@@ -2586,7 +3718,10 @@ INLINE Object *vm_exec_add( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_add( a, b );
+	vm_int_fast_path( a, +, b )
+	vm_float_fast_path( a, +, b )
+
+	c = ob_dispatch( opAdd, a, b );
 
 	return c;
 }
@@ -2595,7 +3730,7 @@ INLINE Object *vm_exec_inplace_add( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2615,7 +3750,10 @@ INLINE Object *vm_exec_sub( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_sub( a, b );
+	vm_int_fast_path( a, -, b )
+	vm_float_fast_path( a, -, b )
+
+	c = ob_dispatch( opSub, a, b );
 
 	return c;
 }
@@ -2624,7 +3762,7 @@ INLINE Object *vm_exec_inplace_sub( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2644,7 +3782,10 @@ INLINE Object *vm_exec_mul( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_mul( a, b );
+	vm_int_fast_path( a, *, b )
+	vm_float_fast_path( a, *, b )
+
+	c = ob_dispatch( opMul, a, b );
 
 	return c;
 }
@@ -2653,7 +3794,7 @@ INLINE Object *vm_exec_inplace_mul( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2673,7 +3814,10 @@ INLINE Object *vm_exec_div( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_div( a, b );
+	vm_int_fast_path( a, /, b )
+	vm_float_fast_path( a, /, b )
+
+	c = ob_dispatch( opDiv, a, b );
 
 	return c;
 }
@@ -2682,7 +3826,7 @@ INLINE Object *vm_exec_inplace_div( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2702,7 +3846,7 @@ INLINE Object *vm_exec_mod( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_mod( a, b );
+	c = ob_dispatch( opMod, a, b );
 
 	return c;
 }
@@ -2711,7 +3855,7 @@ INLINE Object *vm_exec_inplace_mod( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2724,7 +3868,7 @@ INLINE Object *vm_exec_inplace_mod( vm_t *vm, vframe_t *frame, Node *node ){
 INLINE Object *vm_exec_inc( vm_t *vm, vframe_t *frame, Node *node ){
     Object *o = H_UNDEFINED;
 
-    o = vm_exec( vm, frame, node->child(0) );
+    o = vm_exec_lvalue( vm, frame, node->child(0) );
 
 	vm_check_frame_exit(frame)
 
@@ -2734,7 +3878,7 @@ INLINE Object *vm_exec_inc( vm_t *vm, vframe_t *frame, Node *node ){
 INLINE Object *vm_exec_dec( vm_t *vm, vframe_t *frame, Node *node ){
     Object *o = H_UNDEFINED;
 
-    o = vm_exec( vm, frame, node->child(0) );
+    o = vm_exec_lvalue( vm, frame, node->child(0) );
 
 	vm_check_frame_exit(frame)
 
@@ -2751,7 +3895,9 @@ INLINE Object *vm_exec_xor( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_bw_xor( a, b );
+	vm_int_fast_path( a, ^, b )
+
+	c = ob_dispatch( opBwXor, a, b );
 
 	return c;
 }
@@ -2760,7 +3906,7 @@ INLINE Object *vm_exec_inplace_xor( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2780,7 +3926,9 @@ INLINE Object *vm_exec_and( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_bw_and( a, b );
+	vm_int_fast_path( a, &, b )
+
+	c = ob_dispatch( opBwAnd, a, b );
 
 	return c;
 }
@@ -2789,7 +3937,7 @@ INLINE Object *vm_exec_inplace_and( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2809,7 +3957,9 @@ INLINE Object *vm_exec_or( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_bw_or( a, b );
+	vm_int_fast_path( a, |, b )
+
+	c = ob_dispatch( opBwOr, a, b );
 
 	return c;
 }
@@ -2818,7 +3968,7 @@ INLINE Object *vm_exec_inplace_or( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2838,7 +3988,9 @@ INLINE Object *vm_exec_shiftl( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_bw_lshift( a, b );
+	vm_int_fast_path( a, <<, b )
+
+	c = ob_dispatch( opBwLshift, a, b );
 
 	return c;
 }
@@ -2847,7 +3999,7 @@ INLINE Object *vm_exec_inplace_shiftl( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2867,7 +4019,9 @@ INLINE Object *vm_exec_shiftr( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_bw_rshift( a, b );
+	vm_int_fast_path( a, >>, b )
+
+	c = ob_dispatch( opBwRshift, a, b );
 
 	return c;
 }
@@ -2876,7 +4030,7 @@ INLINE Object *vm_exec_inplace_shiftr( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED;
 
-    a = vm_exec( vm, frame, node->child(0) );
+    a = vm_exec_lvalue( vm, frame, node->child(0) );
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -2935,7 +4089,10 @@ INLINE Object *vm_exec_less( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_l_less( a, b );
+	vm_int_fast_path( a, <, b )
+	vm_float_fast_path( a, <, b )
+
+	c = ob_dispatch( opLLess, a, b );
 
 	return c;
 }
@@ -2950,7 +4107,10 @@ INLINE Object *vm_exec_greater( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_l_greater( a, b );
+	vm_int_fast_path( a, >, b )
+	vm_float_fast_path( a, >, b )
+
+	c = ob_dispatch( opLGreater, a, b );
 
 	return c;
 }
@@ -2965,7 +4125,10 @@ INLINE Object *vm_exec_ge( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_l_greater_or_same( a, b );
+	vm_int_fast_path( a, >=, b )
+	vm_float_fast_path( a, >=, b )
+
+	c = ob_dispatch( opLGreaterOrSame, a, b );
 
 	return c;
 }
@@ -2980,7 +4143,10 @@ INLINE Object *vm_exec_le( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_l_less_or_same( a, b );
+	vm_int_fast_path( a, <=, b )
+	vm_float_fast_path( a, <=, b )
+
+	c = ob_dispatch( opLLessOrSame, a, b );
 
 	return c;
 }
@@ -2995,7 +4161,10 @@ INLINE Object *vm_exec_ne( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_l_diff( a, b );
+	vm_int_fast_path( a, !=, b )
+	vm_float_fast_path( a, !=, b )
+
+	c = ob_dispatch( opLDiff, a, b );
 
 	return c;
 }
@@ -3010,17 +4179,43 @@ INLINE Object *vm_exec_eq( vm_t *vm, vframe_t *frame, Node *node ){
 
 	vm_check_frame_exit(frame)
 
-	c = ob_l_same( a, b );
+	vm_int_fast_path( a, ==, b )
+	vm_float_fast_path( a, ==, b )
+
+	c = ob_dispatch( opLSame, a, b );
 
 	return c;
 }
 
+/*
+ * Tell if a logical operator can skip its right operand once the left
+ * one is known, that is if it's not a class (or a reference to a class)
+ * instance that could overload the operator and use the right operand.
+ */
+INLINE bool vm_can_short_circuit( Object *o ){
+	while( ob_is_reference(o) && ob_ref_ucast(o)->value != NULL ){
+		o = ob_ref_ucast(o)->value;
+	}
+	return !ob_is_class(o);
+}
+
 INLINE Object *vm_exec_land( vm_t *vm, vframe_t *frame, Node *node ){
     Object *a = H_UNDEFINED,
            *b = H_UNDEFINED,
            *c = H_UNDEFINED;
 
     a = vm_exec( vm, frame, node->child(0) );
+
+    vm_check_frame_exit(frame)
+    /*
+     * If 'a' is false the right operand is not evaluated, the result
+     * is computed as 'a && a' so it has the same type the operator
+     * returns for 'a'.
+     */
+    if( vm_can_short_circuit(a) && !ob_lvalue(a) ){
+    	return ob_l_and( a, a );
+    }
+
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -3036,6 +4231,15 @@ INLINE Object *vm_exec_lor( vm_t *vm, vframe_t *frame, Node *node ){
            *c = H_UNDEFINED;
 
     a = vm_exec( vm, frame, node->child(0) );
+
+    vm_check_frame_exit(frame)
+    /*
+     * Same as above, if 'a' is true the result is 'a || a'.
+     */
+    if( vm_can_short_circuit(a) && ob_lvalue(a) ){
+		return ob_l_or( a, a );
+	}
+
 	b = vm_exec( vm, frame, node->child(1) );
 
 	vm_check_frame_exit(frame)
@@ -56,7 +56,7 @@ typedef struct {
 }
 dll_arg_t;
 
-byte *binary_serialize( Object *o ){
+static byte *binary_serialize( Object *o ){
     size_t i, size( ob_get_size(o) );
     byte *buffer = new byte[ size ];
 
@@ -31,7 +31,7 @@ HYBRIS_DEFINE_FUNCTION(hbinary){
 	vector<unsigned char> stream;
 	unsigned int          i;
 
-	for( i = 0; i < data->size(); ++i ){
+	for( i = 0; i < vm_argc(); ++i ){
 		ob_argv_types_assert( i, otInteger, otChar, "binary" );
 		stream.push_back( (unsigned char)ob_ivalue( vm_argv(i) ) );
 	}
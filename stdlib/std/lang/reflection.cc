@@ -123,8 +123,10 @@ HYBRIS_DEFINE_FUNCTION(hmethods){
 
 	vm_parse_argv( "C", &co );
 
-	itree_foreach( class_method_t, i, co->c_methods ){
-		ob_cl_push_reference( vo, (Object *)gc_new_string( (*i)->label.c_str() ) );
+	if( co->c_methods != NULL ){
+		itree_foreach( class_method_t, i, *co->c_methods ){
+			ob_cl_push_reference( vo, (Object *)gc_new_string( (*i)->label.c_str() ) );
+		}
 	}
 
 	return vo;
@@ -34,6 +34,8 @@ HYBRIS_DEFINE_FUNCTION(htypeof);
 HYBRIS_DEFINE_FUNCTION(hsizeof);
 HYBRIS_DEFINE_FUNCTION(htoint);
 HYBRIS_DEFINE_FUNCTION(htostring);
+HYBRIS_DEFINE_FUNCTION(hintarray);
+HYBRIS_DEFINE_FUNCTION(hfloatarray);
 HYBRIS_DEFINE_FUNCTION(hfromxml);
 HYBRIS_DEFINE_FUNCTION(htoxml);
 
@@ -49,6 +51,8 @@ HYBRIS_EXPORTED_FUNCTIONS() {
 	{ "sizeof",   hsizeof,   H_REQ_ARGC(1), { H_ANY_TYPE } },
 	{ "toint",    htoint,    H_REQ_ARGC(1), { H_ANY_TYPE } },
 	{ "tostring", htostring, H_REQ_ARGC(1), { H_ANY_TYPE } },
+	{ "intarray",   hintarray,   H_REQ_ARGC(1), { H_REQ_TYPES(otInteger,otVector,otIntArray,otFloatArray) } },
+	{ "floatarray", hfloatarray, H_REQ_ARGC(1), { H_REQ_TYPES(otInteger,otVector,otIntArray,otFloatArray) } },
 	{ "fromxml",  hfromxml,  H_REQ_ARGC(1), { H_REQ_TYPES(otString) } },
 	{ "toxml",    htoxml,    H_REQ_ARGC(1), { H_ANY_TYPE } },
 	{ "", NULL }
@@ -141,6 +145,43 @@ HYBRIS_DEFINE_FUNCTION(htostring){
 
 	return ob_to_string(o);
 }
+/*
+ * intarray( size | collection ) and floatarray( size | collection ) create
+ * a zero filled typed array of the given size or convert a collection.
+ */
+HYBRIS_DEFINE_FUNCTION(hintarray){
+	Object *o;
+
+	vm_parse_argv( "O", &o );
+
+	if( ob_is_int(o) ){
+		IntArray *array = gc_new_intarray();
+
+		array->value.resize( ob_int_val(o) > 0 ? ob_int_val(o) : 0, 0 );
+		array->items = array->value.size();
+
+		return ob_dcast(array);
+	}
+
+	return intarray_from_collection(o);
+}
+
+HYBRIS_DEFINE_FUNCTION(hfloatarray){
+	Object *o;
+
+	vm_parse_argv( "O", &o );
+
+	if( ob_is_int(o) ){
+		FloatArray *array = gc_new_floatarray();
+
+		array->value.resize( ob_int_val(o) > 0 ? ob_int_val(o) : 0, 0.0 );
+		array->items = array->value.size();
+
+		return ob_dcast(array);
+	}
+
+	return floatarray_from_collection(o);
+}
 
 /* xml conversion routines */
 unsigned int htoi( const char *ptr ){
@@ -18,17 +18,28 @@
 */
 #include <hybris.h>
 #include <errno.h>
+#include <deque>
+
+using std::deque;
 
 HYBRIS_DEFINE_FUNCTION(hpthread_create);
 HYBRIS_DEFINE_FUNCTION(hpthread_exit);
 HYBRIS_DEFINE_FUNCTION(hpthread_join);
 HYBRIS_DEFINE_FUNCTION(hpthread_kill);
+HYBRIS_DEFINE_FUNCTION(hpool_create);
+HYBRIS_DEFINE_FUNCTION(hpool_submit);
+HYBRIS_DEFINE_FUNCTION(hpool_wait);
+HYBRIS_DEFINE_FUNCTION(hpool_destroy);
 
 HYBRIS_EXPORTED_FUNCTIONS() {
 	{ "pthread_create",      hpthread_create, H_REQ_ARGC(1,2), { H_REQ_TYPES(otString), H_REQ_TYPES(otVector) } },
 	{ "pthread_exit", 		 hpthread_exit,   H_NO_ARGS },
 	{ "pthread_join", 		 hpthread_join,   H_REQ_ARGC(1),   { H_REQ_TYPES(otInteger) } },
 	{ "pthread_kill", 		 hpthread_kill,   H_REQ_ARGC(2),   { H_REQ_TYPES(otInteger), H_REQ_TYPES(otInteger) } },
+	{ "pool_create",         hpool_create,    H_REQ_ARGC(1,2), { H_REQ_TYPES(otInteger), H_REQ_TYPES(otInteger) } },
+	{ "pool_submit",         hpool_submit,    H_REQ_ARGC(2,3), { H_REQ_TYPES(otHandle), H_REQ_TYPES(otString), H_REQ_TYPES(otVector) } },
+	{ "pool_wait",           hpool_wait,      H_REQ_ARGC(1),   { H_REQ_TYPES(otHandle) } },
+	{ "pool_destroy",        hpool_destroy,   H_REQ_ARGC(1),   { H_REQ_TYPES(otHandle) } },
 	{ "", NULL }
 };
 
@@ -38,9 +49,54 @@ typedef struct {
     vm_t   *vm;
 }
 thread_args_t;
+/*
+ * A pool of worker threads executing the submitted functions, so that
+ * a task does not cost the creation of a thread and of its vm scope.
+ *
+ * Each worker scope holds the 'pending' frame, with the arguments of
+ * the queued tasks so the gc marks them, and the worker own 'frame',
+ * where the arguments of the task it's running are moved.
+ */
+typedef struct _pool_task {
+	string function;
+	/* its arguments are the first 'argc' values of the pending frame */
+	size_t argc;
+}
+pool_task_t;
+
+typedef struct _pool_worker {
+	struct _thread_pool *pool;
+	pthread_t			 tid;
+	vmem_t				 frame;
+}
+pool_worker_t;
+
+typedef struct _thread_pool {
+	vm_t 				   *vm;
+	vector<pool_worker_t *> workers;
+	deque<pool_task_t>		tasks;
+	vmem_t					pending;
+	/* maximum number of queued tasks, 0 if unbounded */
+	size_t					max_tasks;
+	/* number of tasks being executed */
+	size_t					active;
+	bool					stopping;
+	pthread_mutex_t			mutex;
+	/* a task was queued or the pool is stopping */
+	pthread_cond_t			ready;
+	/* a task was dequeued */
+	pthread_cond_t			room;
+	/* no queued nor running tasks */
+	pthread_cond_t			idle;
+}
+thread_pool_t;
 
 void * hyb_pthread_worker( void *arg ){
 	thread_args_t *args = (thread_args_t *)arg;
+	/*
+	 * Objects allocated by this thread belong to the vm heap.
+	 */
+	vm_set_current( args->vm );
 	/*
 	 * This will cause the thread to wait until the main process
 	 * finishes its job and releases the mutex.
@@ -60,6 +116,85 @@ void * hyb_pthread_worker( void *arg ){
     pthread_exit(NULL);
 }
 
+void * hyb_pool_worker( void *arg ){
+	pool_worker_t *worker = (pool_worker_t *)arg;
+	thread_pool_t *pool   = worker->pool;
+	vm_t		  *vm	  = pool->vm;
+	pool_task_t	   task;
+	size_t		   i;
+
+	vm_set_current( vm );
+	/*
+	 * Wait for the scope of this thread to be created.
+	 */
+	vm_tsync_lock( vm );
+	vm_tsync_unlock( vm );
+
+	for(;;){
+		pthread_mutex_lock( &pool->mutex );
+
+		while( pool->tasks.empty() && pool->stopping == false ){
+			pthread_cond_wait( &pool->ready, &pool->mutex );
+		}
+		/*
+		 * Stopping, and every queued task was executed.
+		 */
+		if( pool->tasks.empty() ){
+			pthread_mutex_unlock( &pool->mutex );
+			break;
+		}
+
+		task = pool->tasks.front();
+		pool->tasks.pop_front();
+		pool->active++;
+		/*
+		 * Move the task arguments to the worker frame, in the meanwhile
+		 * the gc could be marking them from another thread.
+		 */
+		vm_mm_lock( vm );
+		for( i = 0; i < task.argc; ++i ){
+			worker->frame.push( pool->pending.argv(i) );
+		}
+		pool->pending.args.erase( pool->pending.args.begin(), pool->pending.args.begin() + task.argc );
+		vm_mm_unlock( vm );
+
+		pthread_cond_signal( &pool->room );
+		pthread_mutex_unlock( &pool->mutex );
+
+		vm_exec_threaded_call( vm, task.function, &worker->frame );
+
+		vm_mm_lock( vm );
+		worker->frame.release();
+		worker->frame.state.reset();
+		vm_mm_unlock( vm );
+
+		pthread_mutex_lock( &pool->mutex );
+		if( --pool->active == 0 && pool->tasks.empty() ){
+			pthread_cond_broadcast( &pool->idle );
+		}
+		pthread_mutex_unlock( &pool->mutex );
+	}
+
+	vm_depool( vm );
+
+	return NULL;
+}
+
+void hyb_pool_free( thread_pool_t *pool ){
+	size_t i;
+
+	for( i = 0; i < pool->workers.size(); ++i ){
+		delete pool->workers[i];
+	}
+
+	pthread_mutex_destroy( &pool->mutex );
+	pthread_cond_destroy( &pool->ready );
+	pthread_cond_destroy( &pool->room );
+	pthread_cond_destroy( &pool->idle );
+
+	delete pool;
+}
+
 HYBRIS_DEFINE_FUNCTION(hpthread_create){
 	Vector    *thread_argv = NULL;
 	pthread_t tid;
@@ -172,3 +307,165 @@ HYBRIS_DEFINE_FUNCTION(hpthread_kill){
 	}
 }
 
+HYBRIS_DEFINE_FUNCTION(hpool_create){
+	long		   size,
+				   max_tasks = 0;
+	thread_pool_t *pool;
+	pool_worker_t *worker;
+	vm_scope_t	  *scope;
+	int			   code;
+
+	vm_parse_argv( "ll", &size, &max_tasks );
+
+	if( size <= 0 || max_tasks < 0 ){
+		hyb_error( H_ET_WARNING, "Invalid thread pool size" );
+		return H_DEFAULT_ERROR;
+	}
+
+	pool = new thread_pool_t;
+
+	pool->vm		= vm;
+	pool->max_tasks = max_tasks;
+	pool->active	= 0;
+	pool->stopping	= false;
+
+	pthread_mutex_init( &pool->mutex, NULL );
+	pthread_cond_init( &pool->ready, NULL );
+	pthread_cond_init( &pool->room, NULL );
+	pthread_cond_init( &pool->idle, NULL );
+	/*
+	 * Workers are not going to start until their scopes are ready.
+	 */
+	vm_tsync_lock(vm);
+
+	while( size-- ){
+		worker 		 = new pool_worker_t;
+		worker->pool = pool;
+
+		if( (code = pthread_create( &worker->tid, NULL, hyb_pool_worker, (void *)worker )) != 0 ){
+			delete worker;
+			hyb_error( H_ET_WARNING, "Could not create a thread pool worker (error %d)", code );
+			break;
+		}
+
+		scope = vm_pool( vm, worker->tid );
+
+		ll_append( scope, &pool->pending );
+		ll_append( scope, &worker->frame );
+
+		pool->workers.push_back( worker );
+	}
+
+	vm_tsync_unlock(vm);
+
+	if( pool->workers.empty() ){
+		hyb_pool_free( pool );
+		return H_DEFAULT_ERROR;
+	}
+
+	return ob_dcast( gc_new_handle(pool) );
+}
+
+HYBRIS_DEFINE_FUNCTION(hpool_submit){
+	Handle		  *handle;
+	Vector		  *task_argv = NULL;
+	thread_pool_t *pool;
+	pool_task_t	   task;
+	vector<Object *> items;
+	Integer 	   index(0);
+	size_t		   i;
+
+	vm_parse_argv( "HsV", &handle, &task.function, &task_argv );
+
+	if( (pool = (thread_pool_t *)handle->value) == NULL ){
+		hyb_error( H_ET_WARNING, "Thread pool already destroyed" );
+		return H_DEFAULT_ERROR;
+	}
+	/*
+	 * Better to fail here than inside a worker.
+	 */
+	if( vm->vcode.get( (char *)task.function.c_str() ) == H_UNDEFINED ){
+		hyb_error( H_ET_SYNTAX, "'%s' undeclared user function identifier", task.function.c_str() );
+	}
+
+	task.argc = (task_argv ? ob_get_size( (Object *)task_argv ) : 0);
+
+	for( ; index.value < (long)task.argc; ++index.value ){
+		items.push_back( ob_cl_at( (Object *)task_argv, (Object *)&index ) );
+	}
+
+	pthread_mutex_lock( &pool->mutex );
+	/*
+	 * Bounded queue, wait for a worker to dequeue a task.
+	 */
+	while( pool->max_tasks && pool->tasks.size() >= pool->max_tasks && pool->stopping == false ){
+		pthread_cond_wait( &pool->room, &pool->mutex );
+	}
+
+	if( pool->stopping ){
+		pthread_mutex_unlock( &pool->mutex );
+		return H_DEFAULT_ERROR;
+	}
+
+	vm_mm_lock( vm );
+	for( i = 0; i < items.size(); ++i ){
+		pool->pending.push( items[i] );
+	}
+	vm_mm_unlock( vm );
+
+	pool->tasks.push_back( task );
+
+	pthread_cond_signal( &pool->ready );
+	pthread_mutex_unlock( &pool->mutex );
+
+	return H_DEFAULT_RETURN;
+}
+
+HYBRIS_DEFINE_FUNCTION(hpool_wait){
+	Handle		  *handle;
+	thread_pool_t *pool;
+
+	vm_parse_argv( "H", &handle );
+
+	if( (pool = (thread_pool_t *)handle->value) == NULL ){
+		return H_DEFAULT_ERROR;
+	}
+
+	pthread_mutex_lock( &pool->mutex );
+	while( pool->active || pool->tasks.empty() == false ){
+		pthread_cond_wait( &pool->idle, &pool->mutex );
+	}
+	pthread_mutex_unlock( &pool->mutex );
+
+	return H_DEFAULT_RETURN;
+}
+
+HYBRIS_DEFINE_FUNCTION(hpool_destroy){
+	Handle		  *handle;
+	thread_pool_t *pool;
+	size_t		   i;
+
+	vm_parse_argv( "H", &handle );
+
+	if( (pool = (thread_pool_t *)handle->value) == NULL ){
+		return H_DEFAULT_ERROR;
+	}
+	/*
+	 * Workers execute the tasks still queued and exit.
+	 */
+	pthread_mutex_lock( &pool->mutex );
+	pool->stopping = true;
+	pthread_cond_broadcast( &pool->ready );
+	pthread_cond_broadcast( &pool->room );
+	pthread_mutex_unlock( &pool->mutex );
+
+	for( i = 0; i < pool->workers.size(); ++i ){
+		pthread_join( pool->workers[i]->tid, NULL );
+	}
+
+	hyb_pool_free( pool );
+
+	handle->value = NULL;
+
+	return H_DEFAULT_RETURN;
+}